@@ -0,0 +1,436 @@
+/**
+ * @file QtPdfViewBench.cpp
+ * @brief QBENCHMARK suite for the viewer's hot paths.
+ *
+ * Covers document open, SelectablePdfView coordinate mapping, hit-testing
+ * and painting, MiniMapWidget marker updates and painting, multi-term
+ * marker collection and thumbnail rendering, both with PageRenderer on the
+ * calling thread and as a round-trip through a DocumentPool (queue, render
+ * on a worker instance, deliver on the GUI thread). Runs under the
+ * offscreen platform so it can be used on headless build machines.
+ *
+ * Usage:
+ * @code
+ *   QtPdfView_bench [--json results.json] [--pdf document.pdf] [QtTest options]
+ * @endcode
+ *
+ * Without --pdf a text fixture is generated with QPdfWriter. With --json the
+ * results are also written as JSON (one entry per function and data tag,
+ * values per iteration).
+ */
+
+#include "MainWindow.h"
+#include "DocumentPool.h"
+#include "FileReadDevice.h"
+#include "MiniMapWidget.h"
+#include "PageRenderer.h"
+#include "SelectablePdfView.h"
+
+#include <QApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFont>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QPdfDocument>
+#include <QPdfWriter>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <QtTest>
+#include <memory>
+
+namespace {
+constexpr int kFixturePages = 120;
+constexpr int kFixtureLines = 48;
+constexpr int kLoadTimeoutMs = 60000;
+constexpr int kThumbnailRenderPx = 440;  // Same size as MainWindow thumbnails
+constexpr int kThumbnailPages = 16;
+
+const char* const kWords[] = {
+    "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+    "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "labore",
+    "alpha", "beta", "gamma", "invoice", "contract", "delivery"
+};
+
+bool writeFixturePdf(const QString& path)
+{
+    QPdfWriter writer(path);
+    writer.setPageSize(QPageSize(QPageSize::A4));
+    writer.setResolution(72);
+    QPainter painter;
+    if (!painter.begin(&writer))
+        return false;
+
+    QFont font(QStringLiteral("Sans Serif"));
+    font.setPixelSize(11);
+    painter.setFont(font);
+
+    // Deterministic text so results are comparable between runs
+    QRandomGenerator rng(20240601);
+    const int wordCount = int(sizeof(kWords) / sizeof(kWords[0]));
+    for (int page = 0; page < kFixturePages; ++page) {
+        if (page > 0)
+            writer.newPage();
+        for (int line = 0; line < kFixtureLines; ++line) {
+            QString text = QStringLiteral("%1.%2 ").arg(page + 1).arg(line + 1);
+            for (int w = 0; w < 12; ++w)
+                text += QLatin1String(kWords[rng.bounded(wordCount)]) + QLatin1Char(' ');
+            painter.drawText(QPointF(48, 60 + line * 15), text);
+        }
+    }
+    return painter.end();
+}
+
+bool waitForLoaded(const QPdfDocument& doc)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while (doc.status() == QPdfDocument::Status::Loading && timer.elapsed() < kLoadTimeoutMs)
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+    return doc.status() == QPdfDocument::Status::Ready;
+}
+
+/// Renders @p pages pages on @p pool like MainWindow's thumbnails and waits for all of them
+bool renderOnPool(DocumentPool& pool, int pages, const QSize& size)
+{
+    QObject context;
+    int delivered = 0;
+    bool ok = true;
+    for (int i = 0; i < pages; ++i) {
+        pool.renderPage(i, size, DocumentPool::Priority::Low, &context, [&](const QImage& image){
+            ++delivered;
+            ok = ok && !image.isNull();
+        });
+    }
+    QElapsedTimer timer;
+    timer.start();
+    while (delivered < pages && timer.elapsed() < kLoadTimeoutMs)
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 50);
+    return ok && delivered == pages;
+}
+
+QVector<MiniMapMarker> makeMarkers(int count, int pageCount)
+{
+    QVector<MiniMapMarker> markers;
+    markers.reserve(count);
+    QRandomGenerator rng(count);
+    for (int i = 0; i < count; ++i) {
+        MiniMapMarker m;
+        m.normalizedPos = rng.generateDouble();
+        m.color = QColor(255, 215, 0, 180);
+        m.page = qMin(pageCount - 1, int(m.normalizedPos * pageCount));
+        m.pageRect = QRectF(48, 60, 120, 12);
+        m.label = QStringLiteral("Page %1").arg(m.page + 1);
+        markers.append(m);
+    }
+    return markers;
+}
+}
+
+/**
+ * @class QtPdfViewBench
+ * @brief Benchmarks run by QTest::qExec.
+ */
+class QtPdfViewBench : public QObject {
+    Q_OBJECT
+public:
+    explicit QtPdfViewBench(const QString& pdfPath)
+        : m_pdfPath(pdfPath)
+    {
+    }
+
+private slots:
+    void initTestCase()
+    {
+        if (m_pdfPath.isEmpty()) {
+            QVERIFY(m_fixtureDir.isValid());
+            m_pdfPath = m_fixtureDir.filePath(QStringLiteral("fixture.pdf"));
+            QVERIFY(writeFixturePdf(m_pdfPath));
+        }
+        m_device = std::make_unique<FileReadDevice>(m_pdfPath);
+        QVERIFY(m_device->open(QIODevice::ReadOnly));
+        m_doc = std::make_unique<QPdfDocument>();
+        m_doc->load(m_device.get());
+        QVERIFY(waitForLoaded(*m_doc));
+        QVERIFY(m_doc->pageCount() > 0);
+
+        m_view = std::make_unique<SelectablePdfView>();
+        m_view->setPageMode(QPdfView::PageMode::MultiPage);
+        m_view->setZoomMode(QPdfView::ZoomMode::FitToWidth);
+        m_view->setDocument(m_doc.get());
+        m_view->resize(1000, 800);
+        m_view->show();
+        QVERIFY(QTest::qWaitForWindowExposed(m_view.get()));
+    }
+
+    void cleanupTestCase()
+    {
+        m_view.reset();
+        m_doc.reset();
+        m_device.reset();
+    }
+
+    void documentOpen()
+    {
+        QBENCHMARK {
+            FileReadDevice device(m_pdfPath);
+            QVERIFY(device.open(QIODevice::ReadOnly));
+            QPdfDocument doc;
+            doc.load(&device);
+            QVERIFY(waitForLoaded(doc));
+        }
+    }
+
+    void viewCoordinateMapping()
+    {
+        const int height = m_view->viewport()->height();
+        qreal sink = 0.0;
+        QBENCHMARK {
+            for (int y = 0; y < height; y += 2) {
+                if (const auto docY = m_view->documentPointYForViewportY(y))
+                    sink += *docY;
+            }
+            sink += m_view->totalDocumentPointsHeight();
+        }
+        QVERIFY(sink > 0.0);
+    }
+
+    void viewHitTesting()
+    {
+        // Hover runs the character hit-test used for the text cursor
+        QWidget* viewport = m_view->viewport();
+        const QSize size = viewport->size();
+        QBENCHMARK {
+            for (int y = 8; y < size.height(); y += 40) {
+                for (int x = 8; x < size.width(); x += 40)
+                    QTest::mouseMove(viewport, QPoint(x, y));
+            }
+        }
+    }
+
+    void viewWordSelection()
+    {
+        QWidget* viewport = m_view->viewport();
+        const QPoint center = viewport->rect().center();
+        QBENCHMARK {
+            QTest::mouseDClick(viewport, Qt::LeftButton, Qt::NoModifier, center);
+        }
+        m_view->clearSelection();
+    }
+
+    void viewPaint()
+    {
+        QBENCHMARK {
+            m_view->viewport()->repaint();
+        }
+    }
+
+    void minimapSetMarkers_data()
+    {
+        QTest::addColumn<int>("count");
+        QTest::newRow("1000") << 1000;
+        QTest::newRow("10000") << 10000;
+        QTest::newRow("100000") << 100000;
+    }
+
+    void minimapSetMarkers()
+    {
+        QFETCH(int, count);
+        MiniMapWidget minimap;
+        minimap.setPageHeights(pageHeights());
+        const QVector<MiniMapMarker> markers = makeMarkers(count, m_doc->pageCount());
+        QBENCHMARK {
+            minimap.setMarkers(markers);
+        }
+    }
+
+    void minimapPaint_data()
+    {
+        minimapSetMarkers_data();
+    }
+
+    void minimapPaint()
+    {
+        QFETCH(int, count);
+        MiniMapWidget minimap;
+        minimap.resize(24, 800);
+        minimap.setPageHeights(pageHeights());
+        minimap.setMarkers(makeMarkers(count, m_doc->pageCount()));
+        minimap.setViewportRange(0.1, 0.2);
+        minimap.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&minimap));
+        QBENCHMARK {
+            minimap.repaint();
+        }
+    }
+
+    void multiTermSearch_data()
+    {
+        QTest::addColumn<QString>("terms");
+        QTest::newRow("single") << QStringLiteral("alpha");
+        QTest::newRow("three") << QStringLiteral("alpha;beta;gamma");
+        QTest::newRow("rare") << QStringLiteral("delivery;contract");
+    }
+
+    void multiTermSearch()
+    {
+        QFETCH(QString, terms);
+        MainWindow window;
+        window.resize(1000, 800);
+        QSignalSpy ready(&window, &MainWindow::documentReady);
+        window.openPdf(m_pdfPath);
+        if (window.isLoading())
+            QVERIFY(ready.wait(kLoadTimeoutMs));
+        window.show();
+        QVERIFY(QTest::qWaitForWindowExposed(&window));
+
+        QSignalSpy finished(&window, &MainWindow::multiTermSearchFinished);
+        QBENCHMARK {
+            window.triggerMultiTermSearch(terms);
+            if (window.isMultiTermSearching())
+                QVERIFY(finished.wait(kLoadTimeoutMs));
+        }
+        QVERIFY(window.multiTermMatchCount() >= 0);
+    }
+
+    void thumbnailRender()
+    {
+        const int pages = qMin(kThumbnailPages, m_doc->pageCount());
+        const QSize renderSize(kThumbnailRenderPx, kThumbnailRenderPx);
+        QBENCHMARK {
+            for (int i = 0; i < pages; ++i) {
+                const QImage image = PageRenderer::renderToFit(*m_doc, i, renderSize);
+                QVERIFY(!image.isNull());
+            }
+        }
+    }
+
+    void thumbnailPoolRender()
+    {
+        const int pages = qMin(kThumbnailPages, m_doc->pageCount());
+        const QSize renderSize(kThumbnailRenderPx, kThumbnailRenderPx);
+        DocumentPool pool;
+        pool.open(m_pdfPath);
+        // The first round also parses the file on every instance
+        QVERIFY(renderOnPool(pool, pages, renderSize));
+        QBENCHMARK {
+            QVERIFY(renderOnPool(pool, pages, renderSize));
+        }
+    }
+
+private:
+    QVector<qreal> pageHeights() const
+    {
+        QVector<qreal> heights;
+        const int pageCount = m_doc->pageCount();
+        heights.reserve(pageCount);
+        for (int i = 0; i < pageCount; ++i)
+            heights.append(qMax<qreal>(m_doc->pagePointSize(i).height(), 1.0));
+        return heights;
+    }
+
+    QString m_pdfPath;
+    QTemporaryDir m_fixtureDir;
+    std::unique_ptr<FileReadDevice> m_device;
+    std::unique_ptr<QPdfDocument> m_doc;
+    std::unique_ptr<SelectablePdfView> m_view;
+};
+
+namespace {
+/**
+ * @brief Converts a QtTest XML log into the JSON result format.
+ */
+bool writeJsonResults(const QString& xmlPath, const QString& jsonPath)
+{
+    QFile xmlFile(xmlPath);
+    if (!xmlFile.open(QIODevice::ReadOnly))
+        return false;
+
+    QJsonArray results;
+    QJsonArray failures;
+    QString function;
+    QXmlStreamReader xml(&xmlFile);
+    while (!xml.atEnd()) {
+        if (xml.readNext() != QXmlStreamReader::StartElement)
+            continue;
+        const QXmlStreamAttributes attrs = xml.attributes();
+        if (xml.name() == QLatin1String("TestFunction")) {
+            function = attrs.value(QLatin1String("name")).toString();
+        } else if (xml.name() == QLatin1String("BenchmarkResult")) {
+            const double total = attrs.value(QLatin1String("value")).toDouble();
+            const int iterations = qMax(1, attrs.value(QLatin1String("iterations")).toInt());
+            results.append(QJsonObject{
+                {QStringLiteral("name"), function},
+                {QStringLiteral("tag"), attrs.value(QLatin1String("tag")).toString()},
+                {QStringLiteral("metric"), attrs.value(QLatin1String("metric")).toString()},
+                {QStringLiteral("value"), total / iterations},
+                {QStringLiteral("iterations"), iterations}});
+        } else if (xml.name() == QLatin1String("Incident")) {
+            const QString type = attrs.value(QLatin1String("type")).toString();
+            if (type == QLatin1String("fail") || type == QLatin1String("xpass"))
+                failures.append(function);
+        }
+    }
+    if (xml.hasError())
+        return false;
+
+    const QJsonObject root{
+        {QStringLiteral("suite"), QStringLiteral("QtPdfViewBench")},
+        {QStringLiteral("qtVersion"), QString::fromLatin1(qVersion())},
+        {QStringLiteral("platform"), QGuiApplication::platformName()},
+        {QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate)},
+        {QStringLiteral("results"), results},
+        {QStringLiteral("failures"), failures}};
+    QFile jsonFile(jsonPath);
+    if (!jsonFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    return jsonFile.write(QJsonDocument(root).toJson()) >= 0;
+}
+}
+
+int main(int argc, char** argv)
+{
+    // Headless by default; QT_QPA_PLATFORM can still override
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication app(argc, argv);
+    // Keep session and metadata caches out of the user's profile
+    QStandardPaths::setTestModeEnabled(true);
+
+    QStringList args;
+    QString jsonPath;
+    QString pdfPath;
+    const QStringList all = app.arguments();
+    for (int i = 0; i < all.size(); ++i) {
+        if (all.at(i) == QLatin1String("--json") && i + 1 < all.size())
+            jsonPath = all.at(++i);
+        else if (all.at(i) == QLatin1String("--pdf") && i + 1 < all.size())
+            pdfPath = QFileInfo(all.at(++i)).absoluteFilePath();
+        else
+            args << all.at(i);
+    }
+
+    QTemporaryDir logDir;
+    const QString xmlPath = logDir.filePath(QStringLiteral("bench.xml"));
+    if (!jsonPath.isEmpty())
+        args << QStringLiteral("-o") << xmlPath + QStringLiteral(",xml")
+             << QStringLiteral("-o") << QStringLiteral("-,txt");
+
+    QtPdfViewBench bench(pdfPath);
+    const int rc = QTest::qExec(&bench, args);
+
+    if (!jsonPath.isEmpty() && !writeJsonResults(xmlPath, jsonPath)) {
+        qWarning("Could not write %s", qPrintable(jsonPath));
+        return rc ? rc : 1;
+    }
+    return rc;
+}
+
+#include "QtPdfViewBench.moc"
@@ -0,0 +1,164 @@
+/**
+ * @file BatchRenderer.cpp
+ * @brief Implementation of the headless batch renderer.
+ */
+
+#include "BatchRenderer.h"
+#include "MemoryReport.h"
+#include "PageRenderer.h"
+#include "Trace.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QImageWriter>
+#include <QMutex>
+#include <QPdfDocument>
+#include <QSaveFile>
+#include <QThread>
+#include <atomic>
+#include <numeric>
+
+bool BatchRenderer::parsePageRanges(const QString& spec, int pageCount, QVector<int>* pages)
+{
+    pages->clear();
+    const QStringList parts = spec.split(QLatin1Char(','), Qt::SkipEmptyParts);
+    for (const QString& raw : parts) {
+        const QString part = raw.trimmed();
+        const int dash = part.indexOf(QLatin1Char('-'));
+        bool okFirst = true;
+        bool okLast = true;
+        int first = 1;
+        int last = pageCount;
+        if (dash < 0) {
+            first = last = part.toInt(&okFirst);
+        } else {
+            if (dash > 0)
+                first = part.left(dash).trimmed().toInt(&okFirst);
+            if (dash + 1 < part.size())
+                last = part.mid(dash + 1).trimmed().toInt(&okLast);
+        }
+        if (!okFirst || !okLast || first < 1 || last < first)
+            return false;
+        // Ranges running past the end are clipped, like "10-" is
+        for (int page = first; page <= qMin(last, pageCount); ++page)
+            pages->append(page - 1);
+    }
+    return !pages->isEmpty();
+}
+
+BatchRenderer::Result BatchRenderer::render(const QString& pdfPath, const Options& options)
+{
+    TRACE_SCOPE("BatchRenderer::render");
+    Result r;
+    QElapsedTimer timer;
+    timer.start();
+
+    const QByteArray format = options.format.toLower() == "jpeg" ? QByteArray("jpg") : options.format.toLower();
+    if (!QImageWriter::supportedImageFormats().contains(format)) {
+        r.errorString = tr("Unsupported image format: %1").arg(QString::fromLatin1(format));
+        return r;
+    }
+    if (options.dpi <= 0) {
+        r.errorString = tr("Resolution must be positive");
+        return r;
+    }
+    if (!QDir().mkpath(options.outputDir)) {
+        r.errorString = tr("Cannot create %1").arg(options.outputDir);
+        return r;
+    }
+
+    int pageCount = 0;
+    {
+        QPdfDocument doc;
+        if (doc.load(pdfPath) != QPdfDocument::Error::None) {
+            r.errorString = tr("Cannot read %1").arg(pdfPath);
+            return r;
+        }
+        pageCount = doc.pageCount();
+    }
+    QVector<int> pages = options.pages;
+    if (pages.isEmpty()) {
+        pages.resize(pageCount);
+        std::iota(pages.begin(), pages.end(), 0);
+    }
+    for (int page : std::as_const(pages)) {
+        if (page < 0 || page >= pageCount) {
+            r.errorString = tr("Page %1 is out of range (1-%2)").arg(page + 1).arg(pageCount);
+            return r;
+        }
+    }
+
+    const QDir outDir(options.outputDir);
+    const QString baseName = QFileInfo(pdfPath).completeBaseName();
+    const int digits = int(QString::number(pageCount).size());
+    const int threadCount = qBound(1, options.threads > 0 ? options.threads : QThread::idealThreadCount(),
+                                   int(pages.size()));
+
+    std::atomic<int> next {0};
+    std::atomic<int> written {0};
+    std::atomic_bool failed {false};
+    QMutex errorMutex;
+    QString error;
+    auto setError = [&](const QString& message){
+        const QMutexLocker locker(&errorMutex);
+        if (error.isEmpty())
+            error = message;
+        failed = true;
+    };
+
+    auto work = [&](QPdfDocument* doc){
+        while (!failed.load(std::memory_order_relaxed)) {
+            const int index = next.fetch_add(1);
+            if (index >= pages.size())
+                break;
+            const int page = pages.at(index);
+            const QImage image = PageRenderer::renderAtDpi(*doc, page, options.dpi);
+            if (image.isNull()) {
+                setError(tr("Cannot render page %1").arg(page + 1));
+                break;
+            }
+            TRACE_SCOPE("BatchRenderer::encode");
+            const QString path = outDir.filePath(QStringLiteral("%1-%2.%3")
+                .arg(baseName).arg(page + 1, digits, 10, QLatin1Char('0')).arg(QString::fromLatin1(format)));
+            QSaveFile file(path);
+            QImageWriter writer(&file, format);
+            writer.setQuality(options.quality);
+            // JPEG has no alpha channel
+            const QImage out = format == "jpg" ? image.convertToFormat(QImage::Format_RGB32) : image;
+            if (!file.open(QIODevice::WriteOnly) || !writer.write(out) || !file.commit()) {
+                setError(tr("Cannot write %1: %2").arg(path,
+                    writer.error() != QImageWriter::UnknownError ? writer.errorString() : file.errorString()));
+                break;
+            }
+            ++written;
+        }
+    };
+
+    // One document instance per worker, created and used on its thread
+    QVector<QThread*> threads;
+    for (int i = 0; i < threadCount; ++i) {
+        threads.append(QThread::create([&work, &setError, &pdfPath]{
+            QPdfDocument doc;
+            if (doc.load(pdfPath) != QPdfDocument::Error::None) {
+                setError(tr("Cannot read %1").arg(pdfPath));
+                return;
+            }
+            work(&doc);
+        }));
+    }
+    for (QThread* thread : std::as_const(threads))
+        thread->start();
+    for (QThread* thread : std::as_const(threads)) {
+        thread->wait();
+        delete thread;
+    }
+
+    r.pages = written.load();
+    r.threads = threadCount;
+    r.elapsedMs = timer.elapsed();
+    r.peakResidentBytes = MemoryReport::peakResidentBytes();
+    r.errorString = error;
+    r.ok = error.isEmpty();
+    return r;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file BatchRenderer.h
+ * @brief Headless rendering of document pages to image files.
+ *
+ * BatchRenderer writes pages of a PDF as PNG or JPEG files at a given
+ * resolution, for previews generated by scripts (--render). Pages are
+ * handed out to one worker thread per core; each worker owns a
+ * QPdfDocument instance of the file, renders with PageRenderer (the code
+ * behind thumbnails and printing) and encodes its page, so image encoding,
+ * the larger part of the work for PNG, runs on all cores while pdfium
+ * calls are serialized by QtPdf.
+ *
+ * Files are named <document>-<page>.<format>, the page number 1-based and
+ * zero-padded to the width of the page count, and written through
+ * QSaveFile. Memory stays at one page image per worker.
+ *
+ * Usage:
+ * @code
+ *   BatchRenderer::Options options;
+ *   options.outputDir = QStringLiteral("out");
+ *   options.dpi = 150;
+ *   BatchRenderer::parsePageRanges(QStringLiteral("1-10,15"), pageCount, &options.pages);
+ *   BatchRenderer::Result r = BatchRenderer::render(pdfPath, options);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QString>
+#include <QVector>
+
+/**
+ * @class BatchRenderer
+ * @brief Renders pages of one document to image files on all cores.
+ */
+class BatchRenderer {
+    Q_DECLARE_TR_FUNCTIONS(BatchRenderer)
+public:
+    /**
+     * @struct Options
+     * @brief What to render and how to write it.
+     */
+    struct Options {
+        QString outputDir;
+        qreal dpi {150.0};
+        QByteArray format {"png"};   ///< "png" or "jpg"
+        int quality {-1};            ///< Encoder quality 0-100, -1 for the default
+        QVector<int> pages;          ///< 0-based pages; empty for all
+        int threads {0};             ///< 0 for one per core
+    };
+
+    /**
+     * @struct Result
+     * @brief Outcome of a batch.
+     */
+    struct Result {
+        bool ok {false};
+        QString errorString;
+        int pages {0};                   ///< Pages written
+        int threads {0};
+        qint64 elapsedMs {0};
+        qint64 peakResidentBytes {-1};   ///< Process peak resident size, -1 if unknown
+
+        /// Throughput in pages per second (0 if unknown)
+        double pagesPerSecond() const
+        {
+            return elapsedMs > 0 ? double(pages) * 1000.0 / double(elapsedMs) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Parses 1-based page ranges such as "1-5,8,10-".
+     * @param pages Receives the 0-based pages in the given order
+     * @return False if @p spec is malformed or names no page of the document
+     */
+    static bool parsePageRanges(const QString& spec, int pageCount, QVector<int>* pages);
+
+    /**
+     * @brief Renders the pages of @p pdfPath; blocks until all are written.
+     */
+    static Result render(const QString& pdfPath, const Options& options);
+};
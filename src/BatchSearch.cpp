@@ -0,0 +1,160 @@
+/**
+ * @file BatchSearch.cpp
+ * @brief Implementation of the headless batch search.
+ */
+
+#include "BatchSearch.h"
+#include "FolderSearch.h"
+#include "Trace.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QMutex>
+#include <QPdfDocument>
+#include <QThread>
+#include <atomic>
+
+QStringList BatchSearch::parseTerms(const QString& list)
+{
+    // Same separator as the multi-term search box
+    QStringList terms;
+    const QStringList parts = list.split(QLatin1Char(';'), Qt::SkipEmptyParts);
+    for (const QString& part : parts) {
+        const QString cleaned = part.trimmed();
+        if (!cleaned.isEmpty())
+            terms << cleaned;
+    }
+    return terms;
+}
+
+bool BatchSearch::readTermsFile(const QString& path, QStringList* terms, QString* errorString)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        if (errorString)
+            *errorString = tr("Cannot read %1: %2").arg(path, file.errorString());
+        return false;
+    }
+    // One term per line; terms may contain ';'
+    while (!file.atEnd()) {
+        const QString term = QString::fromUtf8(file.readLine()).trimmed();
+        if (!term.isEmpty())
+            terms->append(term);
+    }
+    return true;
+}
+
+QStringList BatchSearch::expandPaths(const QStringList& paths)
+{
+    QStringList files;
+    for (const QString& path : paths) {
+        const QFileInfo fi(path);
+        if (fi.isDir())
+            files += FolderSearch::pdfFiles(fi.absoluteFilePath());
+        else
+            files.append(fi.absoluteFilePath());
+    }
+    return files;
+}
+
+BatchSearch::Result BatchSearch::run(const QStringList& files, const Options& options,
+                                     const std::function<void(const FileResult&)>& onFile)
+{
+    TRACE_SCOPE("BatchSearch::run");
+    Result r;
+    QElapsedTimer timer;
+    timer.start();
+
+    if (options.terms.isEmpty()) {
+        r.errorString = tr("No search terms");
+        return r;
+    }
+    // Fail once up front rather than once per file
+    for (const QString& term : options.terms) {
+        const TextMatcher matcher(term, options.matchOptions);
+        if (!matcher.isValid() && !matcher.errorString().isEmpty()) {
+            r.errorString = tr("Invalid term \"%1\": %2").arg(term, matcher.errorString());
+            return r;
+        }
+    }
+
+    const int threadCount = qBound(1, options.threads > 0 ? options.threads : QThread::idealThreadCount(),
+                                   qMax(1, int(files.size())));
+    std::atomic<int> next {0};
+    QMutex resultMutex;
+
+    auto work = [&]{
+        // Created and used on this thread; the engine's cache holds one file's text
+        QPdfDocument doc;
+        SearchEngine engine;
+        for (int index = next.fetch_add(1); index < files.size(); index = next.fetch_add(1)) {
+            TRACE_SCOPE("BatchSearch::file");
+            FileResult file;
+            file.filePath = files.at(index);
+            file.counts = QVector<int>(options.terms.size(), 0);
+            if (doc.load(file.filePath) != QPdfDocument::Error::None) {
+                file.error = tr("Cannot read %1").arg(file.filePath);
+            } else {
+                file.pageCount = doc.pageCount();
+                engine.setDocument(&doc, nullptr);
+                file.hits = engine.run(options.terms, options.matchOptions);
+                for (const SearchHit& hit : std::as_const(file.hits))
+                    ++file.counts[hit.term];
+            }
+            engine.setDocument(nullptr, nullptr);
+            doc.close();
+
+            const QMutexLocker locker(&resultMutex);
+            ++r.files;
+            if (!file.error.isEmpty())
+                ++r.failedFiles;
+            r.pages += file.pageCount;
+            r.hits += file.hits.size();
+            if (onFile)
+                onFile(file);
+        }
+    };
+
+    QVector<QThread*> threads;
+    for (int i = 0; i < threadCount; ++i)
+        threads.append(QThread::create(work));
+    for (QThread* thread : std::as_const(threads))
+        thread->start();
+    for (QThread* thread : std::as_const(threads)) {
+        thread->wait();
+        delete thread;
+    }
+
+    r.ok = true;
+    r.threads = threadCount;
+    r.elapsedMs = timer.elapsed();
+    return r;
+}
+
+QJsonObject BatchSearch::toJson(const FileResult& result, const QStringList& terms)
+{
+    QJsonObject counts;
+    for (int i = 0; i < terms.size(); ++i)
+        counts.insert(terms.at(i), result.counts.value(i));
+    QJsonArray hits;
+    for (const SearchHit& hit : result.hits) {
+        hits.append(QJsonObject{
+            {QStringLiteral("term"), terms.at(hit.term)},
+            {QStringLiteral("page"), hit.page + 1},
+            {QStringLiteral("offset"), hit.start},
+            {QStringLiteral("length"), hit.length},
+            {QStringLiteral("rect"), QJsonObject{{QStringLiteral("x"), hit.rect.x()},
+                                                 {QStringLiteral("y"), hit.rect.y()},
+                                                 {QStringLiteral("width"), hit.rect.width()},
+                                                 {QStringLiteral("height"), hit.rect.height()}}}});
+    }
+    QJsonObject json{{QStringLiteral("file"), result.filePath},
+                     {QStringLiteral("pages"), result.pageCount},
+                     {QStringLiteral("counts"), counts},
+                     {QStringLiteral("hits"), hits}};
+    if (!result.error.isEmpty())
+        json.insert(QStringLiteral("error"), result.error);
+    return json;
+}
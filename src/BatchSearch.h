@@ -0,0 +1,116 @@
+/**
+ * @file BatchSearch.h
+ * @brief Headless multi-term search over many documents with JSON output.
+ *
+ * BatchSearch runs the search behind the minimap's multi-term search
+ * (SearchEngine::run, the same folding, matching and hit rectangles) over
+ * a list of files without creating any widget, for batch jobs (--search-batch).
+ * Files are handed out to one worker per core; each worker owns a
+ * QPdfDocument and a SearchEngine, opens one file at a time and drops its
+ * text before the next, so memory is bounded by the worker count however
+ * many files are searched. Within a file, pages are matched in parallel
+ * as in the viewer.
+ *
+ * Each file's result is passed to a callback as soon as it is done (in
+ * completion order); toJson() turns it into one JSON object, so callers
+ * can stream JSON Lines instead of holding every hit of every file.
+ *
+ * Usage:
+ * @code
+ *   BatchSearch::Options options;
+ *   options.terms = {QStringLiteral("invoice"), QStringLiteral("total")};
+ *   BatchSearch::Result r = BatchSearch::run(files, options, [&](const BatchSearch::FileResult& f){
+ *       out.write(QJsonDocument(BatchSearch::toJson(f, options.terms)).toJson(QJsonDocument::Compact));
+ *   });
+ * @endcode
+ */
+
+#pragma once
+
+#include <QCoreApplication>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+#include "SearchEngine.h"
+#include "TextSearch.h"
+
+/**
+ * @class BatchSearch
+ * @brief Searches many documents for several terms on all cores.
+ */
+class BatchSearch {
+    Q_DECLARE_TR_FUNCTIONS(BatchSearch)
+public:
+    /**
+     * @struct Options
+     * @brief What to search for.
+     */
+    struct Options {
+        QStringList terms;
+        TextMatcher::Options matchOptions {TextMatcher::NoOptions};
+        int threads {0};             ///< Files searched at once; 0 for one per core
+    };
+
+    /**
+     * @struct FileResult
+     * @brief Hits of one file.
+     */
+    struct FileResult {
+        QString filePath;
+        int pageCount {0};
+        QVector<SearchHit> hits;     ///< In page order
+        QVector<int> counts;         ///< Hits per term
+        QString error;               ///< Set if the file could not be opened
+    };
+
+    /**
+     * @struct Result
+     * @brief Totals of a batch.
+     */
+    struct Result {
+        bool ok {false};             ///< False only if the batch could not start
+        QString errorString;
+        int files {0};               ///< Files searched
+        int failedFiles {0};         ///< Files that could not be opened
+        qint64 pages {0};
+        qint64 hits {0};
+        int threads {0};
+        qint64 elapsedMs {0};
+
+        /// Throughput in pages per second (0 if unknown)
+        double pagesPerSecond() const
+        {
+            return elapsedMs > 0 ? double(pages) * 1000.0 / double(elapsedMs) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Splits a ';'-separated term list, or reads one term per line from a file.
+     */
+    static QStringList parseTerms(const QString& list);
+    static bool readTermsFile(const QString& path, QStringList* terms, QString* errorString);
+
+    /**
+     * @brief Expands directories in @p paths to the PDF files below them.
+     */
+    static QStringList expandPaths(const QStringList& paths);
+
+    /**
+     * @brief Searches @p files; blocks until all are done.
+     * @param onFile Called once per file, from worker threads but never concurrently
+     */
+    static Result run(const QStringList& files, const Options& options,
+                      const std::function<void(const FileResult&)>& onFile);
+
+    /**
+     * @brief JSON form of a file result.
+     *
+     * { "file", "pages", "counts": { term: n }, "hits": [ { "term", "page" (1-based),
+     * "offset", "length", "rect": { "x", "y", "width", "height" } } ], "error" }
+     * with offsets in characters of the page text and rectangles in page points.
+     */
+    static QJsonObject toJson(const FileResult& result, const QStringList& terms);
+};
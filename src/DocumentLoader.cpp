@@ -0,0 +1,75 @@
+/**
+ * @file DocumentLoader.cpp
+ * @brief Implementation of the background document loader.
+ */
+
+#include "DocumentLoader.h"
+#include "FileReadDevice.h"
+#include "Trace.h"
+
+#include <QEventLoop>
+#include <QPdfDocument>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentRun>
+
+DocumentLoader::DocumentLoader(QObject* parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+DocumentLoader::~DocumentLoader()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void DocumentLoader::cancel()
+{
+    ++m_generation;
+}
+
+quint64 DocumentLoader::request(const QString& filePath)
+{
+    const quint64 generation = ++m_generation;
+    QThread* target = thread();
+    QtConcurrent::run(&m_pool, [this, filePath, generation, target]{
+        if (m_generation.load() != generation)
+            return;
+        TRACE_SCOPE("DocumentLoader::load");
+        auto* device = new FileReadDevice(filePath);
+        if (!device->open(QIODevice::ReadOnly)) {
+            const QString error = device->errorString();
+            delete device;
+            if (m_generation.load() == generation)
+                emit failed(generation, filePath, error);
+            return;
+        }
+        auto* doc = new QPdfDocument;
+        // load(QIODevice*) reports through status(); a random-access device
+        // that is completely available is parsed before it returns
+        doc->load(device);
+        if (doc->status() == QPdfDocument::Status::Loading) {
+            QEventLoop loop;
+            QObject::connect(doc, &QPdfDocument::statusChanged, &loop, [&loop](QPdfDocument::Status status){
+                if (status != QPdfDocument::Status::Loading)
+                    loop.quit();
+            });
+            loop.exec();
+        }
+        const bool ready = doc->status() == QPdfDocument::Status::Ready;
+        if (!ready || m_generation.load() != generation) {
+            const QPdfDocument::Error error = doc->error();
+            delete doc;
+            delete device;
+            if (!ready && m_generation.load() == generation)
+                emit failed(generation, filePath, tr("Error code: %1").arg(int(error)));
+            return;
+        }
+        // Hand over: only the owning thread may move an object
+        doc->moveToThread(target);
+        device->moveToThread(target);
+        emit loaded(generation, filePath, doc, device);
+    });
+    return generation;
+}
@@ -0,0 +1,73 @@
+/**
+ * @file DocumentLoader.h
+ * @brief Opens and parses local documents off the GUI thread.
+ *
+ * QPdfDocument::load() parses a non-sequential device synchronously:
+ * pdfium reads the cross-reference table, the trailer and the page tree
+ * before load() returns, which takes a noticeable time for large files.
+ * DocumentLoader runs that parse on a worker thread with a document and
+ * a FileReadDevice created there, then moves both to the loader's own
+ * thread and hands them over, so the GUI keeps painting (the loading
+ * state, the minimap and page frames from cached metadata) meanwhile.
+ *
+ * Every request gets a generation; a newer request or cancel() makes the
+ * worker drop its result, and the receiver of loaded() ignores (and
+ * deletes) documents of an older generation.
+ *
+ * Usage:
+ * @code
+ *   connect(loader, &DocumentLoader::loaded, this,
+ *           [](quint64 generation, const QString& path, QPdfDocument* doc, FileReadDevice* device){ ... });
+ *   m_loadGeneration = loader->request(filePath);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <atomic>
+
+class FileReadDevice;
+class QPdfDocument;
+
+/**
+ * @class DocumentLoader
+ * @brief Loads one local document at a time on a worker thread.
+ */
+class DocumentLoader : public QObject {
+    Q_OBJECT
+public:
+    explicit DocumentLoader(QObject* parent = nullptr);
+    ~DocumentLoader() override;
+
+    /**
+     * @brief Starts loading @p filePath, cancelling the previous request.
+     * @return Generation of the request, passed to loaded() and failed()
+     */
+    quint64 request(const QString& filePath);
+
+    /// Cancels the running request; neither signal is emitted for it.
+    void cancel();
+
+    /// Generation of the latest request
+    quint64 generation() const { return m_generation.load(); }
+
+signals:
+    /**
+     * @brief @p filePath was parsed; @p document reads from @p device.
+     *
+     * Both objects have no parent, live in the loader's thread and are
+     * owned by the receiver, which deletes the document before the device.
+     * Emitted from the worker; connect with the default (queued) type.
+     */
+    void loaded(quint64 generation, const QString& filePath, QPdfDocument* document, FileReadDevice* device);
+
+    /// @p filePath could not be opened or parsed.
+    void failed(quint64 generation, const QString& filePath, const QString& errorString);
+
+private:
+    QThreadPool m_pool;                     ///< One thread: one parse at a time
+    std::atomic<quint64> m_generation {0};
+};
@@ -0,0 +1,246 @@
+/**
+ * @file DocumentPool.cpp
+ * @brief Implementation of the document instance pool.
+ */
+
+#include "DocumentPool.h"
+#include "PageRenderer.h"
+#include "Trace.h"
+
+#include <QMutexLocker>
+#include <QPdfDocument>
+#include <QPointer>
+#include <QSemaphore>
+#include <QThread>
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+DocumentPool::DocumentPool(QObject* parent)
+    : QObject(parent)
+{
+}
+
+DocumentPool::~DocumentPool()
+{
+    close();
+}
+
+void DocumentPool::open(const QString& filePath, int instances)
+{
+    close();
+    if (filePath.isEmpty())
+        return;
+    if (instances <= 0)
+        instances = qBound(1, QThread::idealThreadCount(), kMaxInstances);
+
+    m_filePath = filePath;
+    // submit() may be called from other threads (runPages())
+    const QMutexLocker locker(&m_mutex);
+    ++m_session;
+    m_stopping = false;
+    for (int i = 0; i < instances; ++i) {
+        QThread* thread = QThread::create([this, filePath]{ workerLoop(filePath); });
+        thread->setObjectName(QStringLiteral("DocumentPool"));
+        m_threads.append(thread);
+        thread->start(QThread::LowPriority);
+    }
+}
+
+void DocumentPool::close()
+{
+    QVector<QThread*> threads;
+    {
+        const QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        ++m_session;
+        for (std::deque<Job>& queue : m_queues)
+            queue.clear();
+        threads.swap(m_threads);
+    }
+    ++m_generation;
+    m_wake.wakeAll();
+    for (QThread* thread : std::as_const(threads)) {
+        thread->wait();
+        delete thread;
+    }
+    m_filePath.clear();
+}
+
+void DocumentPool::workerLoop(const QString& filePath)
+{
+    // Created, used and destroyed on this thread only
+    QPdfDocument doc;
+    {
+        TRACE_SCOPE("DocumentPool::load");
+        doc.load(filePath);
+    }
+    for (;;) {
+        Job job;
+        {
+            QMutexLocker locker(&m_mutex);
+            auto next = [this]() -> std::deque<Job>* {
+                for (int p = int(Priority::High); p >= int(Priority::Low); --p) {
+                    if (!m_queues[p].empty())
+                        return &m_queues[p];
+                }
+                return nullptr;
+            };
+            std::deque<Job>* queue = nullptr;
+            while (!m_stopping && !(queue = next()))
+                m_wake.wait(&m_mutex);
+            if (m_stopping)
+                return;
+            job = std::move(queue->front());
+            queue->pop_front();
+        }
+        if (job.generation == m_generation.load())
+            job.run(doc, job.generation);
+    }
+}
+
+DocumentPool::JobId DocumentPool::submit(Priority priority, std::function<void(QPdfDocument&, quint64)> run,
+                                         quint64 session)
+{
+    JobId id = 0;
+    {
+        const QMutexLocker locker(&m_mutex);
+        if (m_threads.isEmpty() || (session != 0 && session != m_session.load()))
+            return 0;
+        id = m_nextId++;
+        m_queues[int(priority)].push_back({id, m_generation.load(), std::move(run)});
+    }
+    m_wake.wakeOne();
+    return id;
+}
+
+void DocumentPool::post(const QPointer<QObject>& context, quint64 generation, std::function<void()> deliver)
+{
+    // The context pointer is only looked at on the pool's thread, where it
+    // was created; events still queued when the pool is destroyed are dropped
+    QMetaObject::invokeMethod(this, [this, context, generation, deliver = std::move(deliver)]{
+        if (context && m_generation.load() == generation)
+            deliver();
+    }, Qt::QueuedConnection);
+}
+
+DocumentPool::JobId DocumentPool::renderPage(int page, const QSize& size, Priority priority, QObject* context,
+                                             std::function<void(const QImage&)> done)
+{
+    return submit(priority, [this, page, size, context = QPointer<QObject>(context),
+                             done = std::move(done)](QPdfDocument& doc, quint64 generation){
+        TRACE_SCOPE("DocumentPool::renderPage");
+        const QImage image = PageRenderer::renderToFit(doc, page, size);
+        post(context, generation, [done, image]{ done(image); });
+    });
+}
+
+DocumentPool::JobId DocumentPool::extractText(int page, Priority priority, QObject* context,
+                                              std::function<void(const QString&)> done)
+{
+    return submit(priority, [this, page, context = QPointer<QObject>(context),
+                             done = std::move(done)](QPdfDocument& doc, quint64 generation){
+        TRACE_SCOPE("DocumentPool::extractText");
+        const QString text = doc.getAllText(page).text();
+        post(context, generation, [done, text]{ done(text); });
+    });
+}
+
+DocumentPool::JobId DocumentPool::selectionAtIndex(int page, int start, int length, Priority priority,
+                                                   QObject* context,
+                                                   std::function<void(const QPdfSelection&)> done)
+{
+    return submit(priority, [this, page, start, length, context = QPointer<QObject>(context),
+                             done = std::move(done)](QPdfDocument& doc, quint64 generation){
+        const QPdfSelection selection = doc.getSelectionAtIndex(page, start, length);
+        post(context, generation, [done, selection]{ done(selection); });
+    });
+}
+
+DocumentPool::JobId DocumentPool::run(Priority priority, std::function<void(QPdfDocument&)> work, quint64 session)
+{
+    return submit(priority, [work = std::move(work)](QPdfDocument& doc, quint64){ work(doc); }, session);
+}
+
+bool DocumentPool::runPages(quint64 session, int first, int count, Priority priority,
+                            const std::function<bool()>& cancelled, const PageWork& work)
+{
+    std::vector<char> done(count, 0);
+    int remaining = count;
+    while (remaining > 0) {
+        if (cancelled && cancelled())
+            return false;
+        // Jobs release the semaphore when they are destroyed, so jobs that
+        // are dropped unrun (cancelAll(), close()) are waited for too
+        QSemaphore finished;
+        int queued = 0;
+        for (int i = 0; i < count; ++i) {
+            if (done.at(i))
+                continue;
+            std::shared_ptr<void> release(nullptr, [&finished](void*){ finished.release(); });
+            const JobId id = run(priority, [&work, &done, i, page = first + i, release](QPdfDocument& doc){
+                work(page, doc);
+                done[i] = 1;
+            }, session);
+            if (id == 0) {
+                finished.acquire(queued);
+                return false;
+            }
+            ++queued;
+        }
+        finished.acquire(queued);
+        remaining = int(std::count(done.cbegin(), done.cend(), 0));
+    }
+    return true;
+}
+
+DocumentPool::PageRunner DocumentPool::pageRunner(quint64 session, Priority priority,
+                                                  std::function<bool()> cancelled)
+{
+    return [this, session, priority, cancelled = std::move(cancelled)](int first, int count, const PageWork& work){
+        return runPages(session, first, count, priority, cancelled, work);
+    };
+}
+
+DocumentPool::PageRunner DocumentPool::localRunner(QPdfDocument& doc, std::function<bool()> cancelled)
+{
+    return [&doc, cancelled = std::move(cancelled)](int first, int count, const PageWork& work){
+        for (int page = first; page < first + count; ++page) {
+            if (cancelled && cancelled())
+                return false;
+            work(page, doc);
+        }
+        return true;
+    };
+}
+
+bool DocumentPool::cancel(JobId id)
+{
+    const QMutexLocker locker(&m_mutex);
+    for (std::deque<Job>& queue : m_queues) {
+        auto it = std::find_if(queue.begin(), queue.end(), [id](const Job& job){ return job.id == id; });
+        if (it != queue.end()) {
+            queue.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void DocumentPool::cancelAll()
+{
+    const QMutexLocker locker(&m_mutex);
+    for (std::deque<Job>& queue : m_queues)
+        queue.clear();
+    ++m_generation;
+}
+
+int DocumentPool::pendingJobCount() const
+{
+    const QMutexLocker locker(&m_mutex);
+    int count = 0;
+    for (const std::deque<Job>& queue : m_queues)
+        count += int(queue.size());
+    return count;
+}
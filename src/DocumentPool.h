@@ -0,0 +1,188 @@
+/**
+ * @file DocumentPool.h
+ * @brief Independent document instances of one file on worker threads.
+ *
+ * A QPdfDocument must not be used from several threads at once, and the
+ * viewer's document belongs to the GUI thread. DocumentPool opens the same
+ * file once per worker thread, each worker owning its instance for its
+ * whole life, and runs jobs (render a page, extract page text, selection
+ * at a character index) on whichever instance is free.
+ *
+ * Jobs are queued by priority (High before Normal before Low, first come
+ * first served within one priority) and can be cancelled while queued;
+ * a job that already started runs to completion. Results are delivered
+ * through a callback on the pool's own thread (normally the GUI thread),
+ * and are dropped if the context object passed with the job was destroyed,
+ * or the pool was switched to another file or cancelAll() was called in
+ * the meantime.
+ *
+ * Work that goes through a whole document (search, text export, page
+ * fingerprints, text layer builds) runs from its own worker thread with
+ * runPages(): every page is a job, so it shares the instances with
+ * thumbnails by priority instead of parsing the file once more. The same
+ * code runs on a caller-owned document through localRunner(), for the
+ * command line modes.
+ *
+ * QtPdf serializes calls into pdfium, so the instances do not render in
+ * parallel; what scales is everything around pdfium (image conversion,
+ * scaling, text handling) and the GUI thread, which no longer waits.
+ *
+ * Usage:
+ * @code
+ *   pool->open(filePath);
+ *   pool->renderPage(3, QSize(440, 440), DocumentPool::Priority::Low, this,
+ *                    [this](const QImage& image){ setThumbnail(3, image); });
+ *
+ *   // on a worker thread; session() taken on the pool's thread
+ *   pool->runPages(session, 0, pageCount, DocumentPool::Priority::Low, {},
+ *                  [&](int page, QPdfDocument& doc){ texts[page] = doc.getAllText(page).text(); });
+ * @endcode
+ */
+
+#pragma once
+
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QPdfSelection>
+#include <QPointer>
+#include <QSize>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <functional>
+
+class QPdfDocument;
+class QThread;
+
+/**
+ * @class DocumentPool
+ * @brief Prioritized, cancellable jobs on per-thread QPdfDocument instances.
+ */
+class DocumentPool : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kMaxInstances = 4;
+
+    enum class Priority {
+        Low,        ///< Background work (thumbnails ahead of time, export)
+        Normal,
+        High        ///< Something the user is looking at
+    };
+
+    using JobId = quint64;
+
+    /// Work on one page, with the instance it runs on
+    using PageWork = std::function<void(int page, QPdfDocument& doc)>;
+
+    /// Runs a PageWork for pages [first, first + count); false once cancelled
+    using PageRunner = std::function<bool(int first, int count, const PageWork& work)>;
+
+    explicit DocumentPool(QObject* parent = nullptr);
+    ~DocumentPool() override;
+
+    /**
+     * @brief Opens @p filePath in @p instances document instances.
+     *
+     * Closes the current file first. With 0 instances the pool uses one
+     * per core, up to kMaxInstances. The instances load on their threads;
+     * jobs can be queued right away.
+     */
+    void open(const QString& filePath, int instances = 0);
+
+    /// Cancels all jobs and closes the instances.
+    void close();
+
+    QString filePath() const { return m_filePath; }
+    int instanceCount() const { return int(m_threads.size()); }
+
+    /// Identifies the open file; changes with every open() and close()
+    quint64 session() const { return m_session.load(); }
+
+    /**
+     * @brief Renders @p page to fit @p size; @p done receives the image.
+     *
+     * @p done is not called once @p context is destroyed.
+     */
+    JobId renderPage(int page, const QSize& size, Priority priority, QObject* context,
+                     std::function<void(const QImage&)> done);
+
+    /**
+     * @brief Extracts the text of @p page.
+     */
+    JobId extractText(int page, Priority priority, QObject* context,
+                      std::function<void(const QString&)> done);
+
+    /**
+     * @brief Returns the selection of @p length characters at @p start on @p page.
+     */
+    JobId selectionAtIndex(int page, int start, int length, Priority priority, QObject* context,
+                           std::function<void(const QPdfSelection&)> done);
+
+    /**
+     * @brief Runs @p work with a free instance, on that instance's thread.
+     *
+     * For callers that deliver results themselves. @p work must not keep
+     * the document. If the job is removed before it runs, @p work is
+     * destroyed without being called; callers waiting for it can rely on
+     * that.
+     * @param session Unless 0, the job is only queued while session() still has this value
+     * @return 0 if the pool is closed or moved on (@p work is destroyed right away)
+     */
+    JobId run(Priority priority, std::function<void(QPdfDocument&)> work, quint64 session = 0);
+
+    /**
+     * @brief Runs @p work for pages [@p first, @p first + @p count) and waits for all of them.
+     *
+     * Call from a worker thread. Pages run on whichever instances are free,
+     * interleaved with other jobs by priority; pages dropped by cancelAll()
+     * are queued again.
+     * @param session session() of the file the caller works on
+     * @param cancelled Polled before queueing; may be empty
+     * @return False if cancelled, or the pool closed or opened another file
+     */
+    bool runPages(quint64 session, int first, int count, Priority priority,
+                  const std::function<bool()>& cancelled, const PageWork& work);
+
+    /// runPages() bound to @p session, @p priority and @p cancelled
+    PageRunner pageRunner(quint64 session, Priority priority, std::function<bool()> cancelled);
+
+    /// Runs pages on @p doc on the calling thread, which must own it
+    static PageRunner localRunner(QPdfDocument& doc, std::function<bool()> cancelled = {});
+
+    /**
+     * @brief Removes a queued job.
+     * @return False if the job already started or does not exist
+     */
+    bool cancel(JobId id);
+
+    /// Removes all queued jobs and drops the results of running ones.
+    void cancelAll();
+
+    /// Jobs waiting for an instance
+    int pendingJobCount() const;
+
+private:
+    struct Job {
+        JobId id {0};
+        quint64 generation {0};
+        std::function<void(QPdfDocument&, quint64)> run;
+    };
+
+    JobId submit(Priority priority, std::function<void(QPdfDocument&, quint64)> run, quint64 session = 0);
+    /// Calls @p deliver on the pool's thread unless @p context is gone or @p generation went stale
+    void post(const QPointer<QObject>& context, quint64 generation, std::function<void()> deliver);
+    void workerLoop(const QString& filePath);
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    std::deque<Job> m_queues[3];            ///< Indexed by Priority
+    bool m_stopping {false};
+    JobId m_nextId {1};
+    std::atomic<quint64> m_generation {1};  ///< Bumped by open(), close() and cancelAll()
+    std::atomic<quint64> m_session {1};     ///< Bumped by open() and close(), under m_mutex
+    QString m_filePath;
+    QVector<QThread*> m_threads;
+};
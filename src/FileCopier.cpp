@@ -0,0 +1,210 @@
+/**
+ * @file FileCopier.cpp
+ * @brief Implementation of the background atomic file copy.
+ */
+
+#include "FileCopier.h"
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSaveFile>
+#include <QThread>
+#include <QtGlobal>
+#include <memory>
+
+#ifdef Q_OS_LINUX
+#include <cerrno>
+#include <cstring>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#endif
+
+namespace {
+constexpr qint64 kStreamChunkBytes = 4 * 1024 * 1024;
+constexpr qint64 kKernelChunkBytes = 64 * 1024 * 1024;
+constexpr qint64 kProgressIntervalMs = 100;
+}
+
+FileCopier::FileCopier(QObject* parent)
+    : QObject(parent)
+{
+}
+
+FileCopier::~FileCopier()
+{
+    if (m_thread) {
+        m_cancel = true;
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+bool FileCopier::start(const QString& source, const QString& destination)
+{
+    if (m_thread)
+        return false;
+
+    m_cancel = false;
+    auto result = std::make_shared<Result>();
+    m_thread = QThread::create([this, source, destination, result]{
+        QElapsedTimer throttle;
+        throttle.start();
+        *result = copy(source, destination, &m_cancel, [this, &throttle](qint64 done, qint64 total){
+            if (done < total && throttle.elapsed() < kProgressIntervalMs)
+                return;
+            throttle.restart();
+            QMetaObject::invokeMethod(this, [this, done, total]{
+                emit progress(done, total);
+            }, Qt::QueuedConnection);
+        });
+    });
+    connect(m_thread, &QThread::finished, this, [this, result]{
+        m_thread->deleteLater();
+        m_thread = nullptr;
+        emit finished(*result);
+    });
+    m_thread->start(QThread::LowPriority);
+    return true;
+}
+
+void FileCopier::cancel()
+{
+    m_cancel = true;
+}
+
+QString FileCopier::methodName(Method method)
+{
+    switch (method) {
+    case Method::Reflink:
+        return tr("reflink");
+    case Method::Kernel:
+        return tr("in-kernel copy");
+    case Method::Streaming:
+        return tr("streaming copy");
+    case Method::None:
+        break;
+    }
+    return QString();
+}
+
+FileCopier::Result FileCopier::copy(const QString& source, const QString& destination,
+                                    const std::atomic_bool* cancel,
+                                    const std::function<void(qint64, qint64)>& onProgress)
+{
+    Result r;
+    QElapsedTimer timer;
+    timer.start();
+
+    auto isCancelled = [cancel]{
+        return cancel && cancel->load(std::memory_order_relaxed);
+    };
+    auto report = [&onProgress](qint64 done, qint64 total){
+        if (onProgress)
+            onProgress(done, total);
+    };
+
+    QFile in(source);
+    if (!in.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        r.errorString = tr("Cannot read %1: %2").arg(source, in.errorString());
+        return r;
+    }
+    const qint64 total = in.size();
+
+    // QSaveFile writes to a temporary file in the destination directory and
+    // renames it over the destination on commit(), so the old file survives
+    // until the new one is complete.
+    QSaveFile out(destination);
+    out.setDirectWriteFallback(false);
+    if (!out.open(QIODevice::WriteOnly | QIODevice::Unbuffered)) {
+        r.errorString = tr("Cannot write %1: %2").arg(destination, out.errorString());
+        return r;
+    }
+
+    qint64 done = 0;
+    report(0, total);
+
+#ifdef Q_OS_LINUX
+    const int inFd = in.handle();
+    const int outFd = out.handle();
+    if (inFd >= 0 && outFd >= 0 && total > 0) {
+#ifdef FICLONE
+        // Copy-on-write clone: O(1) on btrfs, XFS and other reflink filesystems
+        if (::ioctl(outFd, FICLONE, inFd) == 0) {
+            done = total;
+            r.method = Method::Reflink;
+        }
+#endif
+        while (r.method != Method::Reflink && done < total && !isCancelled()) {
+            const size_t chunk = size_t(qMin(total - done, kKernelChunkBytes));
+            const ssize_t n = ::copy_file_range(inFd, nullptr, outFd, nullptr, chunk, 0);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                // Not supported for this pair of files: stream instead, as
+                // long as nothing has been written yet.
+                if (done == 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP
+                                  || errno == EINVAL || errno == EBADF))
+                    break;
+                r.errorString = tr("Copy failed: %1").arg(QString::fromLocal8Bit(::strerror(errno)));
+                out.cancelWriting();
+                return r;
+            }
+            if (n == 0)
+                break;
+            done += n;
+            r.method = Method::Kernel;
+            report(done, total);
+        }
+    }
+#endif
+
+    if (done == 0 && r.method == Method::None) {
+        QByteArray buffer(int(qMin(qMax<qint64>(total, 1), kStreamChunkBytes)), Qt::Uninitialized);
+        while (!isCancelled()) {
+            const qint64 n = in.read(buffer.data(), buffer.size());
+            if (n < 0) {
+                r.errorString = tr("Cannot read %1: %2").arg(source, in.errorString());
+                out.cancelWriting();
+                return r;
+            }
+            if (n == 0)
+                break;
+            if (out.write(buffer.constData(), n) != n) {
+                r.errorString = tr("Cannot write %1: %2").arg(destination, out.errorString());
+                out.cancelWriting();
+                return r;
+            }
+            done += n;
+            report(done, total);
+        }
+        r.method = Method::Streaming;
+    }
+
+    if (isCancelled()) {
+        out.cancelWriting();
+        r.cancelled = true;
+        r.errorString = tr("Cancelled");
+        r.bytes = done;
+        r.elapsedMs = timer.elapsed();
+        return r;
+    }
+
+    if (done != total) {
+        r.errorString = tr("Source file changed while copying (%1 of %2 bytes)").arg(done).arg(total);
+        out.cancelWriting();
+        return r;
+    }
+
+    if (!out.commit()) {
+        r.errorString = tr("Cannot write %1: %2").arg(destination, out.errorString());
+        return r;
+    }
+
+    r.ok = true;
+    r.bytes = done;
+    r.elapsedMs = timer.elapsed();
+    return r;
+}
@@ -0,0 +1,125 @@
+/**
+ * @file FileCopier.h
+ * @brief Background, atomic file copy used by Save As.
+ *
+ * FileCopier copies a file on a worker thread so the UI stays responsive
+ * for multi-gigabyte PDFs. The data is written to a temporary file next to
+ * the destination which is atomically renamed over it once complete, so an
+ * existing destination survives a failed or cancelled copy.
+ *
+ * On Linux the copy is done in the kernel: a reflink (FICLONE) is tried
+ * first, then copy_file_range(). Other platforms, or filesystems that
+ * support neither, fall back to a streaming copy.
+ *
+ * Usage:
+ * @code
+ *   auto* copier = new FileCopier(this);
+ *   connect(copier, &FileCopier::progress, this, [](qint64 done, qint64 total){ ... });
+ *   connect(copier, &FileCopier::finished, this, [](const FileCopier::Result& r){ ... });
+ *   copier->start(sourcePath, destinationPath);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+class QThread;
+
+/**
+ * @class FileCopier
+ * @brief Copies one file at a time on a worker thread with progress.
+ */
+class FileCopier : public QObject {
+    Q_OBJECT
+public:
+    /**
+     * @brief How the data was actually copied.
+     */
+    enum class Method {
+        None,       ///< Nothing was copied
+        Reflink,    ///< Copy-on-write clone (FICLONE)
+        Kernel,     ///< In-kernel copy (copy_file_range)
+        Streaming   ///< Userspace read/write loop
+    };
+
+    /**
+     * @struct Result
+     * @brief Outcome of a finished copy.
+     */
+    struct Result {
+        bool ok {false};
+        bool cancelled {false};
+        QString errorString;
+        qint64 bytes {0};
+        qint64 elapsedMs {0};
+        Method method {Method::None};
+
+        /// Throughput in bytes per second (0 if unknown)
+        double bytesPerSecond() const
+        {
+            return elapsedMs > 0 ? double(bytes) * 1000.0 / double(elapsedMs) : 0.0;
+        }
+    };
+
+    /**
+     * @brief Constructs a FileCopier.
+     * @param parent Parent object
+     */
+    explicit FileCopier(QObject* parent = nullptr);
+    ~FileCopier() override;
+
+    /**
+     * @brief Starts copying @p source to @p destination in the background.
+     * @return False if a copy is already running
+     */
+    bool start(const QString& source, const QString& destination);
+
+    /**
+     * @brief Requests cancellation of the running copy.
+     *
+     * The destination is left untouched; finished() is still emitted.
+     */
+    void cancel();
+
+    /**
+     * @brief Returns true while a copy is in progress.
+     */
+    bool isRunning() const { return m_thread != nullptr; }
+
+    /**
+     * @brief Returns a human readable name for a copy method.
+     */
+    static QString methodName(Method method);
+
+    /**
+     * @brief Performs the copy synchronously on the calling thread.
+     * @param source Source file path
+     * @param destination Destination file path (replaced atomically)
+     * @param cancel Optional cancellation flag polled between chunks
+     * @param onProgress Optional callback receiving (bytesCopied, bytesTotal)
+     */
+    static Result copy(const QString& source, const QString& destination,
+                       const std::atomic_bool* cancel = nullptr,
+                       const std::function<void(qint64, qint64)>& onProgress = {});
+
+signals:
+    /**
+     * @brief Emitted periodically while copying.
+     */
+    void progress(qint64 bytesCopied, qint64 bytesTotal);
+
+    /**
+     * @brief Emitted once when the copy ends (successfully or not).
+     */
+    void finished(const FileCopier::Result& result);
+
+private:
+    QThread* m_thread {nullptr};
+    std::atomic_bool m_cancel {false};
+};
+
+Q_DECLARE_METATYPE(FileCopier::Result)
@@ -0,0 +1,83 @@
+/**
+ * @file FileReadDevice.cpp
+ * @brief Implementation of the positional-read file device.
+ */
+
+#include "FileReadDevice.h"
+
+#include <QtGlobal>
+
+#if defined(Q_OS_UNIX)
+#  include <cerrno>
+#  include <unistd.h>
+#endif
+
+FileReadDevice::FileReadDevice(const QString& filePath, QObject* parent)
+    : QIODevice(parent)
+    , m_file(filePath)
+{
+}
+
+FileReadDevice::~FileReadDevice()
+{
+    close();
+}
+
+bool FileReadDevice::open(OpenMode mode)
+{
+    if ((mode & QIODevice::ReadWrite) != QIODevice::ReadOnly) {
+        setErrorString(tr("FileReadDevice is read-only"));
+        return false;
+    }
+    if (!m_file.open(QIODevice::ReadOnly | QIODevice::Unbuffered)) {
+        setErrorString(m_file.errorString());
+        return false;
+    }
+    m_size = m_file.size();
+    // pdfium reads whole objects; a second buffer in QIODevice only copies
+    return QIODevice::open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+}
+
+void FileReadDevice::close()
+{
+    if (!isOpen() && !m_file.isOpen())
+        return;
+    if (isOpen())
+        QIODevice::close();
+    m_file.close();
+    m_size = 0;
+}
+
+qint64 FileReadDevice::readData(char* data, qint64 maxSize)
+{
+    const qint64 offset = pos();
+    if (offset >= m_size)
+        return 0;
+    const qint64 n = qMin(maxSize, m_size - offset);
+#if defined(Q_OS_UNIX)
+    // A file truncated since open() yields a short read, not a fault
+    qint64 done = 0;
+    while (done < n) {
+        const ssize_t r = ::pread(m_file.handle(), data + done, size_t(n - done), off_t(offset + done));
+        if (r < 0 && errno == EINTR)
+            continue;
+        if (r < 0)
+            return done > 0 ? done : -1;
+        if (r == 0)
+            break;
+        done += r;
+    }
+    return done;
+#else
+    if (!m_file.seek(offset))
+        return -1;
+    return m_file.read(data, n);
+#endif
+}
+
+qint64 FileReadDevice::writeData(const char* data, qint64 maxSize)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxSize);
+    return -1;
+}
@@ -0,0 +1,68 @@
+/**
+ * @file FileReadDevice.h
+ * @brief Read-only QIODevice serving positional reads from a file.
+ *
+ * QPdfDocument reads through its source device in many small random-access
+ * blocks. FileReadDevice answers each block with a single positional read
+ * (pread() on Unix) instead of a seek + read system call pair, and leaves
+ * caching to the kernel's page cache, which keeps large (hundreds of MB)
+ * scanned documents cheap to reopen.
+ *
+ * The file is deliberately not memory-mapped: documents are watched and
+ * reloaded while generators rewrite them, and a mapping of a file that is
+ * truncated in place raises SIGBUS on the next access past the new end.
+ * A positional read of a shrunken file just returns fewer bytes, which
+ * pdfium reports as a damaged document until the reload replaces it.
+ *
+ * Usage:
+ * @code
+ *   auto* device = new FileReadDevice(path);
+ *   if (device->open(QIODevice::ReadOnly))
+ *       pdfDocument->load(device);  // device must outlive the document's use of it
+ * @endcode
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QIODevice>
+#include <QString>
+
+/**
+ * @class FileReadDevice
+ * @brief Random-access, read-only device over a file.
+ */
+class FileReadDevice : public QIODevice {
+    Q_OBJECT
+public:
+    /**
+     * @brief Constructs a device for @p filePath (not opened yet).
+     * @param filePath Path to the file to read
+     * @param parent Parent object
+     */
+    explicit FileReadDevice(const QString& filePath, QObject* parent = nullptr);
+    ~FileReadDevice() override;
+
+    /**
+     * @brief Opens the file. Only QIODevice::ReadOnly is supported.
+     */
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return false; }
+
+    /// Size of the file when it was opened
+    qint64 size() const override { return m_size; }
+
+    /**
+     * @brief Returns the path of the underlying file.
+     */
+    QString filePath() const { return m_file.fileName(); }
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+    qint64 writeData(const char* data, qint64 maxSize) override;
+
+private:
+    QFile m_file;
+    qint64 m_size {0};
+};
@@ -0,0 +1,189 @@
+/**
+ * @file FolderSearch.cpp
+ * @brief Implementation of the folder search.
+ */
+
+#include "FolderSearch.h"
+#include "Trace.h"
+
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QPdfDocument>
+#include <QThread>
+#include <QtConcurrent/QtConcurrentMap>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+
+namespace {
+constexpr int kContextChars = 40;
+
+QString snippetAt(const QString& text, int start, int length)
+{
+    const int from = qMax(0, start - kContextChars);
+    const int to = qMin(int(text.size()), start + length + kContextChars);
+    // simplified() keeps the snippet on one line
+    return text.mid(from, to - from).simplified();
+}
+}
+
+FolderSearch::FolderSearch(QObject* parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(1);
+    m_workers.setMaxThreadCount(qBound(1, QThread::idealThreadCount(), kMaxWorkers));
+    m_layers.setMaxThreadCount(1);
+    m_layers.setThreadPriority(QThread::LowPriority);
+}
+
+FolderSearch::~FolderSearch()
+{
+    cancel();
+    m_pool.waitForDone();
+    m_stopping = true;
+    m_layers.clear();
+    m_layers.waitForDone();
+}
+
+void FolderSearch::cancel()
+{
+    ++m_generation;
+}
+
+bool FolderSearch::isRunning() const
+{
+    return m_pool.activeThreadCount() > 0;
+}
+
+QStringList FolderSearch::pdfFiles(const QString& folder)
+{
+    QStringList files;
+    QDirIterator it(folder, {QStringLiteral("*.pdf")}, QDir::Files | QDir::Readable,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext())
+        files.append(it.next());
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+bool FolderSearch::start(const QString& folder, const QString& query, TextMatcher::Options options)
+{
+    const quint64 generation = ++m_generation;
+    m_errorString.clear();
+    TextMatcher matcher(query, options);
+    if (!matcher.isValid()) {
+        m_errorString = matcher.errorString();
+        return m_errorString.isEmpty();
+    }
+    // The pool has one thread: a cancelled search returns at its next page
+    // and this one starts right after
+    QtConcurrent::run(&m_pool, [this, folder, matcher, generation]{ run(folder, matcher, generation); });
+    return true;
+}
+
+void FolderSearch::run(const QString& folder, const TextMatcher& matcher, quint64 generation)
+{
+    TRACE_SCOPE("FolderSearch::run");
+    QElapsedTimer timer;
+    timer.start();
+    QStringList files = pdfFiles(folder);
+    if (m_generation.load() != generation)
+        return;
+    emit started(generation, int(files.size()));
+
+    std::atomic<int> hitCount {0};
+    QtConcurrent::blockingMap(&m_workers, files, [&](const QString& filePath){
+        if (m_generation.load() != generation)
+            return;
+        const FolderFileResult result = searchFile(filePath, matcher, generation);
+        if (m_generation.load() != generation)
+            return;
+        hitCount += result.hitCount;
+        emit fileSearched(generation, result);
+        if (!result.cached && result.error.isEmpty())
+            buildLayer(result.filePath);
+    });
+    if (m_generation.load() != generation)
+        return;
+    emit finished(generation, int(files.size()), hitCount.load(), timer.nsecsElapsed());
+}
+
+bool FolderSearch::pageTexts(const QFileInfo& fi, quint64 generation, TextLayerPtr* layer,
+                             QStringList* pages, FolderFileResult* result) const
+{
+    const QByteArray fp = TextLayer::fingerprint(fi.absoluteFilePath());
+    if (!fp.isEmpty() && (*layer = TextLayer::open(TextLayer::layerPath(fp), fp))) {
+        result->cached = true;
+        return true;
+    }
+
+    // Text only: character boxes are left to the layer build after the search
+    // Created and destroyed on this worker; never shared with other threads
+    QPdfDocument doc;
+    if (doc.load(fi.absoluteFilePath()) != QPdfDocument::Error::None) {
+        result->error = tr("Could not open file");
+        return false;
+    }
+    const int pageCount = doc.pageCount();
+    pages->reserve(pageCount);
+    for (int page = 0; page < pageCount; ++page) {
+        if (m_generation.load() != generation)
+            return false;
+        pages->append(doc.getAllText(page).text());
+    }
+    return true;
+}
+
+void FolderSearch::buildLayer(const QString& filePath)
+{
+    QtConcurrent::run(&m_layers, [this, filePath]{
+        TRACE_SCOPE("FolderSearch::buildLayer");
+        auto stopping = [this]{ return m_stopping.load(); };
+        const QByteArray fp = TextLayer::fingerprint(filePath);
+        if (stopping() || fp.isEmpty())
+            return;
+        const QString path = TextLayer::layerPath(fp);
+        // Built by the viewer or an earlier request in the meantime
+        if (TextLayer::open(path, fp))
+            return;
+        QPdfDocument doc;
+        if (doc.load(filePath) != QPdfDocument::Error::None
+            || !TextLayer::build(doc.pageCount(), DocumentPool::localRunner(doc, stopping), fp, path))
+            return;
+        const TextLayerPtr layer = TextLayer::open(path, fp);
+        if (!layer || !layer->verify())
+            QFile::remove(path);
+        TextLayer::trimCache();
+    });
+}
+
+FolderFileResult FolderSearch::searchFile(const QString& filePath, const TextMatcher& matcher,
+                                          quint64 generation) const
+{
+    TRACE_SCOPE("FolderSearch::searchFile");
+    FolderFileResult result;
+    const QFileInfo fi(filePath);
+    result.filePath = fi.absoluteFilePath();
+
+    TextLayerPtr layer;
+    QStringList pages;
+    if (!pageTexts(fi, generation, &layer, &pages, &result))
+        return result;
+    result.pageCount = layer ? layer->pageCount() : int(pages.size());
+
+    // One page of folded text at a time keeps memory at the mapped or raw text
+    for (int page = 0; page < result.pageCount; ++page) {
+        if (m_generation.load() != generation)
+            break;
+        const FoldedText text = FoldedText::fold(layer ? layer->pageText(page).toString() : pages.at(page));
+        for (const TextMatch& match : matcher.findAll(text)) {
+            ++result.hitCount;
+            if (result.hits.size() < kMaxHitsPerFile)
+                result.hits.append({page, match.start, match.length,
+                                    snippetAt(text.original(), match.start, match.length)});
+        }
+    }
+    return result;
+}
@@ -0,0 +1,135 @@
+/**
+ * @file FolderSearch.h
+ * @brief Searches every PDF below a folder on worker threads.
+ *
+ * FolderSearch answers "which of these files mention the term": it lists
+ * the PDFs below a folder and searches several of them at once, each
+ * worker with its own QPdfDocument that is closed as soon as the file is
+ * done. Memory stays bounded by the worker count: at most kMaxWorkers
+ * documents are open, only the text of the file being searched is held,
+ * and each file reports its hit count plus at most kMaxHitsPerFile hits
+ * with context snippets.
+ *
+ * Files with a TextLayer are searched through it. Files without one have
+ * their page text extracted and searched first; their layer is then built
+ * on a low-priority thread, so searching the same folder again, or opening
+ * one of its files, maps the text instead of running pdfium, while the
+ * first search does not wait for character boxes it has no use for. QtPdf
+ * serializes pdfium calls, so the first search of a folder gains mostly
+ * from overlapping file I/O, folding and matching with extraction.
+ *
+ * Results are emitted per file as they are done (in completion order);
+ * like SearchEngine, each search has a generation and starting a new one
+ * cancels the running one at the next page.
+ *
+ * Usage:
+ * @code
+ *   connect(search, &FolderSearch::fileSearched, this, &Panel::addFile);
+ *   search->start(QStringLiteral("/cases/1234"), QStringLiteral("invoice"), TextMatcher::WholeWord);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+
+#include "TextLayer.h"
+#include "TextSearch.h"
+
+/**
+ * @struct FolderHit
+ * @brief One match in a file of the folder.
+ */
+struct FolderHit {
+    int page {0};
+    int start {0};               ///< First character in the page text
+    int length {0};
+    QString snippet;             ///< Surrounding text on one line
+};
+
+/**
+ * @struct FolderFileResult
+ * @brief Outcome of searching one file.
+ */
+struct FolderFileResult {
+    QString filePath;
+    int pageCount {0};
+    int hitCount {0};            ///< All hits, also those not listed
+    QVector<FolderHit> hits;     ///< First hits in page order, at most kMaxHitsPerFile
+    bool cached {false};         ///< Text came from an existing text layer
+    QString error;               ///< Set if the file could not be opened
+};
+
+/**
+ * @class FolderSearch
+ * @brief Parallel, cancellable search over the PDF files of a folder.
+ */
+class FolderSearch : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kMaxWorkers = 4;          ///< Documents open at once
+    static constexpr int kMaxHitsPerFile = 100;
+
+    explicit FolderSearch(QObject* parent = nullptr);
+    ~FolderSearch() override;
+
+    /**
+     * @brief Starts searching the PDFs below @p folder, cancelling the running search.
+     * @return False if @p query is an invalid pattern (see errorString())
+     */
+    bool start(const QString& folder, const QString& query, TextMatcher::Options options);
+
+    /// Cancels the running search; its remaining results are not emitted.
+    void cancel();
+
+    /// Generation of the latest search; results carrying another one are stale
+    quint64 generation() const { return m_generation.load(); }
+
+    bool isRunning() const;
+
+    /// Error of the last start() with an invalid pattern
+    QString errorString() const { return m_errorString; }
+
+    /// PDF files below @p folder, recursively, sorted by path
+    static QStringList pdfFiles(const QString& folder);
+
+signals:
+    /// The files of @p generation were listed; @p fileCount will be searched.
+    void started(quint64 generation, int fileCount);
+
+    /**
+     * @brief One file of @p generation was searched (with or without hits).
+     *
+     * Emitted from a worker thread; connect with the default (queued)
+     * connection type.
+     */
+    void fileSearched(quint64 generation, const FolderFileResult& result);
+
+    /// The search of @p generation went through all files.
+    void finished(quint64 generation, int fileCount, int hitCount, qint64 elapsedNs);
+
+private:
+    void run(const QString& folder, const TextMatcher& matcher, quint64 generation);
+    FolderFileResult searchFile(const QString& filePath, const TextMatcher& matcher,
+                                quint64 generation) const;
+    /**
+     * @brief Page text of @p fi from its text layer, or extracted into @p pages.
+     * @return False if cancelled or the file cannot be opened
+     */
+    bool pageTexts(const QFileInfo& fi, quint64 generation, TextLayerPtr* layer,
+                   QStringList* pages, FolderFileResult* result) const;
+    /// Queues building the text layer of @p filePath on m_layers
+    void buildLayer(const QString& filePath);
+
+    QThreadPool m_pool;                     ///< One thread: lists files and drives the workers
+    QThreadPool m_workers;                  ///< kMaxWorkers threads, one file each
+    QThreadPool m_layers;                   ///< One low-priority thread building text layers
+    std::atomic<bool> m_stopping {false};   ///< Set on destruction; stops layer builds
+    std::atomic<quint64> m_generation {0};
+    QString m_errorString;
+};
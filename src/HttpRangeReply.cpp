@@ -0,0 +1,421 @@
+/**
+ * @file HttpRangeReply.cpp
+ * @brief Implementation of the range-fetching network reply.
+ */
+
+#include "HttpRangeReply.h"
+#include "Trace.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFileInfo>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+namespace {
+constexpr quint32 kIndexMagic = 0x51505648;   // "QPVH"
+constexpr quint16 kIndexVersion = 1;
+}
+
+HttpRangeReply::HttpRangeReply(const QUrl& url, QNetworkAccessManager* manager, QObject* parent)
+    : QNetworkReply(parent)
+    , m_manager(manager)
+{
+    setUrl(url);
+    setRequest(QNetworkRequest(url));
+    setOperation(QNetworkAccessManager::GetOperation);
+    setOpenMode(QIODevice::ReadOnly);
+
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/http/");
+    const QString key = QString::fromLatin1(
+        QCryptographicHash::hash(url.toString(QUrl::FullyEncoded).toUtf8(), QCryptographicHash::Sha1).toHex());
+    m_dataPath = dir + key + QStringLiteral(".data");
+    m_indexPath = dir + key + QStringLiteral(".index");
+    m_data.setFileName(m_dataPath);
+    loadIndex();
+    requestMissing();
+}
+
+HttpRangeReply::~HttpRangeReply()
+{
+    if (m_current) {
+        disconnect(m_current, nullptr, this, nullptr);
+        m_current->abort();
+        m_current->deleteLater();
+    }
+    if (m_data.isOpen()) {
+        m_data.flush();
+        saveIndex();
+    }
+}
+
+bool HttpRangeReply::isHttpUrl(const QString& location)
+{
+    return location.startsWith(QLatin1String("http://"), Qt::CaseInsensitive)
+        || location.startsWith(QLatin1String("https://"), Qt::CaseInsensitive);
+}
+
+bool HttpRangeReply::isComplete() const
+{
+    return m_validated && m_total >= 0 && m_data.isOpen() && m_chunks.count(true) == m_chunks.size();
+}
+
+qint64 HttpRangeReply::bytesAvailable() const
+{
+    return m_buffer.size() + QNetworkReply::bytesAvailable();
+}
+
+void HttpRangeReply::abort()
+{
+    fail(OperationCanceledError, tr("Operation canceled"));
+}
+
+qint64 HttpRangeReply::readData(char* data, qint64 maxSize)
+{
+    const qint64 n = qMin(maxSize, qint64(m_buffer.size()));
+    if (n <= 0)
+        return isFinished() ? -1 : 0;
+    std::memcpy(data, m_buffer.constData(), size_t(n));
+    m_buffer.remove(0, n);
+    return n;
+}
+
+qint64 HttpRangeReply::chunkCount() const
+{
+    return m_total <= 0 ? 0 : (m_total + kChunkBytes - 1) / kChunkBytes;
+}
+
+void HttpRangeReply::requestMissing()
+{
+    // Before validation, ask for the first chunk not cached: its response
+    // both validates the cache and continues the file
+    const qint64 chunks = chunkCount();
+    qint64 chunk = 0;
+    if (m_validated) {
+        chunk = m_delivered / kChunkBytes;
+    } else {
+        while (chunk < chunks && m_chunks.testBit(int(chunk)))
+            ++chunk;
+        if (chunk == chunks)
+            chunk = 0;
+    }
+
+    QByteArray range = "bytes=" + QByteArray::number(chunk * kChunkBytes) + '-';
+    if (m_total > 0) {
+        // All missing chunks up to the next cached one in one request
+        qint64 end = chunk + 1;
+        while (end < chunks && !m_chunks.testBit(int(end)))
+            ++end;
+        range += QByteArray::number(qMin(m_total, end * kChunkBytes) - 1);
+    }
+
+    QNetworkRequest request(url());
+    request.setRawHeader("Range", range);
+    ++m_requestCount;
+    m_requestStartNs = Trace::now();
+    m_current = m_manager->get(request);
+    connect(m_current, &QNetworkReply::metaDataChanged, this, &HttpRangeReply::onMetaData);
+    connect(m_current, &QIODevice::readyRead, this, &HttpRangeReply::onReadyRead);
+    connect(m_current, &QNetworkReply::finished, this, &HttpRangeReply::onRequestFinished);
+}
+
+void HttpRangeReply::onMetaData()
+{
+    QNetworkReply* reply = m_current;
+    if (!reply)
+        return;
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    qint64 start = 0;
+    qint64 total = -1;
+    if (status == 206) {
+        // "bytes first-last/total"
+        const QByteArray range = reply->rawHeader("Content-Range");
+        const int space = range.indexOf(' ');
+        const int dash = range.indexOf('-', space + 1);
+        const int slash = range.indexOf('/', dash + 1);
+        bool startOk = false;
+        bool totalOk = false;
+        if (space >= 0 && dash > space && slash > dash) {
+            start = range.mid(space + 1, dash - space - 1).toLongLong(&startOk);
+            total = range.mid(slash + 1).toLongLong(&totalOk);
+        }
+        if (!startOk || !totalOk || start < 0 || total < 0) {
+            fail(ProtocolFailure, tr("Invalid Content-Range header: %1").arg(QString::fromLatin1(range)));
+            return;
+        }
+    } else if (status == 200) {
+        // No range support: the whole file follows
+        const QVariant length = reply->header(QNetworkRequest::ContentLengthHeader);
+        if (!length.isValid()) {
+            fail(ProtocolFailure, tr("The server did not report the file size"));
+            return;
+        }
+        total = length.toLongLong();
+    } else {
+        // Redirects are followed; errors are reported when the request finishes
+        return;
+    }
+
+    if (!m_validated) {
+        QByteArray validator = reply->rawHeader("ETag");
+        if (validator.isEmpty())
+            validator = reply->rawHeader("Last-Modified");
+        // Without a validator the cached bytes cannot be trusted
+        if (total != m_total || validator != m_validator || validator.isEmpty()) {
+            resetCache(total, validator);
+            if (start != 0) {
+                disconnect(reply, nullptr, this, nullptr);
+                reply->abort();
+                reply->deleteLater();
+                m_current = nullptr;
+                m_validated = true;
+                announce();
+                requestMissing();
+                return;
+            }
+        }
+        m_validated = true;
+        announce();
+        deliverCachedChunks();
+        if (m_delivered >= m_total) {
+            // Everything was cached: the body is not needed
+            disconnect(reply, nullptr, this, nullptr);
+            reply->abort();
+            reply->deleteLater();
+            m_current = nullptr;
+            finishReply();
+            return;
+        }
+    } else if (total != m_total) {
+        fail(ContentReSendError, tr("The file changed on the server while loading"));
+        return;
+    }
+    m_currentStart = start;
+    m_currentPos = start;
+}
+
+void HttpRangeReply::onReadyRead()
+{
+    if (!m_current || !m_validated)
+        return;
+    const QByteArray data = m_current->readAll();
+    if (data.isEmpty())
+        return;
+    const qint64 pos = m_currentPos;
+    m_currentPos += data.size();
+    m_fetchedBytes += data.size();
+
+    if (m_data.isOpen()) {
+        if (m_data.seek(pos) && m_data.write(data) == data.size())
+            markChunks(pos, m_currentPos);
+        else
+            m_data.close();   // Keep loading, stop caching
+    }
+    // A full response (status 200) may repeat bytes delivered from the cache
+    if (pos <= m_delivered && m_currentPos > m_delivered)
+        deliver(data.mid(m_delivered - pos));
+}
+
+void HttpRangeReply::onRequestFinished()
+{
+    QNetworkReply* reply = m_current;
+    m_current = nullptr;
+    if (!reply)
+        return;
+    reply->deleteLater();
+    Trace::complete("HttpRangeReply::request", m_requestStartNs, Trace::now());
+
+    if (reply->error() != NoError) {
+        if (!m_validated && m_total >= 0 && m_data.isOpen() && m_chunks.count(true) == m_chunks.size()) {
+            // Server unreachable, but the whole file is cached
+            m_validated = true;
+            announce();
+            deliverCachedChunks();
+            finishReply();
+            return;
+        }
+        fail(reply->error(), reply->errorString());
+        return;
+    }
+    if (!m_validated) {
+        fail(ProtocolFailure, tr("Unexpected HTTP status %1")
+                                  .arg(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt()));
+        return;
+    }
+
+    if (m_data.isOpen()) {
+        m_data.flush();
+        saveIndex();
+    }
+    deliverCachedChunks();
+    if (m_delivered < m_total) {
+        if (m_currentPos <= m_currentStart) {
+            fail(ProtocolFailure, tr("The server returned no data"));
+            return;
+        }
+        requestMissing();
+        return;
+    }
+    finishReply();
+}
+
+void HttpRangeReply::announce()
+{
+    setHeader(QNetworkRequest::ContentLengthHeader, m_total);
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 200);
+    emit metaDataChanged();
+}
+
+void HttpRangeReply::deliverCachedChunks()
+{
+    QByteArray block;
+    qint64 pos = m_delivered;
+    while (pos < m_total && m_data.isOpen()) {
+        const qint64 chunk = pos / kChunkBytes;
+        if (!m_chunks.testBit(int(chunk)) || !m_data.seek(pos))
+            break;
+        const qint64 end = qMin(m_total, (chunk + 1) * kChunkBytes);
+        const QByteArray data = m_data.read(end - pos);
+        if (data.size() != end - pos)
+            break;
+        block += data;
+        pos = end;
+    }
+    if (block.isEmpty())
+        return;
+    m_cachedBytes += block.size();
+    deliver(block);
+}
+
+void HttpRangeReply::deliver(const QByteArray& data)
+{
+    m_buffer += data;
+    m_delivered += data.size();
+    emit readyRead();
+    emit downloadProgress(m_delivered, m_total);
+}
+
+void HttpRangeReply::markChunks(qint64 from, qint64 to)
+{
+    // Chunks lying completely inside [m_currentStart, to)
+    const qint64 first = qMax((m_currentStart + kChunkBytes - 1) / kChunkBytes, from / kChunkBytes);
+    const qint64 last = to >= m_total ? chunkCount() : to / kChunkBytes;
+    for (qint64 chunk = first; chunk < last; ++chunk)
+        m_chunks.setBit(int(chunk));
+}
+
+void HttpRangeReply::resetCache(qint64 total, const QByteArray& validator)
+{
+    m_total = total;
+    m_validator = validator;
+    m_chunks = QBitArray(int(chunkCount()), false);
+    m_data.close();
+    trimCache(total);
+    // Sparse where the file system allows it; chunks are filled in as they arrive
+    if (!QDir().mkpath(QFileInfo(m_dataPath).absolutePath())
+        || !m_data.open(QIODevice::ReadWrite | QIODevice::Truncate) || !m_data.resize(total))
+        m_data.close();
+    saveIndex();
+}
+
+void HttpRangeReply::trimCache(qint64 reserveBytes) const
+{
+    TRACE_SCOPE("HttpRangeReply::trimCache");
+    // Newest first; every change of a download rewrites its index
+    const QFileInfo self(m_indexPath);
+    const QFileInfoList indexes = self.absoluteDir().entryInfoList({QStringLiteral("*.index")},
+                                                                   QDir::Files, QDir::Time);
+    qint64 total = reserveBytes;
+    for (const QFileInfo& index : indexes) {
+        if (index.fileName() == self.fileName())
+            continue;
+        const QString dataPath = index.absolutePath() + QLatin1Char('/') + index.completeBaseName()
+                               + QStringLiteral(".data");
+        const qint64 size = QFileInfo(dataPath).size() + index.size();
+        total += size;
+        if (total > kCacheBudgetBytes && QFile::remove(index.absoluteFilePath())) {
+            QFile::remove(dataPath);
+            total -= size;
+        }
+    }
+}
+
+bool HttpRangeReply::loadIndex()
+{
+    QFile file(m_indexPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_2);
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != kIndexMagic || version != kIndexVersion)
+        return false;
+
+    QString storedUrl;
+    qint64 total = -1;
+    QByteArray validator;
+    QBitArray chunks;
+    in >> storedUrl >> total >> validator >> chunks;
+    if (in.status() != QDataStream::Ok || storedUrl != url().toString(QUrl::FullyEncoded) || total < 0
+        || chunks.size() != (total + kChunkBytes - 1) / kChunkBytes)
+        return false;
+    if (!m_data.open(QIODevice::ReadWrite) || m_data.size() != total) {
+        m_data.close();
+        return false;
+    }
+    m_total = total;
+    m_validator = validator;
+    m_chunks = chunks;
+    return true;
+}
+
+void HttpRangeReply::saveIndex()
+{
+    if (m_total < 0 || !m_data.isOpen())
+        return;
+    QSaveFile file(m_indexPath);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_2);
+    out << kIndexMagic << kIndexVersion << url().toString(QUrl::FullyEncoded)
+        << m_total << m_validator << m_chunks;
+    if (out.status() == QDataStream::Ok)
+        file.commit();
+    else
+        file.cancelWriting();
+}
+
+void HttpRangeReply::fail(NetworkError code, const QString& message)
+{
+    if (isFinished())
+        return;
+    if (m_current) {
+        disconnect(m_current, nullptr, this, nullptr);
+        m_current->abort();
+        m_current->deleteLater();
+        m_current = nullptr;
+    }
+    setError(code, message);
+    emit errorOccurred(code);
+    finishReply();
+}
+
+void HttpRangeReply::finishReply()
+{
+    if (isFinished())
+        return;
+    if (m_data.isOpen()) {
+        m_data.flush();
+        saveIndex();
+    }
+    setFinished(true);
+    emit finished();
+}
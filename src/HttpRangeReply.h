@@ -0,0 +1,129 @@
+/**
+ * @file HttpRangeReply.h
+ * @brief Progressive download of a remote PDF with HTTP range requests.
+ *
+ * QPdfDocument::load(QIODevice*) accepts a QNetworkReply and parses the
+ * document while it arrives: a linearized PDF becomes Ready (and its
+ * first page can be shown) once the first page's objects are in, long
+ * before the whole file is. HttpRangeReply is such a reply, built from
+ * range requests instead of one GET:
+ *
+ * - Fetched bytes are written to a sparse file in the cache directory,
+ *   with an index of the complete chunks (kChunkBytes each). Reopening the
+ *   URL serves cached chunks from disk and requests only missing ones.
+ * - The cache is validated against the ETag (or Last-Modified) and size
+ *   of the first response and dropped if the file changed on the server.
+ *   A fully cached file is used as is when the server cannot be reached.
+ * - Servers without range support (status 200) are streamed as a whole.
+ * - The cache directory is kept under kCacheBudgetBytes: when a download
+ *   starts, the least recently used files (by the time their index was
+ *   last written) are removed to make room for it.
+ *
+ * Bytes are delivered to the document in file order, since QtPdf copies
+ * a sequential device into its own buffer; a non-linearized file is
+ * therefore only usable once it has arrived completely. When the reply
+ * has finished, cacheFilePath() is a complete local copy that features
+ * needing a file (thumbnails, text export, Save As) can use.
+ *
+ * tools/RangeServer.cpp is a local HTTP server with range support and
+ * optional throttling for trying this out.
+ *
+ * Usage:
+ * @code
+ *   auto* reply = new HttpRangeReply(QUrl("https://example.com/big.pdf"), manager, doc);
+ *   doc->load(reply);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QBitArray>
+#include <QByteArray>
+#include <QFile>
+#include <QNetworkReply>
+#include <QPointer>
+#include <QString>
+#include <QUrl>
+
+class QNetworkAccessManager;
+
+/**
+ * @class HttpRangeReply
+ * @brief Network reply assembling a remote file from cached and fetched ranges.
+ */
+class HttpRangeReply : public QNetworkReply {
+    Q_OBJECT
+public:
+    /// Granularity of the range cache
+    static constexpr qint64 kChunkBytes = 256 * 1024;
+    /// All cached files together
+    static constexpr qint64 kCacheBudgetBytes = 2048ll * 1024 * 1024;
+
+    /**
+     * @brief Starts loading @p url through @p manager.
+     */
+    HttpRangeReply(const QUrl& url, QNetworkAccessManager* manager, QObject* parent = nullptr);
+    ~HttpRangeReply() override;
+
+    /// True if @p location is an http or https URL
+    static bool isHttpUrl(const QString& location);
+
+    /// Sparse cache file of the URL; a complete copy once isComplete()
+    QString cacheFilePath() const { return m_dataPath; }
+
+    /// True once every byte has been received and written to the cache file
+    bool isComplete() const;
+
+    /// Bytes served from the cache
+    qint64 cachedBytes() const { return m_cachedBytes; }
+
+    /// Bytes received from the server
+    qint64 fetchedBytes() const { return m_fetchedBytes; }
+
+    /// Number of HTTP requests made
+    int requestCount() const { return m_requestCount; }
+
+    qint64 bytesAvailable() const override;
+    void abort() override;
+
+protected:
+    qint64 readData(char* data, qint64 maxSize) override;
+
+private:
+    qint64 chunkCount() const;
+    void requestMissing();
+    void onMetaData();
+    void onReadyRead();
+    void onRequestFinished();
+    void announce();
+    void deliverCachedChunks();
+    void deliver(const QByteArray& data);
+    void markChunks(qint64 from, qint64 to);
+    void resetCache(qint64 total, const QByteArray& validator);
+    /// Removes least recently used files of other URLs until @p reserveBytes more fit the budget
+    void trimCache(qint64 reserveBytes) const;
+    bool loadIndex();
+    void saveIndex();
+    void fail(NetworkError code, const QString& message);
+    void finishReply();
+
+    QNetworkAccessManager* m_manager {nullptr};
+    QPointer<QNetworkReply> m_current;
+    qint64 m_currentStart {0};      ///< File offset of the first body byte of m_current
+    qint64 m_currentPos {0};        ///< File offset of the next body byte of m_current
+    qint64 m_requestStartNs {0};
+    bool m_validated {false};       ///< Cache checked against the server (or trusted offline)
+
+    QString m_dataPath;
+    QString m_indexPath;
+    QFile m_data;
+    QBitArray m_chunks;             ///< Complete chunks in m_data
+    qint64 m_total {-1};
+    QByteArray m_validator;         ///< ETag or Last-Modified of the cached bytes
+
+    QByteArray m_buffer;            ///< Delivered, not yet read
+    qint64 m_delivered {0};         ///< File offset of the next byte to deliver
+    qint64 m_cachedBytes {0};
+    qint64 m_fetchedBytes {0};
+    int m_requestCount {0};
+};
@@ -0,0 +1,343 @@
+/**
+ * @file InstanceServer.cpp
+ * @brief Implementation of the single-instance command protocol.
+ */
+
+#include "InstanceServer.h"
+#include "MainWindow.h"
+#include "HttpRangeReply.h"
+
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QPointer>
+#include <QtEndian>
+#include <QUrl>
+
+namespace {
+constexpr char kMagic[4] = {'Q', 'P', 'V', 'C'};
+constexpr int kHeaderSize = 4 + 2 + 4;
+constexpr quint32 kMaxPayloadBytes = 16 * 1024 * 1024;
+constexpr int kProbeTimeoutMs = 150;
+
+double elapsedMs(const QElapsedTimer& timer)
+{
+    return double(timer.nsecsElapsed()) / 1e6;
+}
+
+QJsonObject errorResult(const QString& cmd, const QString& message)
+{
+    return QJsonObject{{QStringLiteral("cmd"), cmd},
+                       {QStringLiteral("ok"), false},
+                       {QStringLiteral("error"), message}};
+}
+}
+
+struct InstanceServer::Batch {
+    QJsonArray commands;
+    int next {0};
+    QJsonArray results;
+    bool ok {true};
+    QElapsedTimer timer;
+    std::function<void(const QJsonObject&)> onDone;
+};
+
+InstanceServer::InstanceServer(MainWindow* window, QObject* parent)
+    : QObject(parent)
+    , m_window(window)
+{
+}
+
+bool InstanceServer::listen(const QString& name)
+{
+    if (!m_server) {
+        m_server = new QLocalServer(this);
+        connect(m_server, &QLocalServer::newConnection, this, [this]{
+            while (QLocalSocket* client = m_server->nextPendingConnection())
+                handleConnection(client);
+        });
+    }
+    QLocalServer::removeServer(name);
+    return m_server->listen(name);
+}
+
+QByteArray InstanceServer::encodeFrame(const QJsonObject& message)
+{
+    const QByteArray payload = QJsonDocument(message).toJson(QJsonDocument::Compact);
+    QByteArray frame;
+    frame.reserve(kHeaderSize + payload.size());
+    frame.append(kMagic, 4);
+    char header[6];
+    qToBigEndian<quint16>(kProtocolVersion, header);
+    qToBigEndian<quint32>(quint32(payload.size()), header + 2);
+    frame.append(header, 6);
+    frame.append(payload);
+    return frame;
+}
+
+InstanceServer::FrameStatus InstanceServer::decodeFrame(QByteArray& buffer, QJsonObject* message, quint16* version)
+{
+    if (buffer.size() < 4)
+        return FrameStatus::Incomplete;
+    if (!buffer.startsWith(QByteArray::fromRawData(kMagic, 4)))
+        return FrameStatus::Invalid;
+    if (buffer.size() < kHeaderSize)
+        return FrameStatus::Incomplete;
+
+    const quint16 v = qFromBigEndian<quint16>(buffer.constData() + 4);
+    const quint32 length = qFromBigEndian<quint32>(buffer.constData() + 6);
+    if (length > kMaxPayloadBytes)
+        return FrameStatus::Invalid;
+    if (quint32(buffer.size() - kHeaderSize) < length)
+        return FrameStatus::Incomplete;
+
+    QJsonParseError err;
+    const QJsonDocument doc = QJsonDocument::fromJson(buffer.mid(kHeaderSize, int(length)), &err);
+    buffer.remove(0, kHeaderSize + int(length));
+    if (err.error != QJsonParseError::NoError || !doc.isObject())
+        return FrameStatus::Invalid;
+    if (message)
+        *message = doc.object();
+    if (version)
+        *version = v;
+    return FrameStatus::Complete;
+}
+
+void InstanceServer::handleConnection(QLocalSocket* client)
+{
+    auto buffer = std::make_shared<QByteArray>();
+    connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+    connect(client, &QLocalSocket::readyRead, client, [this, client, buffer]{
+        buffer->append(client->readAll());
+
+        QJsonObject request;
+        quint16 version = 0;
+        const bool framed = buffer->startsWith(QByteArray::fromRawData(kMagic, 4));
+        switch (decodeFrame(*buffer, &request, &version)) {
+        case FrameStatus::Incomplete:
+            return;
+        case FrameStatus::Invalid: {
+            if (framed) {
+                client->disconnectFromServer();
+                return;
+            }
+            // Legacy client: a single QDataStream QString with the path
+            QDataStream in(*buffer);
+            in.setVersion(QDataStream::Qt_6_2);
+            in.startTransaction();
+            QString path;
+            in >> path;
+            if (!in.commitTransaction())
+                return;
+            buffer->clear();
+            QJsonArray commands;
+            if (!path.isEmpty())
+                commands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("open")},
+                                            {QStringLiteral("path"), path}});
+            commands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("activate")}});
+            client->disconnectFromServer();
+            execute(commands);
+            return;
+        }
+        case FrameStatus::Complete:
+            break;
+        }
+
+        QPointer<QLocalSocket> guard(client);
+        auto reply = [guard](const QJsonObject& message){
+            if (!guard || guard->state() != QLocalSocket::ConnectedState)
+                return;
+            guard->write(encodeFrame(message));
+            guard->flush();
+        };
+
+        if (version > kProtocolVersion) {
+            reply(QJsonObject{{QStringLiteral("version"), kProtocolVersion},
+                              {QStringLiteral("ok"), false},
+                              {QStringLiteral("error"), QStringLiteral("unsupported protocol version %1").arg(version)}});
+            return;
+        }
+        execute(request.value(QStringLiteral("commands")).toArray(), reply);
+    });
+}
+
+void InstanceServer::execute(const QJsonArray& commands, std::function<void(const QJsonObject&)> onDone)
+{
+    auto batch = std::make_shared<Batch>();
+    batch->commands = commands;
+    batch->onDone = std::move(onDone);
+    batch->timer.start();
+    runNext(batch);
+}
+
+void InstanceServer::runNext(const std::shared_ptr<Batch>& batch)
+{
+    while (batch->next < batch->commands.size()) {
+        const QJsonObject command = batch->commands.at(batch->next++).toObject();
+        const QString name = command.value(QStringLiteral("cmd")).toString();
+        QElapsedTimer timer;
+        timer.start();
+
+        QJsonObject result;
+        if (name == QLatin1String("open")) {
+            const QString location = command.value(QStringLiteral("path")).toString();
+            const QString path = HttpRangeReply::isHttpUrl(location) ? QUrl(location).toString()
+                                                                     : QFileInfo(location).absoluteFilePath();
+            m_window->openPdf(path);
+            const QString original = command.value(QStringLiteral("original")).toString();
+            if (!original.isEmpty())
+                m_window->setOriginalFile(original);
+
+            if (m_window->isLoading()) {
+                // Continue the batch once the document has loaded (or failed)
+                auto ready = std::make_shared<QMetaObject::Connection>();
+                auto failed = std::make_shared<QMetaObject::Connection>();
+                auto resume = [this, batch, path, timer, ready, failed]{
+                    disconnect(*ready);
+                    disconnect(*failed);
+                    QJsonObject r = openResult(path);
+                    r.insert(QStringLiteral("elapsedMs"), elapsedMs(timer));
+                    batch->ok = batch->ok && r.value(QStringLiteral("ok")).toBool();
+                    batch->results.append(r);
+                    runNext(batch);
+                };
+                *ready = connect(m_window, &MainWindow::documentReady, this, resume);
+                *failed = connect(m_window, &MainWindow::documentLoadFailed, this, resume);
+                return;
+            }
+            result = openResult(path);
+        } else if (name == QLatin1String("search") || name == QLatin1String("multisearch")) {
+            result = executeCommand(command);
+            const bool multi = name == QLatin1String("multisearch");
+            if (multi ? m_window->isMultiTermSearching() : m_window->isSearching()) {
+                // Reply with the final count once the search engine is done
+                auto finished = std::make_shared<QMetaObject::Connection>();
+                auto resume = [this, batch, result, timer, finished](int count) mutable {
+                    disconnect(*finished);
+                    result.insert(QStringLiteral("results"), count);
+                    result.insert(QStringLiteral("elapsedMs"), elapsedMs(timer));
+                    batch->results.append(result);
+                    runNext(batch);
+                };
+                *finished = multi ? connect(m_window, &MainWindow::multiTermSearchFinished, this, resume)
+                                  : connect(m_window, &MainWindow::searchFinished, this, resume);
+                return;
+            }
+        } else {
+            result = executeCommand(command);
+        }
+
+        result.insert(QStringLiteral("elapsedMs"), elapsedMs(timer));
+        batch->ok = batch->ok && result.value(QStringLiteral("ok")).toBool();
+        batch->results.append(result);
+    }
+
+    if (batch->onDone) {
+        batch->onDone(QJsonObject{{QStringLiteral("version"), kProtocolVersion},
+                                  {QStringLiteral("ok"), batch->ok},
+                                  {QStringLiteral("elapsedMs"), elapsedMs(batch->timer)},
+                                  {QStringLiteral("results"), batch->results}});
+    }
+}
+
+QJsonObject InstanceServer::openResult(const QString& path) const
+{
+    if (m_window->currentFilePath() != path)
+        return errorResult(QStringLiteral("open"), QStringLiteral("could not open %1").arg(path));
+    return QJsonObject{{QStringLiteral("cmd"), QStringLiteral("open")},
+                       {QStringLiteral("ok"), true},
+                       {QStringLiteral("path"), path},
+                       {QStringLiteral("pages"), m_window->pageCount()}};
+}
+
+QJsonObject InstanceServer::executeCommand(const QJsonObject& command)
+{
+    const QString name = command.value(QStringLiteral("cmd")).toString();
+    QJsonObject result{{QStringLiteral("cmd"), name}, {QStringLiteral("ok"), true}};
+
+    if (name == QLatin1String("ping")) {
+        result.insert(QStringLiteral("version"), kProtocolVersion);
+    } else if (name == QLatin1String("activate")) {
+        m_window->raiseAndActivate();
+    } else if (name == QLatin1String("goto")) {
+        const int page = command.value(QStringLiteral("page")).toInt(0);
+        if (!m_window->goToPage(page - 1))
+            return errorResult(name, QStringLiteral("page %1 out of range").arg(page));
+    } else if (name == QLatin1String("zoom")) {
+        const QJsonValue mode = command.value(QStringLiteral("mode"));
+        const QString spec = mode.isDouble() ? QString::number(mode.toDouble()) : mode.toString();
+        if (!m_window->applyZoom(spec))
+            return errorResult(name, QStringLiteral("invalid zoom '%1'").arg(spec));
+    } else if (name == QLatin1String("search")) {
+        if (command.contains(QStringLiteral("regex")) || command.contains(QStringLiteral("wholeWord")))
+            m_window->setSearchMode(command.value(QStringLiteral("wholeWord")).toBool(),
+                                    command.value(QStringLiteral("regex")).toBool());
+        m_window->search(command.value(QStringLiteral("text")).toString());
+        // Final once the search finished; runNext() waits for that
+        result.insert(QStringLiteral("results"), m_window->searchResultCount());
+    } else if (name == QLatin1String("memory")) {
+        result.insert(QStringLiteral("memory"), m_window->memoryReport().toJson());
+    } else if (name == QLatin1String("multisearch")) {
+        const QJsonValue terms = command.value(QStringLiteral("terms"));
+        QStringList list;
+        if (terms.isArray()) {
+            for (const QJsonValue& t : terms.toArray())
+                list << t.toString();
+        } else {
+            list << terms.toString();
+        }
+        m_window->triggerMultiTermSearch(list.join(QLatin1Char(';')));
+        // Final once the search finished; runNext() waits for that
+        result.insert(QStringLiteral("results"), m_window->multiTermMatchCount());
+    } else {
+        return errorResult(name, QStringLiteral("unknown command"));
+    }
+    return result;
+}
+
+bool InstanceServer::sendToRunningInstance(const QString& name, const QJsonArray& commands,
+                                           int timeoutMs, QJsonObject* reply)
+{
+    QLocalSocket socket;
+    socket.connectToServer(name);
+    if (!socket.waitForConnected(kProbeTimeoutMs))
+        return false;
+
+    socket.write(encodeFrame(QJsonObject{{QStringLiteral("commands"), commands}}));
+    if (!reply) {
+        // Hand-off only: the running instance opens the file on its own time
+        socket.waitForBytesWritten(timeoutMs);
+        socket.disconnectFromServer();
+        return true;
+    }
+    socket.flush();
+
+    bool received = false;
+    QByteArray buffer;
+    QElapsedTimer timer;
+    timer.start();
+    while (timer.elapsed() < timeoutMs) {
+        if (socket.bytesAvailable() <= 0
+            && !socket.waitForReadyRead(int(qMax<qint64>(1, timeoutMs - timer.elapsed()))))
+            break;
+        buffer.append(socket.readAll());
+        QJsonObject message;
+        const FrameStatus status = decodeFrame(buffer, &message);
+        if (status == FrameStatus::Complete) {
+            *reply = message;
+            received = true;
+            break;
+        }
+        if (status == FrameStatus::Invalid)
+            break;
+    }
+    if (!received)
+        *reply = errorResult(QStringLiteral("batch"), timer.elapsed() >= timeoutMs
+            ? QStringLiteral("no reply from the running instance within %1 ms").arg(timeoutMs)
+            : QStringLiteral("invalid reply from the running instance"));
+    socket.disconnectFromServer();
+    return true;
+}
@@ -0,0 +1,127 @@
+/**
+ * @file InstanceServer.h
+ * @brief Single-instance command server and client protocol.
+ *
+ * The first QtPdfView process listens on a local socket; later processes
+ * (and integration scripts) connect to it and send commands instead of
+ * starting a second window.
+ *
+ * Protocol (version 1), both directions:
+ * @code
+ *   "QPVC"          4 bytes magic
+ *   version         quint16, big endian
+ *   length          quint32, big endian, payload size in bytes
+ *   payload         UTF-8 JSON object
+ * @endcode
+ *
+ * Request payload:
+ * @code
+ *   { "commands": [
+ *       { "cmd": "open", "path": "/docs/a.pdf", "original": "/docs/a.udf" },
+ *       { "cmd": "goto", "page": 12 },                  // 1-based
+ *       { "cmd": "zoom", "mode": "width" },             // "width", "page" or a factor
+ *       { "cmd": "search", "text": "invoice" },   // optional "wholeWord", "regex"
+ *       { "cmd": "multisearch", "terms": ["alpha", "beta"] },
+ *       { "cmd": "memory" },                            // reply: per-subsystem bytes
+ *       { "cmd": "activate" },
+ *       { "cmd": "ping" } ] }
+ * @endcode
+ *
+ * Commands run in order; a command following "open" waits until the
+ * document has loaded, and "search" and "multisearch" reply once the search finished. One reply frame is sent per request:
+ * @code
+ *   { "version": 1, "ok": true, "elapsedMs": 41.2,
+ *     "results": [ { "cmd": "open", "ok": true, "elapsedMs": 38.9, "pages": 120 }, ... ] }
+ * @endcode
+ *
+ * For compatibility with older clients, a connection whose first bytes are
+ * not the magic is read as a single QDataStream QString path (open + activate).
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QString>
+#include <functional>
+#include <memory>
+
+class MainWindow;
+class QLocalServer;
+class QLocalSocket;
+
+/**
+ * @class InstanceServer
+ * @brief Accepts framed command batches on the single-instance socket.
+ */
+class InstanceServer : public QObject {
+    Q_OBJECT
+public:
+    static constexpr quint16 kProtocolVersion = 1;
+
+    /**
+     * @brief Result of decoding a frame from a receive buffer.
+     */
+    enum class FrameStatus {
+        Incomplete,  ///< More bytes are needed
+        Complete,    ///< A frame was decoded and removed from the buffer
+        Invalid      ///< The buffer does not start with a valid frame
+    };
+
+    /**
+     * @brief Constructs a server dispatching commands to @p window.
+     */
+    explicit InstanceServer(MainWindow* window, QObject* parent = nullptr);
+
+    /**
+     * @brief Starts listening on @p name, removing a stale socket first.
+     */
+    bool listen(const QString& name);
+
+    /**
+     * @brief Runs a batch of commands in-process.
+     * @param commands Array of command objects (see file documentation)
+     * @param onDone Optional callback receiving the reply object
+     */
+    void execute(const QJsonArray& commands,
+                 std::function<void(const QJsonObject&)> onDone = {});
+
+    /**
+     * @brief Encodes a JSON message as a protocol frame.
+     */
+    static QByteArray encodeFrame(const QJsonObject& message);
+
+    /**
+     * @brief Decodes one frame from the front of @p buffer.
+     * @param buffer Receive buffer; consumed bytes are removed on success
+     * @param message Receives the decoded JSON object
+     * @param version Receives the sender's protocol version
+     */
+    static FrameStatus decodeFrame(QByteArray& buffer, QJsonObject* message, quint16* version = nullptr);
+
+    /**
+     * @brief Sends a command batch to a running instance.
+     * @param name Local server name
+     * @param commands Commands to send
+     * @param timeoutMs Time to wait for the reply
+     * @param reply Receives the reply, or an error result with "ok": false
+     *        if none arrived in time. If null, returns once the batch is
+     *        written, without waiting for it to run.
+     * @return True if a running instance accepted the connection
+     */
+    static bool sendToRunningInstance(const QString& name, const QJsonArray& commands,
+                                      int timeoutMs, QJsonObject* reply);
+
+private:
+    struct Batch;
+
+    void handleConnection(QLocalSocket* client);
+    void runNext(const std::shared_ptr<Batch>& batch);
+    QJsonObject executeCommand(const QJsonObject& command);
+    QJsonObject openResult(const QString& path) const;
+
+    MainWindow* m_window {nullptr};
+    QLocalServer* m_server {nullptr};
+};
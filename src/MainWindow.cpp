@@ -7,6 +7,7 @@
 
 #include <QAction>
 #include <QApplication>
+#include <QClipboard>
 #include <QDir>
 #include <QFileInfo>
 #include <QFileDialog>
@@ -21,41 +22,78 @@
 #include <QPdfDocument>
 #include <QPdfView>
 #include <QPdfSelection>
-#include <QPdfSearchModel>
 #include <QPdfPageNavigator>
 #include <QPdfPageSelector>
 #include "SelectablePdfView.h"
 #include "SearchMinimapPanel.h"
+#include "DocumentPool.h"
+#include "FileCopier.h"
+#include "HttpRangeReply.h"
+#include "PageFingerprinter.h"
+#include "PageRenderer.h"
+#include "TextExporter.h"
+#include "FileReadDevice.h"
+#include "DocumentLoader.h"
+#include "StartupTimeline.h"
+#include "PerfStats.h"
+#include "Trace.h"
+#include "TextSearch.h"
 #include <QShortcut>
+#include <QStatusBar>
 #include <QToolBar>
 #include <QStyle>
 #include <QPainter>
 #include <QPrinter>
 #include <QPrintDialog>
 #include <QListWidget>
+#include <QListView>
+#include <QInputDialog>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <QItemSelectionModel>
 #include <QDockWidget>
 #include <QScrollBar>
 #include <QProxyStyle>
+#include <QPixmap>
 #include <QTimer>
+#include <QSignalBlocker>
+#include <QElapsedTimer>
 #include <QResizeEvent>
+#include <QCloseEvent>
 #include <QDesktopServices>
 #include <QUrl>
 #include <QUrlQuery>
+#include <QNetworkAccessManager>
+#include <QFileSystemWatcher>
 #include <QDragEnterEvent>
 #include <QDropEvent>
 #include <QMimeData>
 
 namespace {
+constexpr int kThumbnailRenderPx = 440;
+constexpr int kDeferredUiFallbackMs = 1000;
+constexpr int kReloadDebounceMs = 300;
+constexpr int kScrollBarWidthPx = 26;
+
 /**
  * @brief Custom style to disable transient (auto-hiding) scrollbars.
  *
  * Some platforms show scrollbars that fade away when not in use.
  * This style hint override forces scrollbars to always be visible,
  * which is necessary for the search minimap overlay to work properly.
+ * It also fixes the scroll bar width, so the viewport has its final width
+ * at the first paint, before the deferred style sheet is applied.
  */
 class NoTransientScrollBarStyle : public QProxyStyle {
 public:
     using QProxyStyle::QProxyStyle;
+    int pixelMetric(PixelMetric metric, const QStyleOption* option = nullptr,
+                    const QWidget* widget = nullptr) const override
+    {
+        if (metric == QStyle::PM_ScrollBarExtent)
+            return kScrollBarWidthPx;
+        return QProxyStyle::pixelMetric(metric, option, widget);
+    }
     int styleHint(StyleHint hint,
                   const QStyleOption* option = nullptr,
                   const QWidget* widget = nullptr,
@@ -66,6 +104,38 @@ public:
         return QProxyStyle::styleHint(hint, option, widget, returnData);
     }
 };
+
+/// Icon from the resources, or a standard icon if it cannot be loaded
+QIcon iconOrFallback(const QWidget* widget, const char* path, QStyle::StandardPixmap fallback)
+{
+    QIcon icon{QLatin1String(path)};
+    if (icon.isNull())
+        icon = widget->style()->standardIcon(fallback);
+    return icon;
+}
+
+/// Minimap markers for search hits, labelled with their term, given the page offsets of the view
+QVector<MiniMapMarker> searchMarkers(const QVector<SearchHit>& hits, const QStringList& labels,
+                                     const QVector<qreal>& offsets, qreal totalHeight)
+{
+    QVector<MiniMapMarker> markers;
+    markers.reserve(hits.size());
+    const QColor highlightColor(255, 215, 0, 180);
+    for (const SearchHit& hit : hits) {
+        if (hit.page < 0 || hit.page >= offsets.size())
+            continue;
+        const qreal localY = hit.rect.isValid() ? hit.rect.center().y() : 0.0;
+
+        MiniMapMarker marker;
+        marker.page = hit.page;
+        marker.label = labels.value(hit.term);
+        marker.color = highlightColor;
+        marker.pageRect = hit.rect;
+        marker.normalizedPos = qBound<qreal>(0.0, (offsets.at(hit.page) + localY) / totalHeight, 1.0);
+        markers.append(marker);
+    }
+    return markers;
+}
 }
 
 MainWindow::MainWindow(QWidget* parent)
@@ -73,9 +143,109 @@ MainWindow::MainWindow(QWidget* parent)
 {
     setAcceptDrops(true);
     setupUi();
-    setupThumbnailPanel();
+    StartupTimeline::mark("view and toolbar");
     setupSearchMinimap();
     setupShortcuts();
+
+    // The thumbnail panel and the print/email actions are not needed for the
+    // first paint; build them once the first page is on screen (or after a
+    // short fallback delay when there is nothing to show).
+    connect(m_view, &SelectablePdfView::firstPagePainted, this, [this]{
+        StartupTimeline::mark("first page painted");
+        setupDeferredUi();
+    });
+    QTimer::singleShot(kDeferredUiFallbackMs, this, &MainWindow::setupDeferredUi);
+}
+
+void MainWindow::setupDeferredUi()
+{
+    if (m_deferredUiReady)
+        return;
+    m_deferredUiReady = true;
+
+    applyDeferredStyling();
+    setupThumbnailPanel();
+    setupSearchResultsPanel();
+    setupDeferredActions();
+    adjustToolBarStyle();
+    if (!m_currentFilePath.isEmpty())
+        updateThumbnails();
+
+    StartupTimeline::mark("deferred UI");
+    StartupTimeline::finish();
+}
+
+void MainWindow::applyDeferredStyling()
+{
+    for (const DeferredIcon& deferred : std::as_const(m_deferredIcons)) {
+        if (deferred.action)
+            deferred.action->setIcon(iconOrFallback(this, deferred.path, deferred.fallback));
+    }
+    m_deferredIcons.clear();
+
+    if (m_verticalScrollBar) {
+        m_verticalScrollBar->setStyleSheet(QStringLiteral(
+            "QScrollBar:vertical { width: 26px; margin: 0px; }"
+            "QScrollBar::handle:vertical { background: rgba(130,130,130,160); min-height: 28px; border-radius: 7px; }"
+            "QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical { height: 0px; border: none; }"
+            "QScrollBar::add-page:vertical, QScrollBar::sub-page:vertical { background: transparent; }"));
+    }
+}
+
+void MainWindow::setupDeferredActions()
+{
+    // Print button
+    QIcon printIcon = iconOrFallback(this, ":/icons/print.svg", QStyle::SP_FileDialogDetailedView);
+    auto* printAct = new QAction(printIcon, tr("Print"), this);
+    printAct->setToolTip(tr("Print"));
+    m_toolbar->insertAction(m_prevPageAct, printAct);
+
+    // Email button
+    QIcon mailIcon = iconOrFallback(this, ":/icons/email.svg", QStyle::SP_DialogOpenButton);
+    auto* mailAct = new QAction(mailIcon, tr("Email"), this);
+    mailAct->setToolTip(tr("Share via default email application"));
+    m_toolbar->insertAction(m_prevPageAct, mailAct);
+
+    // Print action
+    connect(printAct, &QAction::triggered, this, [this]{
+        if (!m_doc || m_doc->pageCount() <= 0) return;
+        QPrinter printer(QPrinter::HighResolution);
+        QPrintDialog dlg(&printer, this);
+        if (dlg.exec() != QDialog::Accepted) return;
+        QPainter painter(&printer);
+        if (!painter.isActive()) return;
+        TRACE_SCOPE("print");
+        const int pageCount = m_doc->pageCount();
+        for (int i = 0; i < pageCount; ++i) {
+            TRACE_SCOPE("printPage");
+            const QSize target = painter.viewport().size();
+            if (target.isEmpty()) break;
+            // Keep the page's aspect ratio, centered on the paper
+            const QImage img = PageRenderer::renderToFit(*m_doc, i, target);
+            painter.drawImage(QPoint((target.width() - img.width()) / 2, (target.height() - img.height()) / 2), img);
+            if (i + 1 < pageCount)
+                printer.newPage();
+        }
+    });
+
+    // Email action
+    connect(mailAct, &QAction::triggered, this, [this]{
+        if (m_currentFilePath.isEmpty()) {
+            QMessageBox::warning(this, tr("Email"), tr("Please open a PDF first."));
+            return;
+        }
+        const QFileInfo fi(m_currentFilePath);
+        const QString subject = tr("PDF sharing: %1").arg(fi.fileName());
+        QString body = tr("File path: %1").arg(fi.absoluteFilePath());
+        QUrl mailto(QStringLiteral("mailto:"));
+        QUrlQuery query;
+        query.addQueryItem(QStringLiteral("subject"), subject);
+        query.addQueryItem(QStringLiteral("body"), body);
+        mailto.setQuery(query);
+        if (!QDesktopServices::openUrl(mailto)) {
+            QMessageBox::warning(this, tr("Email"), tr("Could not open default email application."));
+        }
+    });
 }
 
 void MainWindow::triggerMultiTermSearch(const QString& terms)
@@ -83,12 +253,226 @@ void MainWindow::triggerMultiTermSearch(const QString& terms)
     runMultiTermSearch(terms);
 }
 
+void MainWindow::search(const QString& text)
+{
+    if (!m_searchEdit)
+        return;
+    m_searchEdit->setText(text);
+    if (m_searchDebounce)
+        m_searchDebounce->stop();
+    runSearchFromSearchBox();
+}
+
+bool MainWindow::goToPage(int page)
+{
+    if (!m_doc || page < 0 || page >= m_doc->pageCount())
+        return false;
+    if (auto* nav = m_view->pageNavigator())
+        nav->jump(page, QPointF(0, 0));
+    return true;
+}
+
+bool MainWindow::applyZoom(const QString& spec)
+{
+    const QString mode = spec.trimmed().toLower();
+    if (mode == QLatin1String("width")) {
+        m_view->setZoomMode(QPdfView::ZoomMode::FitToWidth);
+        return true;
+    }
+    if (mode == QLatin1String("page")) {
+        m_view->setZoomMode(QPdfView::ZoomMode::FitInView);
+        return true;
+    }
+    bool ok = false;
+    const qreal factor = mode.toDouble(&ok);
+    if (!ok || factor <= 0.0)
+        return false;
+    m_view->setZoomMode(QPdfView::ZoomMode::Custom);
+    m_view->setZoomFactor(factor);
+    return true;
+}
+
+int MainWindow::pageCount() const
+{
+    return m_doc ? m_doc->pageCount() : 0;
+}
+
+int MainWindow::searchResultCount() const
+{
+    return m_resultsModel ? m_resultsModel->rowCount() : 0;
+}
+
+void MainWindow::setSearchMode(bool wholeWord, bool regex)
+{
+    if (!m_actWholeWord || !m_actRegex)
+        return;
+    const QSignalBlocker blockWord(m_actWholeWord);
+    const QSignalBlocker blockRegex(m_actRegex);
+    m_actWholeWord->setChecked(wholeWord);
+    m_actRegex->setChecked(regex);
+    runSearchFromSearchBox();
+}
+
+TextMatcher::Options MainWindow::searchOptions() const
+{
+    TextMatcher::Options options;
+    if (m_actWholeWord && m_actWholeWord->isChecked())
+        options |= TextMatcher::WholeWord;
+    if (m_actRegex && m_actRegex->isChecked())
+        options |= TextMatcher::Regex;
+    return options;
+}
+
+void MainWindow::onSearchResults(quint64 generation, const QVector<SearchHit>& hits)
+{
+    if (generation != m_searchEngine->generation() || hits.isEmpty())
+        return;
+    if (m_multiTermInProgress) {
+        appendMultiTermMarkers(hits);
+        return;
+    }
+    QVector<SelectablePdfView::SearchHighlight> highlights;
+    highlights.reserve(hits.size());
+    for (const SearchHit& hit : hits)
+        highlights.append({hit.page, hit.rect, hit.bounds});
+    m_view->appendSearchHighlights(highlights);
+    m_resultsModel->appendHits(hits);
+
+    // First hit becomes current, or the one that was current before a warm
+    // switch; a hit activated in the folder search panel is jumped to
+    if (!selectPendingFolderHit(hits, searchResultCount() - int(hits.size()))) {
+        if (m_restoreSearchIndex >= 0) {
+            if (m_restoreSearchIndex < searchResultCount()) {
+                m_view->setCurrentSearchHighlight(m_restoreSearchIndex);
+                m_restoreSearchIndex = -1;
+            }
+        } else if (m_view->currentSearchHighlight() < 0) {
+            m_view->setCurrentSearchHighlight(0);
+        }
+    }
+    updateSearchStatus();
+    appendSearchMinimap(hits);
+}
+
+void MainWindow::onSearchFinished(quint64 generation, qint64 elapsedNs)
+{
+    if (generation != m_searchEngine->generation())
+        return;
+    if (m_multiTermInProgress) {
+        finishMultiTermSearch();
+        return;
+    }
+    m_searchInProgress = false;
+    if (m_doc && elapsedNs > 0) {
+        const int pages = m_doc->pageCount();
+        m_searchScheduler.recordSearch(pages, pages - m_searchCachedPages, elapsedNs);
+        updateSearchSchedule();
+    }
+    if (m_restoreSearchIndex >= 0 && m_view->currentSearchHighlight() < 0)
+        m_view->setCurrentSearchHighlight(0);
+    m_restoreSearchIndex = -1;
+    if (m_pendingFolderHit.filePath == m_currentFilePath)
+        m_pendingFolderHit = {};
+    updateSearchStatus();
+    emit searchFinished(searchResultCount());
+}
+
+void MainWindow::updateSearchSchedule()
+{
+    const int cached = m_searchEngine->textCache()->cachedPageCount();
+    PerfStats::setSearchSchedule(m_searchScheduler.debounceMs(cached),
+                                 m_searchScheduler.expectedSearchNs(cached),
+                                 m_searchScheduler.coldNsPerPage(),
+                                 m_searchScheduler.warmNsPerPage(),
+                                 m_searchScheduler.shouldPrefetch(cached));
+}
+
+void MainWindow::scheduleTextPrefetch()
+{
+    m_searchScheduler.setPageCount(m_doc ? m_doc->pageCount() : 0);
+    updateSearchSchedule();
+    // Small documents: extract the text once the first pages have painted,
+    // unless a search is already doing it
+    constexpr int kPrefetchDelayMs = 250;
+    QTimer::singleShot(kPrefetchDelayMs, this, [this, doc = QPointer<QPdfDocument>(m_doc)]{
+        if (!doc || doc != m_doc || m_searchInProgress || m_multiTermInProgress || !ensureDocumentPool())
+            return;
+        if (m_searchScheduler.shouldPrefetch(m_searchEngine->textCache()->cachedPageCount()))
+            m_searchEngine->prefetch();
+    });
+}
+
+bool MainWindow::searchResultAt(int idx, int* page, QRectF* rect) const
+{
+    const QVector<SearchHit>& hits = m_resultsModel->hits();
+    if (idx < 0 || idx >= hits.size())
+        return false;
+    *page = hits.at(idx).page;
+    *rect = hits.at(idx).rect;
+    return true;
+}
+
+int MainWindow::currentSearchIndex() const
+{
+    return m_view->currentSearchHighlight();
+}
+
+void MainWindow::stepSearchResult(int delta)
+{
+    const int count = searchResultCount();
+    if (count <= 0)
+        return;
+    selectSearchResult(((currentSearchIndex() + delta) % count + count) % count);
+}
+
+void MainWindow::selectSearchResult(int idx)
+{
+    if (idx < 0 || idx >= searchResultCount())
+        return;
+    m_view->setCurrentSearchHighlight(idx);
+    jumpToSearchResult(idx);
+    updateSearchStatus();
+}
+
+void MainWindow::runSearchFromSearchBox()
+{
+    const QString txt = m_searchEdit ? m_searchEdit->text() : QString();
+    m_searchError.clear();
+    m_view->setSearchHighlights({});
+    m_resultsModel->reset(m_searchEngine->textCache(), m_doc, m_documentPool);
+    // A search overtaken by typing took at least this long
+    if (m_searchInProgress && m_searchClock.isValid())
+        m_searchScheduler.recordCancelled(m_searchClock.nsecsElapsed());
+    if (txt.size() < 2) {
+        // Leaves a running text prefetch alone
+        if (m_searchInProgress) {
+            m_searchEngine->cancel();
+            m_searchInProgress = false;
+            emit searchFinished(0);
+        }
+    } else {
+        // Cancels the previous search, multi-term ones included; its late
+        // results are dropped by generation
+        finishMultiTermSearch();
+        // Pages are searched on the pool's instances, which need a local file
+        if (!ensureDocumentPool())
+            statusBar()->showMessage(tr("Search runs once the download is complete"), 5000);
+        m_searchInProgress = true;
+        m_searchCachedPages = m_searchEngine->textCache()->cachedPageCount();
+        m_searchClock.start();
+        if (!m_searchEngine->start({txt}, searchOptions())) {
+            m_searchInProgress = false;
+            m_searchError = m_searchEngine->errorString();
+        }
+    }
+    updateSearchMinimap(txt);
+    updateSearchStatus();
+}
+
 void MainWindow::setupUi()
 {
     // Initialize PDF document and view
-    m_doc = new QPdfDocument(this);
     m_view = new SelectablePdfView(this);
-    m_view->setDocument(m_doc);
     m_view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOn);
 
     // Configure view for fast rendering with all pages visible
@@ -101,20 +485,21 @@ void MainWindow::setupUi()
 
     // Style the scrollbar for minimap overlay
     m_verticalScrollBar = m_view->verticalScrollBar();
+    // Its width decides the view's, so it is set before the first paint
+    // through a proxy style; the look (handle, no arrows) is a style sheet
+    // applied after the first paint (see applyDeferredStyling()), since the
+    // first style sheet builds the whole style sheet machinery
     if (m_verticalScrollBar) {
-        m_verticalScrollBar->setMinimumWidth(26);
-        m_verticalScrollBar->setStyleSheet(QStringLiteral(
-            "QScrollBar:vertical { width: 26px; margin: 0px; }"
-            "QScrollBar::handle:vertical { background: rgba(130,130,130,160); min-height: 28px; border-radius: 7px; }"
-            "QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical { height: 0px; border: none; }"
-            "QScrollBar::add-page:vertical, QScrollBar::sub-page:vertical { background: transparent; }"));
+        auto* scrollBarStyle = new NoTransientScrollBarStyle;
+        scrollBarStyle->setParent(m_verticalScrollBar);
+        m_verticalScrollBar->setStyle(scrollBarStyle);
+        m_verticalScrollBar->setMinimumWidth(kScrollBarWidthPx);
     }
 
     // Create search minimap panel on scrollbar
     QWidget* minimapParent = m_verticalScrollBar ? static_cast<QWidget*>(m_verticalScrollBar) : m_view;
     m_minimapPanel = new SearchMinimapPanel(minimapParent);
     m_minimapPanel->setAttribute(Qt::WA_TransparentForMouseEvents, true);
-    m_minimapPanel->setStyleSheet(QStringLiteral("background: transparent;"));
     m_minimapPanel->show();
     positionFloatingMinimap();
 
@@ -135,9 +520,12 @@ void MainWindow::setupUi()
     });
 
     // Search debounce timer to avoid excessive searches while typing
+    // Searches are cancelled as soon as the text changes; the interval is
+    // chosen per keystroke from the measured search cost (SearchScheduler),
+    // so cheap searches run immediately and expensive ones wait for a pause
     m_searchDebounce = new QTimer(this);
     m_searchDebounce->setSingleShot(true);
-    m_searchDebounce->setInterval(320);
+    m_searchDebounce->setInterval(0);
 
     // Create toolbar
     m_toolbar = addToolBar(tr("PDF"));
@@ -146,12 +534,13 @@ void MainWindow::setupUi()
     tb->setIconSize(QSize(20, 20));
     tb->setToolButtonStyle(Qt::ToolButtonTextBesideIcon);
 
-    // Helper to load icon with fallback
-    auto iconOrFallback = [this](const char* path, QStyle::StandardPixmap fallback) -> QIcon {
-        QIcon icon{QLatin1String(path)};
-        if (icon.isNull())
-            icon = style()->standardIcon(fallback);
-        return icon;
+    // Icons are loaded after the first paint (applyDeferredStyling()); until
+    // then a transparent icon of the same size keeps the toolbar layout
+    QPixmap blank(tb->iconSize());
+    blank.fill(Qt::transparent);
+    const QIcon placeholder(blank);
+    auto deferIcon = [this](QAction* action, const char* path, QStyle::StandardPixmap fallback){
+        m_deferredIcons.append({action, path, fallback});
     };
 
     // "Open" button - opens original file with system default app (initially hidden)
@@ -167,33 +556,26 @@ void MainWindow::setupUi()
     });
 
     // Thumbnail toggle button
-    QIcon listIcon = iconOrFallback(":/icons/pages.svg", QStyle::SP_FileDialogDetailedView);
-    m_toggleThumbnails = tb->addAction(listIcon, tr("Pages"));
+    m_toggleThumbnails = tb->addAction(placeholder, tr("Pages"));
+    deferIcon(m_toggleThumbnails, ":/icons/pages.svg", QStyle::SP_FileDialogDetailedView);
     m_toggleThumbnails->setCheckable(true);
     m_toggleThumbnails->setChecked(false);
     m_toggleThumbnails->setToolTip(tr("Show/Hide Page Thumbnails"));
     tb->addSeparator();
 
     // Save As button
-    QIcon saveIcon = iconOrFallback(":/icons/save.svg", QStyle::SP_DialogSaveButton);
-    auto* saveAct = tb->addAction(saveIcon, tr("Save"));
+    auto* saveAct = tb->addAction(placeholder, tr("Save"));
+    deferIcon(saveAct, ":/icons/save.svg", QStyle::SP_DialogSaveButton);
     saveAct->setToolTip(tr("Save As (PDF)"));
 
-    // Print button
-    QIcon printIcon = iconOrFallback(":/icons/print.svg", QStyle::SP_FileDialogDetailedView);
-    auto* printAct = tb->addAction(printIcon, tr("Print"));
-    printAct->setToolTip(tr("Print"));
-
-    // Email button
-    QIcon mailIcon = iconOrFallback(":/icons/email.svg", QStyle::SP_DialogOpenButton);
-    auto* mailAct = tb->addAction(mailIcon, tr("Email"));
-    mailAct->setToolTip(tr("Share via default email application"));
+    // Print and Email buttons are inserted here by setupDeferredActions()
 
     // Page navigation buttons
-    QIcon prevIcon = iconOrFallback(":/icons/backpage.svg", QStyle::SP_ArrowBack);
-    QIcon nextIcon = iconOrFallback(":/icons/nextpage.svg", QStyle::SP_ArrowForward);
-    auto* prevPage = tb->addAction(prevIcon, QString());
-    auto* nextPage = tb->addAction(nextIcon, QString());
+    auto* prevPage = tb->addAction(placeholder, QString());
+    m_prevPageAct = prevPage;
+    auto* nextPage = tb->addAction(placeholder, QString());
+    deferIcon(prevPage, ":/icons/backpage.svg", QStyle::SP_ArrowBack);
+    deferIcon(nextPage, ":/icons/nextpage.svg", QStyle::SP_ArrowForward);
     prevPage->setShortcut(Qt::Key_PageUp);
     nextPage->setShortcut(Qt::Key_PageDown);
     prevPage->setToolTip(tr("Previous Page (PgUp)"));
@@ -205,23 +587,23 @@ void MainWindow::setupUi()
     m_pageCountLabel->setAlignment(Qt::AlignCenter);
     tb->addWidget(m_pageCountLabel);
     auto* pageSel = new QPdfPageSelector(this);
-    pageSel->setDocument(m_doc);
+    m_pageSelector = pageSel;
     tb->addWidget(pageSel);
     tb->addSeparator();
 
     // Zoom controls
-    QIcon zoomOutIcon = iconOrFallback(":/icons/zoomout.svg", QStyle::SP_ArrowDown);
-    QIcon zoomInIcon  = iconOrFallback(":/icons/add.svg", QStyle::SP_ArrowUp);
-    auto* zoomOut = tb->addAction(zoomOutIcon, tr("-"));
-    auto* zoomIn  = tb->addAction(zoomInIcon,  tr("+"));
+    auto* zoomOut = tb->addAction(placeholder, tr("-"));
+    auto* zoomIn  = tb->addAction(placeholder, tr("+"));
+    deferIcon(zoomOut, ":/icons/zoomout.svg", QStyle::SP_ArrowDown);
+    deferIcon(zoomIn, ":/icons/add.svg", QStyle::SP_ArrowUp);
     zoomIn->setShortcut(QKeySequence::ZoomIn);
     zoomOut->setShortcut(QKeySequence::ZoomOut);
     zoomIn->setToolTip(tr("Zoom In (Ctrl +)"));
     zoomOut->setToolTip(tr("Zoom Out (Ctrl -)"));
-    QIcon fitWIcon = iconOrFallback(":/icons/width.svg", QStyle::SP_DesktopIcon);
-    QIcon fitVIcon = iconOrFallback(":/icons/pageview.svg", QStyle::SP_DesktopIcon);
-    auto* fitW    = tb->addAction(fitWIcon, tr("Width"));
-    auto* fitV    = tb->addAction(fitVIcon, tr("Page"));
+    auto* fitW    = tb->addAction(placeholder, tr("Width"));
+    auto* fitV    = tb->addAction(placeholder, tr("Page"));
+    deferIcon(fitW, ":/icons/width.svg", QStyle::SP_DesktopIcon);
+    deferIcon(fitV, ":/icons/pageview.svg", QStyle::SP_DesktopIcon);
     fitW->setToolTip(tr("Fit to Width"));
     fitV->setToolTip(tr("Fit to Page"));
     tb->addSeparator();
@@ -231,102 +613,136 @@ void MainWindow::setupUi()
     m_searchEdit->setClearButtonEnabled(true);
     m_searchEdit->setPlaceholderText(tr("Search (min 2 chars)"));
     tb->addWidget(m_searchEdit);
-    QIcon findPrevIcon = iconOrFallback(":/icons/backfind.svg", QStyle::SP_MediaSkipBackward);
-    QIcon findNextIcon = iconOrFallback(":/icons/nextfind.svg", QStyle::SP_MediaSkipForward);
-    m_actFindPrev = tb->addAction(findPrevIcon, QString());
-    m_actFindNext = tb->addAction(findNextIcon, QString());
+    m_actFindPrev = tb->addAction(placeholder, QString());
+    m_actFindNext = tb->addAction(placeholder, QString());
+    deferIcon(m_actFindPrev, ":/icons/backfind.svg", QStyle::SP_MediaSkipBackward);
+    deferIcon(m_actFindNext, ":/icons/nextfind.svg", QStyle::SP_MediaSkipForward);
     m_actFindNext->setShortcut(QKeySequence::FindNext);
     m_actFindPrev->setShortcut(QKeySequence::FindPrevious);
     m_actFindNext->setToolTip(tr("Next match (F3)"));
     m_actFindPrev->setToolTip(tr("Previous match (Shift+F3)"));
+    // Matching modes; plain substring search when both are off
+    m_actWholeWord = tb->addAction(tr("W"));
+    m_actWholeWord->setCheckable(true);
+    m_actWholeWord->setToolTip(tr("Match whole words"));
+    m_actRegex = tb->addAction(tr(".*"));
+    m_actRegex->setCheckable(true);
+    m_actRegex->setToolTip(tr("Regular expression"));
+    for (QAction* act : {m_actWholeWord, m_actRegex})
+        connect(act, &QAction::toggled, this, &MainWindow::runSearchFromSearchBox);
     m_searchStatus = new QLabel(tr("0 results"), this);
     m_searchStatus->setMinimumWidth(64);
     m_searchStatus->setAlignment(Qt::AlignCenter);
     tb->addWidget(m_searchStatus);
 
-    // Setup search model for highlighting matches
-    m_searchModel = new QPdfSearchModel(this);
-    m_searchModel->setDocument(m_doc);
-    m_view->setSearchModel(m_searchModel);
-
-    // Debounced search while typing
-    connect(m_searchEdit, &QLineEdit::textChanged, this, [this](const QString&){
-        if (m_searchDebounce)
-            m_searchDebounce->start();
-    });
-    if (m_searchDebounce) {
-        connect(m_searchDebounce, &QTimer::timeout, this, [this]{
-            const QString txt = m_searchEdit ? m_searchEdit->text() : QString();
-            if (txt.size() >= 2) {
-                m_searchModel->setSearchString(txt);
-                updateSearchMinimap(txt);
-            } else {
-                m_searchModel->setSearchString(QString());
-                m_view->setCurrentSearchResultIndex(-1);
-                updateSearchMinimap(QString());
-            }
-            updateSearchStatus();
-        });
-    }
+    // One search engine feeds highlights, results panel, status and minimap
+    m_searchEngine = new SearchEngine(this);
+    m_resultsModel = new SearchResultsModel(this);
+    connect(m_searchEngine, &SearchEngine::resultsReady, this,
+            [this](quint64 generation, int, int, const QVector<SearchHit>& hits){
+        onSearchResults(generation, hits);
+    });
+    connect(m_searchEngine, &SearchEngine::finished, this, [this](quint64 generation, int, qint64 elapsedNs){
+        onSearchFinished(generation, elapsedNs);
+    });
 
-    // Navigate between matches with Enter
-    connect(m_searchEdit, &QLineEdit::returnPressed, this, [this]{
-        int count = m_searchModel->rowCount(QModelIndex());
-        if (count <= 0)
+    // Mapped text layer: page text, character boxes and words without pdfium
+    m_textLayerLoader = new TextLayerLoader(this);
+    connect(m_textLayerLoader, &TextLayerLoader::ready, this, [this](const QString& path, TextLayerPtr layer){
+        if (path != localDocumentPath() || !m_doc || layer->pageCount() != m_doc->pageCount())
             return;
-        int idx = m_view->currentSearchResultIndex();
-        idx = (idx + 1) % count;
-        m_view->setCurrentSearchResultIndex(idx);
-        jumpToSearchResult(idx);
-        updateSearchStatus();
+        m_searchEngine->textCache()->setTextLayer(m_doc, layer);
+        m_view->setTextLayer(layer);
+        updateSearchSchedule();
     });
 
-    // Find next/previous actions
-    connect(m_actFindNext, &QAction::triggered, this, [this]{
-        int count = m_searchModel->rowCount(QModelIndex());
-        if (count <= 0) return;
-        int idx = (m_view->currentSearchResultIndex() + 1) % count;
-        m_view->setCurrentSearchResultIndex(idx);
-        jumpToSearchResult(idx);
-        updateSearchStatus();
+    // Reload the open file when it is regenerated on disk
+    m_fileWatcher = new QFileSystemWatcher(this);
+    connect(m_fileWatcher, &QFileSystemWatcher::fileChanged, this, &MainWindow::onWatchedFileChanged);
+    connect(m_fileWatcher, &QFileSystemWatcher::directoryChanged, this, &MainWindow::onWatchedFileChanged);
+    m_reloadTimer = new QTimer(this);
+    m_reloadTimer->setSingleShot(true);
+    m_reloadTimer->setInterval(kReloadDebounceMs);
+    connect(m_reloadTimer, &QTimer::timeout, this, &MainWindow::reloadChangedFile);
+    m_fingerprinter = new PageFingerprinter(this);
+    connect(m_fingerprinter, &PageFingerprinter::ready, this,
+            [this](const QString& path, const QVector<QByteArray>& fingerprints){
+        if (path != m_currentFilePath || !m_doc || fingerprints.size() != m_doc->pageCount())
+            return;
+        m_pageFingerprints = fingerprints;
+        applyReloadCarryOver();
     });
-    connect(m_actFindPrev, &QAction::triggered, this, [this]{
-        int count = m_searchModel->rowCount(QModelIndex());
-        if (count <= 0) return;
-        int idx = m_view->currentSearchResultIndex();
-        idx = (idx - 1 + count) % count;
-        m_view->setCurrentSearchResultIndex(idx);
-        jumpToSearchResult(idx);
-        updateSearchStatus();
+
+    // Local files are parsed off the GUI thread and handed over when ready
+    m_documentLoader = new DocumentLoader(this);
+    connect(m_documentLoader, &DocumentLoader::loaded, this, &MainWindow::onDocumentLoaded);
+    connect(m_documentLoader, &DocumentLoader::failed, this,
+            [this](quint64 generation, const QString& path, const QString& error){
+        if (generation == m_loadGeneration && path == m_loadingFilePath)
+            onDocumentLoadFailed(error);
     });
 
-    // Update search status when results change
-    connect(m_searchModel, &QPdfSearchModel::countChanged, this, &MainWindow::updateSearchStatus);
-    connect(m_searchModel, &QPdfSearchModel::countChanged, this, [this]{
-        const QString term = m_searchEdit ? m_searchEdit->text() : QString();
-        const int count = m_searchModel ? m_searchModel->rowCount(QModelIndex()) : 0;
-        if (term.size() >= 2 && count > 0) {
-            if (m_view->currentSearchResultIndex() < 0)
-                m_view->setCurrentSearchResultIndex(0);
-        } else {
-            m_view->setCurrentSearchResultIndex(-1);
+    // Text export runs on the document pool, like the loaders above
+    m_textExporter = new TextExporter(this);
+    connect(m_textExporter, &TextExporter::progress, this, [this](int done, int total){
+        statusBar()->showMessage(tr("Exporting text to %1... %2 of %3 pages")
+                                     .arg(QFileInfo(m_exportDestination).fileName())
+                                     .arg(done).arg(total));
+    });
+    connect(m_textExporter, &TextExporter::finished, this, [this](const TextExporter::Result& r){
+        if (!r.ok) {
+            statusBar()->clearMessage();
+            if (!r.cancelled)
+                QMessageBox::critical(this, tr("Export Text"),
+                                      tr("Export failed: %1\n%2").arg(m_exportDestination, r.errorString));
+            return;
         }
+        statusBar()->showMessage(tr("Exported %1 pages to %2 in %3 s (%4 pages/s)")
+                                     .arg(r.pages)
+                                     .arg(QFileInfo(m_exportDestination).fileName())
+                                     .arg(double(r.elapsedMs) / 1000.0, 0, 'f', 2)
+                                     .arg(r.pagesPerSecond(), 0, 'f', 0),
+                                 8000);
     });
-    connect(m_searchModel, &QPdfSearchModel::countChanged, this, [this]{
-        const QString term = m_searchEdit ? m_searchEdit->text() : QString();
-        if (term.size() >= 2)
-            updateSearchMinimap(term);
+
+    // Pages of the current file for thumbnails, search, text export,
+    // fingerprints and text layers, off the GUI thread. Created after all
+    // of them: children are destroyed in creation order, so the pool
+    // outlives their worker threads.
+    m_documentPool = new DocumentPool(this);
+
+    // Empty document until the first file is opened; each opened document
+    // gets its own (see createDocument).
+    setActiveDocument(createDocument(), nullptr);
+
+    // Debounced search while typing
+    connect(m_searchEdit, &QLineEdit::textChanged, this, [this](const QString&){
+        if (m_searchDebounce)
+            m_searchDebounce->start(m_searchScheduler.debounceMs(m_searchEngine->textCache()->cachedPageCount()));
     });
-    connect(m_view, &QPdfView::currentSearchResultIndexChanged, this, &MainWindow::updateSearchStatus);
+    if (m_searchDebounce)
+        connect(m_searchDebounce, &QTimer::timeout, this, &MainWindow::runSearchFromSearchBox);
 
-    // Update page count label when document loads
-    connect(m_doc, &QPdfDocument::pageCountChanged, this, [this](int){
-        updatePageCountLabel();
-        updatePageMetrics();
+    // Navigate between matches with Enter; a pending search runs right away
+    connect(m_searchEdit, &QLineEdit::returnPressed, this, [this]{
+        if (m_searchDebounce && m_searchDebounce->isActive()) {
+            m_searchDebounce->stop();
+            runSearchFromSearchBox();
+            return;
+        }
+        stepSearchResult(1);
     });
 
+    // Find next/previous actions
+    connect(m_actFindNext, &QAction::triggered, this, [this]{ stepSearchResult(1); });
+    connect(m_actFindPrev, &QAction::triggered, this, [this]{ stepSearchResult(-1); });
+
+    connect(m_view, &SelectablePdfView::currentSearchHighlightChanged, this, &MainWindow::updateSearchStatus);
+    connect(m_view, &SelectablePdfView::currentSearchHighlightChanged, this, &MainWindow::syncSearchResultsSelection);
+
     // Thumbnail toggle
     connect(m_toggleThumbnails, &QAction::toggled, this, [this](bool checked){
+        setupDeferredUi();
         if (m_thumbnailDock)
             m_thumbnailDock->setVisible(checked);
     });
@@ -363,146 +779,848 @@ void MainWindow::setupUi()
     connect(fitW, &QAction::triggered, this, [this]{ m_view->setZoomMode(QPdfView::ZoomMode::FitToWidth); });
     connect(fitV, &QAction::triggered, this, [this]{ m_view->setZoomMode(QPdfView::ZoomMode::FitInView); });
 
-    // Save As action
-    connect(saveAct, &QAction::triggered, this, [this]{
-        if (m_currentFilePath.isEmpty()) {
-            QMessageBox::warning(this, tr("Save"), tr("Current file path is unknown."));
+    // Save As action
+    m_saveCopier = new FileCopier(this);
+    connect(saveAct, &QAction::triggered, this, [this]{
+        const QString source = localDocumentPath();
+        if (source.isEmpty()) {
+            QMessageBox::warning(this, tr("Save"), HttpRangeReply::isHttpUrl(m_currentFilePath)
+                                 ? tr("The document is still downloading.")
+                                 : tr("Current file path is unknown."));
+            return;
+        }
+        QString dest = QFileDialog::getSaveFileName(this, tr("Save As"),
+                                                    QDir::home().filePath(QFileInfo(m_currentFilePath).fileName()),
+                                                    tr("PDF Files (*.pdf)"));
+        if (dest.isEmpty()) return;
+        // Copy in the background; the destination is replaced atomically once complete
+        if (!m_saveCopier->start(source, dest))
+            return;
+        m_saveDestination = dest;
+        saveAct->setEnabled(false);
+        statusBar()->showMessage(tr("Saving %1...").arg(QFileInfo(dest).fileName()));
+    });
+    connect(m_saveCopier, &FileCopier::progress, this, [this](qint64 done, qint64 total){
+        const int percent = total > 0 ? int(done * 100 / total) : 100;
+        statusBar()->showMessage(tr("Saving %1... %2%")
+                                     .arg(QFileInfo(m_saveDestination).fileName())
+                                     .arg(percent));
+    });
+    connect(m_saveCopier, &FileCopier::finished, this, [this, saveAct](const FileCopier::Result& r){
+        saveAct->setEnabled(true);
+        const QString name = QFileInfo(m_saveDestination).fileName();
+        if (!r.ok) {
+            statusBar()->clearMessage();
+            if (!r.cancelled)
+                QMessageBox::critical(this, tr("Save"), tr("Save failed: %1\n%2").arg(m_saveDestination, r.errorString));
+            return;
+        }
+        const double mb = double(r.bytes) / (1024.0 * 1024.0);
+        statusBar()->showMessage(tr("Saved %1: %2 MB in %3 s (%4 MB/s, %5)")
+                                     .arg(name)
+                                     .arg(mb, 0, 'f', 1)
+                                     .arg(double(r.elapsedMs) / 1000.0, 0, 'f', 2)
+                                     .arg(r.bytesPerSecond() / (1024.0 * 1024.0), 0, 'f', 0)
+                                     .arg(FileCopier::methodName(r.method)),
+                                 8000);
+    });
+
+    adjustToolBarStyle();
+}
+
+void MainWindow::setupShortcuts()
+{
+    // Ctrl+F focuses search box
+    auto* focusFind = new QShortcut(QKeySequence::Find, this);
+    connect(focusFind, &QShortcut::activated, this, [this]{
+        m_searchEdit->setFocus(Qt::ShortcutFocusReason);
+        m_searchEdit->selectAll();
+    });
+
+    // Ctrl+C copies selection or current search match
+    auto* copyAct = new QAction(tr("Copy"), this);
+    copyAct->setShortcut(QKeySequence::Copy);
+    addAction(copyAct);
+    connect(copyAct, &QAction::triggered, this, [this]{
+        if (m_view->copySelectionToClipboard())
+            return;
+        // Fallback: copy current search match text
+        const int idx = m_view->currentSearchHighlight();
+        const QVector<SearchHit>& hits = m_resultsModel->hits();
+        if (idx >= 0 && idx < hits.size()) {
+            const SearchHit& hit = hits.at(idx);
+            const FoldedText text = m_searchEngine->textCache()->page(m_doc, hit.page);
+            QGuiApplication::clipboard()->setText(text.original().mid(hit.start, hit.length));
+        }
+    });
+
+    // Escape clears search
+    auto* esc = new QShortcut(QKeySequence(Qt::Key_Escape), this);
+    connect(esc, &QShortcut::activated, this, [this]{ m_searchEdit->clear(); });
+
+    // F12 toggles the performance HUD
+    auto* perfHudAct = new QAction(tr("Performance HUD"), this);
+    perfHudAct->setShortcut(QKeySequence(Qt::Key_F12));
+    perfHudAct->setCheckable(true);
+    addAction(perfHudAct);
+    connect(perfHudAct, &QAction::toggled, this, [this](bool checked){
+        updatePerfMemory();
+        m_view->setPerfHudVisible(checked);
+    });
+
+    // Ctrl+Shift+M shows the memory report (also in the view's context menu)
+    auto* memoryAct = new QAction(tr("Memory Report..."), this);
+    memoryAct->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_M));
+    addAction(memoryAct);
+    m_view->addContextMenuAction(memoryAct);
+    connect(memoryAct, &QAction::triggered, this, &MainWindow::showMemoryReport);
+
+    // Ctrl+Shift+D searches every PDF in a folder
+    auto* folderAct = new QAction(tr("Search in Folder..."), this);
+    folderAct->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_D));
+    addAction(folderAct);
+    m_view->addContextMenuAction(folderAct);
+    connect(folderAct, &QAction::triggered, this, &MainWindow::searchInFolder);
+
+    // Ctrl+Shift+E writes the document's text to a file in the background
+    auto* exportAct = new QAction(tr("Export Text..."), this);
+    exportAct->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_E));
+    addAction(exportAct);
+    m_view->addContextMenuAction(exportAct);
+    connect(exportAct, &QAction::triggered, this, &MainWindow::exportText);
+}
+
+void MainWindow::exportText()
+{
+    // One export at a time; progress is shown in the status bar
+    const QString path = localDocumentPath();
+    if (path.isEmpty() || m_textExporter->isRunning())
+        return;
+    const QFileInfo fi(m_currentFilePath);
+    const QString dest = QFileDialog::getSaveFileName(this, tr("Export Text"),
+                                                      fi.dir().filePath(fi.completeBaseName() + QStringLiteral(".txt")),
+                                                      tr("Text Files (*.txt)"));
+    if (dest.isEmpty() || !ensureDocumentPool() || !m_textExporter->start(m_documentPool, m_doc->pageCount(), dest))
+        return;
+    m_exportDestination = dest;
+    statusBar()->showMessage(tr("Exporting text to %1...").arg(QFileInfo(dest).fileName()));
+}
+
+MemoryReport MainWindow::memoryReport() const
+{
+    MemoryReport report;
+
+    // pdfium's own heap is not visible; the file is read on demand through
+    // the page cache, so it is listed by size but not counted
+    report.add(tr("Document"), 0, m_doc ? m_doc->pageCount() : 0, tr("pages"),
+               m_fileDevice ? tr("%1 MB file, read on demand")
+                                  .arg(double(m_fileDevice->size()) / (1024.0 * 1024.0), 0, 'f', 1)
+                            : QString());
+
+    report.add(tr("Rendered pages"), m_view->renderCacheBytes(), m_view->renderCachePageCount(), tr("images"));
+
+    const int thumbnails = m_thumbnailList
+        ? qMin(m_nextThumbnail, m_thumbnailList->count()) - int(m_thumbnailsInFlight.size()) : 0;
+    report.add(tr("Thumbnails"), qint64(thumbnails) * kThumbnailRenderPx * kThumbnailRenderPx * 4,
+               thumbnails, tr("icons"));
+
+    // Each instance parses the file again inside pdfium, which is not visible
+    report.add(tr("Document pool"), 0, m_documentPool ? m_documentPool->instanceCount() : 0,
+               tr("instances"), tr("pdfium heap not counted"));
+
+    int selectionPages = 0;
+    const qint64 selectionBytes = m_view->selectionBytes(&selectionPages);
+    report.add(tr("Text selection"), selectionBytes, selectionPages, tr("pages"));
+
+    qint64 markerBytes = 0;
+    const QVector<MiniMapMarker>* markers = m_minimapPanel ? &m_minimapPanel->markers() : nullptr;
+    if (markers) {
+        markerBytes = qint64(markers->size()) * qint64(sizeof(MiniMapMarker));
+        for (const MiniMapMarker& m : *markers)
+            markerBytes += qint64(m.label.size()) * qint64(sizeof(QChar));
+    }
+    report.add(tr("Minimap markers"), markerBytes, markers ? markers->size() : 0, tr("markers"));
+
+    // Hits and overlay share their outline polygons
+    const qint64 resultBytes = m_resultsModel->byteSize()
+        + qint64(m_view->searchHighlights().size()) * qint64(sizeof(SelectablePdfView::SearchHighlight));
+    report.add(tr("Search results"), resultBytes, searchResultCount(), tr("results"));
+
+    const PageTextCache* textCache = m_searchEngine->textCache();
+    report.add(tr("Text caches"), textCache->byteSize(), textCache->cachedPageCount(), tr("pages"),
+               tr("original and folded search text"));
+
+    const TextLayerPtr layer = textCache->textLayer();
+    report.add(tr("Text layer"), layer ? layer->byteSize() : 0, layer ? layer->pageCount() : 0,
+               tr("pages"), tr("file mapping"));
+
+    report.add(tr("Warm documents"), m_recentDocuments.totalBytes(), m_recentDocuments.count(),
+               tr("documents"), tr("thumbnails and page text"));
+
+    report.residentBytes = MemoryReport::currentResidentBytes();
+    return report;
+}
+
+void MainWindow::showMemoryReport()
+{
+    QMessageBox box(this);
+    box.setWindowTitle(tr("Memory Report"));
+    box.setTextFormat(Qt::RichText);
+    box.setText(QStringLiteral("<pre>%1</pre>").arg(memoryReport().format().toHtmlEscaped()));
+    box.exec();
+}
+
+void MainWindow::updatePerfMemory()
+{
+    const int rendered = m_thumbnailList
+        ? qMin(m_nextThumbnail, m_thumbnailList->count()) - int(m_thumbnailsInFlight.size()) : 0;
+    PerfStats::setDocumentMemory(m_fileDevice ? m_fileDevice->size() : 0,
+                                 qint64(rendered) * kThumbnailRenderPx * kThumbnailRenderPx * 4);
+}
+
+QPdfDocument* MainWindow::createDocument()
+{
+    auto* doc = new QPdfDocument(this);
+    connectDocument(doc);
+    return doc;
+}
+
+void MainWindow::connectDocument(QPdfDocument* doc)
+{
+    // Only the active document drives the UI; warm documents stay quiet.
+    // Page count and sizes are known before loading completes: fill in the
+    // page count label and minimap right away.
+    connect(doc, &QPdfDocument::pageCountChanged, this, [this, doc](int){
+        if (doc != m_doc)
+            return;
+        updatePageCountLabel();
+        updatePageMetrics();
+    });
+    connect(doc, &QPdfDocument::statusChanged, this, [this, doc](QPdfDocument::Status status){
+        if (doc != m_doc)
+            return;
+        if (status == QPdfDocument::Status::Ready)
+            onDocumentReady();
+        else if (status == QPdfDocument::Status::Error && !m_loadingFilePath.isEmpty())
+            onDocumentLoadFailed(tr("Error code: %1").arg(int(doc->error())));
+    });
+}
+
+void MainWindow::onDocumentLoaded(quint64 generation, const QString& path, QPdfDocument* doc,
+                                  FileReadDevice* device)
+{
+    if (generation != m_loadGeneration || path != m_loadingFilePath) {
+        delete doc;
+        delete device;
+        return;
+    }
+    // Replace the empty document shown while parsing
+    QPdfDocument* placeholder = m_doc;
+    doc->setParent(this);
+    device->setParent(this);
+    connectDocument(doc);
+    setActiveDocument(doc, device);
+    delete placeholder;
+    // Parsed already: the status signals were emitted on the worker
+    onDocumentReady();
+}
+
+void MainWindow::setActiveDocument(QPdfDocument* doc, FileReadDevice* device,
+                                   std::unique_ptr<PageTextCache> textCache)
+{
+    m_doc = doc;
+    m_fileDevice = device;
+    m_searchEngine->setDocument(doc, m_documentPool, std::move(textCache));
+    if (m_searchInProgress) {
+        m_searchInProgress = false;
+        emit searchFinished(searchResultCount());
+    }
+    finishMultiTermSearch();
+    m_resultsModel->reset(m_searchEngine->textCache(), doc, m_documentPool);
+    m_view->setDocument(doc);
+    if (m_pageSelector)
+        m_pageSelector->setDocument(doc);
+}
+
+std::unique_ptr<WarmDocument> MainWindow::detachCurrentDocument()
+{
+    auto entry = std::make_unique<WarmDocument>();
+    entry->filePath = m_currentFilePath;
+    entry->fileSize = m_currentFileSize;
+    entry->lastModified = m_currentFileModified;
+    entry->document = m_doc;
+    entry->device = m_fileDevice;
+    entry->textCache = m_searchEngine->takeTextCache();
+
+    entry->zoomMode = m_view->zoomMode();
+    entry->zoomFactor = m_view->zoomFactor();
+    entry->horizontalScroll = m_view->horizontalScrollBar()->value();
+    entry->verticalScroll = m_view->verticalScrollBar()->value();
+    entry->searchResultIndex = m_view->currentSearchHighlight();
+
+    entry->pageHeights = m_pageHeights;
+    if (m_thumbnailList) {
+        m_thumbnailTimer->stop();
+        const int count = m_thumbnailList->count();
+        entry->thumbnails.reserve(count);
+        for (int i = 0; i < count; ++i)
+            entry->thumbnails.append(m_thumbnailList->item(i)->icon());
+        // Queued thumbnails are dropped; the document continues from the first of them
+        int rendered = m_nextThumbnail;
+        for (int page : std::as_const(m_thumbnailsInFlight))
+            rendered = qMin(rendered, page);
+        m_documentPool->cancelAll();
+        m_thumbnailsInFlight.clear();
+        entry->thumbnailsRendered = qMin(rendered, count);
+        entry->thumbnailBytes = qint64(entry->thumbnailsRendered) * kThumbnailRenderPx * kThumbnailRenderPx * 4;
+    }
+
+    m_currentFilePath.clear();
+    m_loadingFilePath.clear();
+    m_documentLoader->cancel();
+    m_remoteReply = nullptr;
+    m_pageFingerprints.clear();
+    m_reusedThumbnails.clear();
+    return entry;
+}
+
+void MainWindow::activateWarmDocument(std::unique_ptr<WarmDocument> warm)
+{
+    setActiveDocument(warm->document, warm->device, std::move(warm->textCache));
+    warm->document = nullptr;
+    warm->device = nullptr;
+
+    m_currentFilePath = warm->filePath;
+    m_currentFileSize = warm->fileSize;
+    m_currentFileModified = warm->lastModified;
+    setWindowTitle(QFileInfo(m_currentFilePath).fileName());
+    statusBar()->clearMessage();
+    updatePageCountLabel();
+
+    m_pageHeights = warm->pageHeights;
+    if (m_minimapPanel)
+        m_minimapPanel->setPageHeights(m_pageHeights);
+
+    // Reuse the rendered thumbnails; continue rendering where we left off
+    if (m_thumbnailList) {
+        m_thumbnailList->setUpdatesEnabled(false);
+        m_thumbnailList->clear();
+        for (int i = 0; i < warm->thumbnails.size(); ++i) {
+            auto* item = new QListWidgetItem(warm->thumbnails.at(i), QString::number(i + 1), m_thumbnailList);
+            item->setTextAlignment(Qt::AlignCenter);
+            item->setData(Qt::UserRole, i);
+        }
+        m_thumbnailList->setUpdatesEnabled(true);
+        m_nextThumbnail = warm->thumbnailsRendered;
+        PerfStats::recordThumbnailHits(warm->thumbnailsRendered);
+        if (m_thumbnailDock && m_thumbnailDock->isVisible() && m_nextThumbnail < m_thumbnailList->count())
+            m_thumbnailTimer->start();
+    }
+    updatePerfMemory();
+
+    // The page text came back with the document, so searching again only
+    // matches; the current hit is restored once it has been found again
+    m_restoreSearchIndex = warm->searchResultIndex;
+    runSearchFromSearchBox();
+    scheduleTextPrefetch();
+    // The layer travels in the text cache; only look it up if it was not ready yet
+    if (TextLayerPtr layer = m_searchEngine->textCache()->textLayer())
+        m_view->setTextLayer(layer);
+    else
+        requestTextLayer();
+    watchFile(m_currentFilePath);
+    requestFingerprints();
+
+    restoreViewport(warm->zoomMode, warm->zoomFactor, warm->horizontalScroll, warm->verticalScroll);
+}
+
+void MainWindow::restoreViewport(QPdfView::ZoomMode zoomMode, qreal zoomFactor,
+                                 int horizontalScroll, int verticalScroll)
+{
+    m_view->setZoomMode(zoomMode);
+    if (zoomMode == QPdfView::ZoomMode::Custom)
+        m_view->setZoomFactor(zoomFactor);
+
+    // Apply the scroll position once QPdfView has laid out the document again
+    auto applyScroll = [this, horizontalScroll, verticalScroll]{
+        m_view->horizontalScrollBar()->setValue(horizontalScroll);
+        m_view->verticalScrollBar()->setValue(verticalScroll);
+    };
+    applyScroll();
+    QTimer::singleShot(0, this, applyScroll);
+    updateViewportOverlay();
+}
+
+void MainWindow::restoreSession(const SessionState& state)
+{
+    if (!state.isValid())
+        return;
+    const QString path = QFileInfo(state.filePath).absoluteFilePath();
+    if (path == m_currentFilePath && !isLoading()) {
+        restoreViewport(state.zoomMode, state.zoomFactor, state.horizontalScroll, state.verticalScroll);
+        return;
+    }
+    if (path == m_loadingFilePath) {
+        m_view->setZoomMode(state.zoomMode);
+        if (state.zoomMode == QPdfView::ZoomMode::Custom)
+            m_view->setZoomFactor(state.zoomFactor);
+        // Placeholder frames from cached page sizes already have the scroll range
+        m_view->horizontalScrollBar()->setValue(state.horizontalScroll);
+        m_view->verticalScrollBar()->setValue(state.verticalScroll);
+        m_pendingSession = state;
+        m_pendingSession->filePath = path;
+    }
+}
+
+SessionState MainWindow::currentSessionState() const
+{
+    SessionState state;
+    state.filePath = m_currentFilePath;
+    state.originalPath = m_originalFilePath;
+    if (auto* nav = m_view->pageNavigator())
+        state.page = nav->currentPage();
+    state.zoomMode = m_view->zoomMode();
+    state.zoomFactor = m_view->zoomFactor();
+    state.horizontalScroll = m_view->horizontalScrollBar()->value();
+    state.verticalScroll = m_view->verticalScrollBar()->value();
+    return state;
+}
+
+void MainWindow::openPdf(const QString& filePath)
+{
+    TRACE_SCOPE("openPdf");
+    if (HttpRangeReply::isHttpUrl(filePath)) {
+        openRemotePdf(QUrl(filePath));
+        return;
+    }
+    const QFileInfo fi(filePath);
+    const QString path = fi.absoluteFilePath();
+
+    // Reopening the document on screen is a no-op unless it changed on disk
+    if (path == m_currentFilePath && m_loadingFilePath.isEmpty()
+        && fi.size() == m_currentFileSize && fi.lastModified() == m_currentFileModified)
+        return;
+    if (path == m_loadingFilePath)
+        return;
+
+    std::unique_ptr<WarmDocument> warm = m_recentDocuments.take(path);
+    if (warm && !warm->matchesFile(fi))
+        warm.reset();
+
+    // Fail before leaving the current document if the file cannot be read at all
+    if (!warm) {
+        QFile probe(path);
+        if (!probe.open(QIODevice::ReadOnly)) {
+            QMessageBox::critical(this, tr("Could not open PDF"),
+                                  tr("Could not open file: %1\n%2")
+                                      .arg(path, probe.errorString()));
+            return;
+        }
+    }
+
+    // Keep the outgoing document warm if it had finished loading; remote
+    // documents are not kept, their bytes stay in the range cache
+    std::unique_ptr<WarmDocument> outgoing = detachCurrentDocument();
+    const bool keepOutgoing = !outgoing->filePath.isEmpty() && outgoing->filePath != path
+        && !HttpRangeReply::isHttpUrl(outgoing->filePath)
+        && outgoing->document->status() == QPdfDocument::Status::Ready;
+
+    clearMinimapMarkers();
+    PerfStats::reset();
+    if (warm) {
+        activateWarmDocument(std::move(warm));
+    } else {
+        // Empty until the loader hands over the parsed document; the search
+        // box is searched again once it is ready
+        setActiveDocument(createDocument(), nullptr);
+        // The pool's instances hold the old version of a changed file; it
+        // is reopened on the new one once that is ready (ensureDocumentPool)
+        if (m_documentPool->filePath() == path)
+            m_documentPool->close();
+
+        // Show the loading state; the window keeps painting while pdfium
+        // parses on the loader's thread
+        m_loadingFilePath = path;
+        m_loadStartNs = Trace::now();
+        m_currentFileSize = fi.size();
+        m_currentFileModified = fi.lastModified();
+        if (m_thumbnailList)
+            m_thumbnailList->clear();
+        if (m_pageCountLabel)
+            m_pageCountLabel->setText(QStringLiteral("..."));
+        m_pendingSession.reset();
+
+        // Lay out the view and minimap from cached page sizes while pdfium
+        // parses; the frames paint before the parse finishes
+        const std::optional<DocumentMetadata> meta = m_sessionStore.loadMetadata(fi);
+        m_hasCachedMetadata = meta.has_value();
+        if (meta) {
+            m_view->setPlaceholderPages(meta->pageSizes);
+            m_pageHeights = meta->pageHeights();
+            if (m_minimapPanel)
+                m_minimapPanel->setPageHeights(m_pageHeights);
+            if (m_pageCountLabel)
+                m_pageCountLabel->setText(QString::number(meta->pageCount()));
+        }
+        statusBar()->showMessage(tr("Loading %1 (%2 MB)...")
+                                     .arg(fi.fileName())
+                                     .arg(double(fi.size()) / (1024.0 * 1024.0), 0, 'f', 1));
+        m_loadGeneration = m_documentLoader->request(path);
+    }
+
+    if (keepOutgoing)
+        m_recentDocuments.put(std::move(outgoing));
+    // Otherwise the outgoing document is released here
+}
+
+void MainWindow::onDocumentReady()
+{
+    if (m_loadingFilePath.isEmpty())
+        return;
+    StartupTimeline::mark("document ready");
+    Trace::complete("loadDocument", m_loadStartNs, Trace::now());
+    const QFileInfo fi(m_loadingFilePath);
+    m_currentFilePath = m_loadingFilePath;
+    m_loadingFilePath.clear();
+
+    statusBar()->clearMessage();
+    setWindowTitle(fi.fileName());
+    updatePageCountLabel();
+    updatePageMetrics();
+    runSearchFromSearchBox();
+    scheduleTextPrefetch();
+    requestTextLayer();
+    updateViewportOverlay();
+
+    m_autoReload = false;
+    if (HttpRangeReply::isHttpUrl(m_currentFilePath)) {
+        watchFile(QString());
+    } else {
+        watchFile(m_currentFilePath);
+        requestFingerprints();
+    }
+
+    // Cache page count and sizes so the next open can lay out immediately
+    if (!m_hasCachedMetadata) {
+        DocumentMetadata meta;
+        meta.fileSize = m_currentFileSize;
+        meta.lastModified = m_currentFileModified;
+        const int pageCount = m_doc->pageCount();
+        meta.pageSizes.reserve(pageCount);
+        for (int i = 0; i < pageCount; ++i)
+            meta.pageSizes.append(m_doc->pagePointSize(i));
+        m_sessionStore.saveMetadata(m_currentFilePath, meta);
+        m_hasCachedMetadata = true;
+    }
+    updatePerfMemory();
+    if (m_pendingSession && m_pendingSession->filePath == m_currentFilePath) {
+        const SessionState state = *m_pendingSession;
+        m_pendingSession.reset();
+        restoreViewport(state.zoomMode, state.zoomFactor, state.horizontalScroll, state.verticalScroll);
+    }
+
+    // Thumbnails are rendered incrementally after the first page is shown
+    updateThumbnails();
+    emit documentReady(m_currentFilePath);
+}
+
+void MainWindow::onDocumentLoadFailed(const QString& reason)
+{
+    const QString path = m_loadingFilePath;
+    m_loadingFilePath.clear();
+    statusBar()->clearMessage();
+    updatePageCountLabel();
+    updatePageMetrics();
+    emit documentLoadFailed(path);
+    m_reloadCarryOver.reset();
+    if (m_autoReload) {
+        // Probably caught mid-write; the next change retries
+        m_autoReload = false;
+        m_reloadFailed = true;
+        statusBar()->showMessage(tr("Could not reload %1; waiting for the next change")
+                                     .arg(QFileInfo(path).fileName()));
+        return;
+    }
+    QMessageBox::critical(this, tr("Could not open PDF"),
+                          tr("Could not open file: %1\n%2").arg(path, reason));
+}
+
+void MainWindow::openRemotePdf(const QUrl& url)
+{
+    const QString location = url.toString();
+    if (location == m_loadingFilePath || (location == m_currentFilePath && m_loadingFilePath.isEmpty()))
+        return;
+
+    std::unique_ptr<WarmDocument> outgoing = detachCurrentDocument();
+    const bool keepOutgoing = !outgoing->filePath.isEmpty() && !HttpRangeReply::isHttpUrl(outgoing->filePath)
+        && outgoing->document->status() == QPdfDocument::Status::Ready;
+
+    clearMinimapMarkers();
+    PerfStats::reset();
+    setActiveDocument(createDocument(), nullptr);
+    m_loadingFilePath = location;
+    m_loadStartNs = Trace::now();
+    m_currentFileSize = 0;
+    m_currentFileModified = QDateTime();
+    if (m_thumbnailList)
+        m_thumbnailList->clear();
+    if (m_pageCountLabel)
+        m_pageCountLabel->setText(QStringLiteral("..."));
+    m_pendingSession.reset();
+    // Page layout metadata is keyed by local files; none is read or written
+    m_hasCachedMetadata = true;
+
+    // The reply belongs to the document and goes away with it. QtPdf marks
+    // the document Ready as soon as the first pages are available, while
+    // the rest keeps arriving.
+    if (!m_network)
+        m_network = new QNetworkAccessManager(this);
+    auto* reply = new HttpRangeReply(url, m_network, m_doc);
+    m_remoteReply = reply;
+    // The cache file may be rewritten; reopened once the download is complete
+    if (m_documentPool->filePath() == reply->cacheFilePath())
+        m_documentPool->close();
+    const QString name = url.fileName();
+    connect(reply, &QNetworkReply::downloadProgress, this, [this, reply, name](qint64 received, qint64 total){
+        if (reply != m_remoteReply || total <= 0 || reply->isFinished())
             return;
-        }
-        QString dest = QFileDialog::getSaveFileName(this, tr("Save As"),
-                                                    QDir::home().filePath(QFileInfo(m_currentFilePath).fileName()),
-                                                    tr("PDF Files (*.pdf)"));
-        if (dest.isEmpty()) return;
-        if (QFileInfo::exists(dest)) QFile::remove(dest);
-        if (!QFile::copy(m_currentFilePath, dest)) {
-            QMessageBox::critical(this, tr("Save"), tr("Save failed: %1").arg(dest));
-        }
+        statusBar()->showMessage(tr("Loading %1... %2 of %3 MB")
+                                     .arg(name)
+                                     .arg(double(received) / (1024.0 * 1024.0), 0, 'f', 1)
+                                     .arg(double(total) / (1024.0 * 1024.0), 0, 'f', 1));
     });
-
-    // Print action
-    connect(printAct, &QAction::triggered, this, [this]{
-        if (!m_doc || m_doc->pageCount() <= 0) return;
-        QPrinter printer(QPrinter::HighResolution);
-        QPrintDialog dlg(&printer, this);
-        if (dlg.exec() != QDialog::Accepted) return;
-        QPainter painter(&printer);
-        if (!painter.isActive()) return;
-        const int pageCount = m_doc->pageCount();
-        for (int i = 0; i < pageCount; ++i) {
-            const QSize target = painter.viewport().size();
-            if (target.isEmpty()) break;
-            QImage img = m_doc->render(i, target);
-            painter.drawImage(QPoint(0,0), img);
-            if (i + 1 < pageCount)
-                printer.newPage();
-        }
+    connect(reply, &QNetworkReply::finished, this, [this, reply]{
+        if (reply == m_remoteReply)
+            onRemoteDownloadFinished();
     });
+    statusBar()->showMessage(tr("Loading %1...").arg(name));
+    m_doc->load(reply);
 
-    // Email action
-    connect(mailAct, &QAction::triggered, this, [this]{
-        if (m_currentFilePath.isEmpty()) {
-            QMessageBox::warning(this, tr("Email"), tr("Please open a PDF first."));
-            return;
-        }
-        const QFileInfo fi(m_currentFilePath);
-        const QString subject = tr("PDF sharing: %1").arg(fi.fileName());
-        QString body = tr("File path: %1").arg(fi.absoluteFilePath());
-        QUrl mailto(QStringLiteral("mailto:"));
-        QUrlQuery query;
-        query.addQueryItem(QStringLiteral("subject"), subject);
-        query.addQueryItem(QStringLiteral("body"), body);
-        mailto.setQuery(query);
-        if (!QDesktopServices::openUrl(mailto)) {
-            QMessageBox::warning(this, tr("Email"), tr("Could not open default email application."));
-        }
-    });
+    if (keepOutgoing)
+        m_recentDocuments.put(std::move(outgoing));
+}
 
-    adjustToolBarStyle();
+void MainWindow::onRemoteDownloadFinished()
+{
+    HttpRangeReply* reply = m_remoteReply;
+    if (reply->error() != QNetworkReply::NoError) {
+        // While loading, the document reports the failure itself
+        if (m_loadingFilePath.isEmpty())
+            statusBar()->showMessage(tr("Download failed: %1").arg(reply->errorString()), 8000);
+        return;
+    }
+    statusBar()->showMessage(tr("Downloaded %1: %2 MB fetched, %3 MB from cache, %4 requests")
+                                 .arg(reply->url().fileName())
+                                 .arg(double(reply->fetchedBytes()) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(double(reply->cachedBytes()) / (1024.0 * 1024.0), 0, 'f', 1)
+                                 .arg(reply->requestCount()),
+                             8000);
+    if (!m_loadingFilePath.isEmpty() || !reply->isComplete())
+        return;
+    // The cache file is now a complete local copy: start what needs a file
+    if (m_thumbnailDock && m_thumbnailDock->isVisible())
+        m_thumbnailTimer->start();
+    if (m_searchEdit && m_searchEdit->text().size() >= 2)
+        runSearchFromSearchBox();
+    requestTextLayer();
 }
 
-void MainWindow::setupShortcuts()
+void MainWindow::requestTextLayer()
 {
-    // Ctrl+F focuses search box
-    auto* focusFind = new QShortcut(QKeySequence::Find, this);
-    connect(focusFind, &QShortcut::activated, this, [this]{
-        m_searchEdit->setFocus(Qt::ShortcutFocusReason);
-        m_searchEdit->selectAll();
-    });
+    // Maps an existing layer; a missing one is built on the pool
+    const QString path = localDocumentPath();
+    if (path.isEmpty() || !m_doc || !ensureDocumentPool())
+        return;
+    m_textLayerLoader->request(path, m_documentPool, m_doc->pageCount());
+}
 
-    // Ctrl+C copies selection or current search match
-    auto* copyAct = new QAction(tr("Copy"), this);
-    copyAct->setShortcut(QKeySequence::Copy);
-    addAction(copyAct);
-    connect(copyAct, &QAction::triggered, this, [this]{
-        if (m_view->copySelectionToClipboard())
-            return;
-        // Fallback: copy current search match text
-        const int idx = m_view->currentSearchResultIndex();
-        if (idx >= 0) {
-            QPdfLink link = m_searchModel->resultAtIndex(idx);
-            if (link.isValid())
-                link.copyToClipboard();
+void MainWindow::requestFingerprints()
+{
+    if (!m_doc || !ensureDocumentPool())
+        return;
+    m_fingerprinter->request(m_currentFilePath, m_documentPool, m_doc->pageCount());
+}
+
+bool MainWindow::ensureDocumentPool()
+{
+    const QString path = localDocumentPath();
+    if (path.isEmpty())
+        return false;
+    if (m_documentPool->filePath() != path)
+        m_documentPool->open(path);
+    return true;
+}
+
+QString MainWindow::localDocumentPath() const
+{
+    if (!HttpRangeReply::isHttpUrl(m_currentFilePath))
+        return m_currentFilePath;
+    return m_remoteReply && m_remoteReply->isComplete() ? m_remoteReply->cacheFilePath() : QString();
+}
+
+void MainWindow::watchFile(const QString& path)
+{
+    const QStringList watched = m_fileWatcher->files() + m_fileWatcher->directories();
+    if (!watched.isEmpty())
+        m_fileWatcher->removePaths(watched);
+    m_reloadTimer->stop();
+    m_watchedFilePath = path;
+    m_reloadFailed = false;
+    if (path.isEmpty())
+        return;
+    // The directory notices a file that is replaced by renaming over it
+    m_fileWatcher->addPath(path);
+    m_fileWatcher->addPath(QFileInfo(path).absolutePath());
+}
+
+void MainWindow::onWatchedFileChanged()
+{
+    if (m_watchedFilePath.isEmpty())
+        return;
+    const QFileInfo fi(m_watchedFilePath);
+    if (!fi.exists())
+        return;
+    if (!m_fileWatcher->files().contains(m_watchedFilePath))
+        m_fileWatcher->addPath(m_watchedFilePath);
+    // Other files in the directory changed
+    if (!m_reloadFailed && fi.size() == m_currentFileSize && fi.lastModified() == m_currentFileModified)
+        return;
+    m_reloadProbeSize = fi.size();
+    m_reloadTimer->start();
+}
+
+void MainWindow::reloadChangedFile()
+{
+    const QString path = m_watchedFilePath;
+    const QFileInfo fi(path);
+    if (path.isEmpty() || !fi.exists())
+        return;
+    // Still being written, or another document is loading: wait
+    if (fi.size() != m_reloadProbeSize || isLoading()) {
+        m_reloadProbeSize = fi.size();
+        m_reloadTimer->start();
+        return;
+    }
+    if (path != m_currentFilePath && !m_reloadFailed)
+        return;
+    if (path == m_currentFilePath && fi.size() == m_currentFileSize && fi.lastModified() == m_currentFileModified)
+        return;
+
+    // Keep what was built for pages that come back unchanged; matched once
+    // the new version has been fingerprinted
+    m_reloadCarryOver.reset();
+    if (path == m_currentFilePath && !m_pageFingerprints.isEmpty()) {
+        ReloadCarryOver carry;
+        carry.filePath = path;
+        carry.fingerprints = m_pageFingerprints;
+        carry.text = m_searchEngine->textCache()->snapshot(&carry.textCached);
+        if (m_thumbnailList) {
+            const int count = m_thumbnailList->count();
+            carry.thumbnails.resize(count);
+            for (int i = 0; i < count; ++i) {
+                const bool rendered = (i < m_nextThumbnail && !m_thumbnailsInFlight.contains(i))
+                    || m_reusedThumbnails.contains(i);
+                if (rendered)
+                    carry.thumbnails[i] = m_thumbnailList->item(i)->icon();
+            }
         }
-    });
+        m_reloadCarryOver = std::move(carry);
+    }
 
-    // Escape clears search
-    auto* esc = new QShortcut(QKeySequence(Qt::Key_Escape), this);
-    connect(esc, &QShortcut::activated, this, [this]{ m_searchEdit->clear(); });
+    // Scroll position and zoom are restored once the new version is ready
+    const SessionState view = currentSessionState();
+    m_autoReload = true;
+    openPdf(path);
+    if (!isLoading() && m_currentFilePath != path)
+        m_autoReload = false;
+    if (view.isValid())
+        restoreSession(view);
 }
 
-void MainWindow::openPdf(const QString& filePath)
+void MainWindow::applyReloadCarryOver()
 {
-    QFileInfo fi(filePath);
-    const auto err = m_doc->load(filePath);
-    if (err != QPdfDocument::Error::None) {
-        QMessageBox::critical(this, tr("Could not open PDF"),
-                              tr("Could not open file: %1\nError code: %2")
-                                  .arg(fi.absoluteFilePath()).arg(int(err)));
+    if (!m_reloadCarryOver || m_reloadCarryOver->filePath != m_currentFilePath)
         return;
+    const ReloadCarryOver carry = std::move(*m_reloadCarryOver);
+    m_reloadCarryOver.reset();
+
+    // First occurrence wins for repeated pages. Pages without text have
+    // no fingerprint and are always rebuilt.
+    QHash<QByteArray, int> oldPages;
+    for (int i = int(carry.fingerprints.size()) - 1; i >= 0; --i) {
+        if (!carry.fingerprints.at(i).isEmpty())
+            oldPages.insert(carry.fingerprints.at(i), i);
     }
 
-    m_currentFilePath = fi.absoluteFilePath();
-    setWindowTitle(fi.fileName());
-    updatePageCountLabel();
-    updateThumbnails();
-    updatePageMetrics();
-    updateSearchMinimap(m_searchEdit ? m_searchEdit->text() : QString());
-    updateViewportOverlay();
+    PageTextCache* textCache = m_searchEngine->textCache();
+    int unchanged = 0;
+    int thumbnails = 0;
+    for (int page = 0; page < m_pageFingerprints.size(); ++page) {
+        const QByteArray& fingerprint = m_pageFingerprints.at(page);
+        if (fingerprint.isEmpty())
+            continue;
+        // Same position first, then anywhere (pages inserted or removed before it)
+        const int old = page < carry.fingerprints.size() && carry.fingerprints.at(page) == fingerprint
+            ? page : oldPages.value(fingerprint, -1);
+        if (old < 0)
+            continue;
+        ++unchanged;
+        if (old < carry.textCached.size() && carry.textCached.at(old))
+            textCache->insert(m_doc, page, carry.text.at(old));
+        if (old < carry.thumbnails.size() && !carry.thumbnails.at(old).isNull() && m_thumbnailList) {
+            if (QListWidgetItem* item = m_thumbnailList->item(page)) {
+                item->setIcon(carry.thumbnails.at(old));
+                m_reusedThumbnails.insert(page);
+                ++thumbnails;
+            }
+        }
+    }
+    PerfStats::recordThumbnailHits(thumbnails);
+    updateSearchSchedule();
+    updatePerfMemory();
+    statusBar()->showMessage(tr("Reloaded %1: %2 of %3 pages unchanged")
+                                 .arg(QFileInfo(m_currentFilePath).fileName())
+                                 .arg(unchanged).arg(m_pageFingerprints.size()),
+                             5000);
 }
 
 void MainWindow::updateSearchStatus()
 {
     if (!m_searchStatus) return;
     const QString term = m_searchEdit ? m_searchEdit->text() : QString();
-    const int count = m_searchModel ? m_searchModel->rowCount(QModelIndex()) : 0;
-    const int idx = m_view ? m_view->currentSearchResultIndex() : -1;
+    const int count = searchResultCount();
+    m_searchStatus->setToolTip(m_searchError);
+    if (!m_searchError.isEmpty()) {
+        m_searchStatus->setText(tr("Invalid pattern"));
+        if (m_actFindPrev) m_actFindPrev->setEnabled(false);
+        if (m_actFindNext) m_actFindNext->setEnabled(false);
+        return;
+    }
     if (term.size() < 2 || count <= 0) {
-        m_searchStatus->setText(tr("0 Results"));
+        m_searchStatus->setText(m_searchInProgress ? tr("Searching...") : tr("0 Results"));
         if (m_actFindPrev) m_actFindPrev->setEnabled(false);
         if (m_actFindNext) m_actFindNext->setEnabled(false);
         return;
     }
-    m_searchStatus->setText(tr("%1 Results").arg(count));
+    m_searchStatus->setText(m_searchInProgress ? tr("%1 Results...").arg(count)
+                                               : tr("%1 Results").arg(count));
     if (m_actFindPrev) m_actFindPrev->setEnabled(true);
     if (m_actFindNext) m_actFindNext->setEnabled(true);
 }
 
 void MainWindow::jumpToSearchResult(int idx)
 {
-    if (!m_searchModel || !m_view)
+    if (!m_view)
         return;
-    if (idx < 0)
+    int page = -1;
+    QRectF rect;
+    if (!searchResultAt(idx, &page, &rect))
         return;
-    QPdfLink link = m_searchModel->resultAtIndex(idx);
-    if (!link.isValid())
-        return;
-    const auto rects = link.rectangles();
-    if (rects.isEmpty()) {
-        if (auto* nav = m_view->pageNavigator())
-            nav->jump(link);
+    if (rect.isEmpty()) {
+        goToPage(page);
         return;
     }
-    m_view->ensurePageRectVisible(link.page(), rects.first());
+    m_view->ensurePageRectVisible(page, rect);
 }
 
 void MainWindow::updatePageCountLabel()
@@ -525,6 +1643,13 @@ void MainWindow::resizeEvent(QResizeEvent* ev)
     adjustToolBarStyle();
 }
 
+void MainWindow::closeEvent(QCloseEvent* ev)
+{
+    if (!m_currentFilePath.isEmpty())
+        m_sessionStore.saveSession(currentSessionState());
+    QMainWindow::closeEvent(ev);
+}
+
 void MainWindow::dragEnterEvent(QDragEnterEvent* ev)
 {
     if (ev->mimeData()->hasUrls()) {
@@ -536,6 +1661,9 @@ void MainWindow::dragEnterEvent(QDragEnterEvent* ev)
                     ev->acceptProposedAction();
                     return;
                 }
+            } else if (HttpRangeReply::isHttpUrl(url.toString())) {
+                ev->acceptProposedAction();
+                return;
             }
         }
     }
@@ -558,11 +1686,245 @@ void MainWindow::dropEvent(QDropEvent* ev)
                 ev->acceptProposedAction();
                 return;
             }
+        } else if (HttpRangeReply::isHttpUrl(url.toString())) {
+            // Links dragged from a browser load progressively
+            openPdf(url.toString());
+            ev->acceptProposedAction();
+            return;
         }
     }
     ev->ignore();
 }
 
+void MainWindow::setupSearchResultsPanel()
+{
+    m_resultsDock = new QDockWidget(tr("Search Results"), this);
+    m_resultsDock->setObjectName(QStringLiteral("searchResultsDock"));
+    m_resultsDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea
+                                   | Qt::BottomDockWidgetArea);
+
+    // Uniform item sizes keep QListView from asking every row for its size
+    // hint, so snippets are only built for rows scrolled into view
+    m_resultsList = new QListView(m_resultsDock);
+    m_resultsList->setUniformItemSizes(true);
+    m_resultsList->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_resultsList->setSelectionMode(QAbstractItemView::SingleSelection);
+    m_resultsList->setTextElideMode(Qt::ElideRight);
+    m_resultsList->setModel(m_resultsModel);
+
+    m_resultsDock->setWidget(m_resultsList);
+    addDockWidget(Qt::RightDockWidgetArea, m_resultsDock);
+    m_resultsDock->hide();
+
+    // Ctrl+Shift+F shows or hides the panel
+    QAction* toggle = m_resultsDock->toggleViewAction();
+    toggle->setShortcut(QKeySequence(Qt::CTRL | Qt::SHIFT | Qt::Key_F));
+    addAction(toggle);
+    m_view->addContextMenuAction(toggle);
+
+    connect(m_resultsList->selectionModel(), &QItemSelectionModel::currentRowChanged, this,
+            [this](const QModelIndex& current){
+        if (current.isValid())
+            selectSearchResult(current.row());
+    });
+    connect(m_resultsModel, &QAbstractItemModel::modelReset, this, &MainWindow::syncSearchResultsSelection);
+}
+
+void MainWindow::syncSearchResultsSelection()
+{
+    if (!m_resultsList)
+        return;
+    const QModelIndex index = m_resultsModel->index(currentSearchIndex());
+    if (index == m_resultsList->currentIndex())
+        return;
+    const QSignalBlocker blocker(m_resultsList->selectionModel());
+    m_resultsList->setCurrentIndex(index);
+    m_resultsList->scrollTo(index);
+    // The blocked selection model did not repaint the old and new rows
+    m_resultsList->viewport()->update();
+}
+
+void MainWindow::searchInFolder()
+{
+    const QString startDir = m_currentFilePath.isEmpty() ? QDir::homePath()
+                                                         : QFileInfo(m_currentFilePath).absolutePath();
+    const QString folder = QFileDialog::getExistingDirectory(this, tr("Search in Folder"), startDir);
+    if (folder.isEmpty())
+        return;
+    QString query = m_searchEdit ? m_searchEdit->text() : QString();
+    if (query.size() < 2) {
+        bool ok = false;
+        query = QInputDialog::getText(this, tr("Search in Folder"), tr("Search for:"),
+                                      QLineEdit::Normal, query, &ok);
+        if (!ok || query.size() < 2)
+            return;
+    }
+    searchFolder(folder, query);
+}
+
+void MainWindow::searchFolder(const QString& folder, const QString& query)
+{
+    setupFolderSearchPanel();
+    m_folderTree->clear();
+    m_folderQuery = query;
+    m_folderOptions = searchOptions();
+    m_folderFileCount = -1;
+    m_folderFilesDone = 0;
+    m_folderHitCount = 0;
+    m_folderSearchRunning = m_folderSearch->start(folder, query, m_folderOptions);
+    if (!m_folderSearchRunning)
+        m_folderStatus->setText(tr("Invalid pattern: %1").arg(m_folderSearch->errorString()));
+    else
+        updateFolderSearchStatus();
+    m_folderDock->setWindowTitle(tr("Folder Search: %1").arg(QDir(folder).dirName()));
+    m_folderDock->show();
+    m_folderDock->raise();
+}
+
+void MainWindow::setupFolderSearchPanel()
+{
+    if (m_folderDock)
+        return;
+    m_folderSearch = new FolderSearch(this);
+    connect(m_folderSearch, &FolderSearch::started, this, [this](quint64 generation, int fileCount){
+        if (generation != m_folderSearch->generation())
+            return;
+        m_folderFileCount = fileCount;
+        updateFolderSearchStatus();
+    });
+    connect(m_folderSearch, &FolderSearch::fileSearched, this, &MainWindow::onFolderFileSearched);
+    connect(m_folderSearch, &FolderSearch::finished, this, [this](quint64 generation, int, int, qint64){
+        if (generation != m_folderSearch->generation())
+            return;
+        m_folderSearchRunning = false;
+        updateFolderSearchStatus();
+    });
+
+    m_folderDock = new QDockWidget(tr("Folder Search"), this);
+    m_folderDock->setObjectName(QStringLiteral("folderSearchDock"));
+    m_folderDock->setAllowedAreas(Qt::LeftDockWidgetArea | Qt::RightDockWidgetArea
+                                  | Qt::BottomDockWidgetArea);
+
+    auto* panel = new QWidget(m_folderDock);
+    auto* layout = new QVBoxLayout(panel);
+    layout->setContentsMargins(0, 0, 0, 0);
+    m_folderStatus = new QLabel(panel);
+    m_folderStatus->setContentsMargins(6, 4, 6, 4);
+    layout->addWidget(m_folderStatus);
+
+    // Files with their hit counts; the first hits of each file below it
+    m_folderTree = new QTreeWidget(panel);
+    m_folderTree->setHeaderHidden(true);
+    m_folderTree->setUniformRowHeights(true);
+    m_folderTree->setTextElideMode(Qt::ElideRight);
+    layout->addWidget(m_folderTree);
+
+    m_folderDock->setWidget(panel);
+    addDockWidget(Qt::RightDockWidgetArea, m_folderDock);
+
+    connect(m_folderTree, &QTreeWidget::currentItemChanged, this,
+            [this](QTreeWidgetItem* current){ openFolderSearchHit(current); });
+}
+
+void MainWindow::onFolderFileSearched(quint64 generation, const FolderFileResult& result)
+{
+    if (generation != m_folderSearch->generation())
+        return;
+    ++m_folderFilesDone;
+    m_folderHitCount += result.hitCount;
+    if (result.hitCount > 0 || !result.error.isEmpty()) {
+        const QString name = QFileInfo(result.filePath).fileName();
+        auto* file = new QTreeWidgetItem(m_folderTree);
+        file->setToolTip(0, result.filePath);
+        file->setData(0, Qt::UserRole, result.filePath);
+        if (!result.error.isEmpty()) {
+            file->setText(0, tr("%1 - %2").arg(name, result.error));
+            file->setDisabled(true);
+        } else {
+            file->setText(0, tr("%1 (%2)").arg(name).arg(result.hitCount));
+            // Activating the file selects its first hit
+            file->setData(0, Qt::UserRole + 1, result.hits.first().page);
+            file->setData(0, Qt::UserRole + 2, result.hits.first().start);
+            for (const FolderHit& hit : result.hits) {
+                auto* row = new QTreeWidgetItem(file);
+                row->setText(0, tr("p. %1").arg(hit.page + 1) + QStringLiteral("   ") + hit.snippet);
+                row->setData(0, Qt::UserRole, result.filePath);
+                row->setData(0, Qt::UserRole + 1, hit.page);
+                row->setData(0, Qt::UserRole + 2, hit.start);
+            }
+            if (result.hitCount > result.hits.size()) {
+                auto* more = new QTreeWidgetItem(file);
+                more->setText(0, tr("%1 more in the document").arg(result.hitCount - int(result.hits.size())));
+                more->setData(0, Qt::UserRole, result.filePath);
+                more->setData(0, Qt::UserRole + 1, -1);
+            }
+        }
+    }
+    updateFolderSearchStatus();
+}
+
+void MainWindow::updateFolderSearchStatus()
+{
+    if (!m_folderStatus)
+        return;
+    const int files = m_folderTree->topLevelItemCount();
+    if (m_folderFileCount < 0)
+        m_folderStatus->setText(tr("Listing files..."));
+    else if (m_folderSearchRunning)
+        m_folderStatus->setText(tr("%1 of %2 files searched, %3 hits in %4 files...")
+                                    .arg(m_folderFilesDone).arg(m_folderFileCount)
+                                    .arg(m_folderHitCount).arg(files));
+    else
+        m_folderStatus->setText(tr("%1 hits in %2 of %3 files")
+                                    .arg(m_folderHitCount).arg(files).arg(m_folderFileCount));
+}
+
+void MainWindow::openFolderSearchHit(QTreeWidgetItem* item)
+{
+    if (!item || item->isDisabled())
+        return;
+    const QString path = item->data(0, Qt::UserRole).toString();
+    const QVariant page = item->data(0, Qt::UserRole + 1);
+    const QVariant start = item->data(0, Qt::UserRole + 2);
+
+    // Search the opened file with the folder query so all its hits are
+    // highlighted; the activated one is selected once it has been found
+    if (m_searchEdit) {
+        const QSignalBlocker blocker(m_searchEdit);
+        m_searchEdit->setText(m_folderQuery);
+    }
+    if (m_actWholeWord && m_actRegex) {
+        const QSignalBlocker blockWord(m_actWholeWord);
+        const QSignalBlocker blockRegex(m_actRegex);
+        m_actWholeWord->setChecked(m_folderOptions.testFlag(TextMatcher::WholeWord));
+        m_actRegex->setChecked(m_folderOptions.testFlag(TextMatcher::Regex));
+    }
+    if (m_searchDebounce)
+        m_searchDebounce->stop();
+    m_pendingFolderHit = {QFileInfo(path).absoluteFilePath(),
+                          start.isValid() ? page.toInt() : -1, start.isValid() ? start.toInt() : -1};
+
+    openPdf(path);
+    m_restoreSearchIndex = -1;
+    // A document that is loading is searched once it is ready
+    if (m_loadingFilePath.isEmpty())
+        runSearchFromSearchBox();
+}
+
+bool MainWindow::selectPendingFolderHit(const QVector<SearchHit>& hits, int firstIndex)
+{
+    if (m_pendingFolderHit.page < 0 || m_pendingFolderHit.filePath != m_currentFilePath)
+        return false;
+    for (int i = 0; i < hits.size(); ++i) {
+        if (hits.at(i).page == m_pendingFolderHit.page && hits.at(i).start == m_pendingFolderHit.start) {
+            m_pendingFolderHit = {};
+            selectSearchResult(firstIndex + i);
+            return true;
+        }
+    }
+    return false;
+}
+
 void MainWindow::setupThumbnailPanel()
 {
     m_thumbnailDock = new QDockWidget(tr("Pages"), this);
@@ -580,6 +1942,14 @@ void MainWindow::setupThumbnailPanel()
     addDockWidget(Qt::LeftDockWidgetArea, m_thumbnailDock);
     m_thumbnailDock->hide();
 
+    m_thumbnailTimer = new QTimer(this);
+    m_thumbnailTimer->setInterval(0);
+    connect(m_thumbnailTimer, &QTimer::timeout, this, &MainWindow::renderThumbnailBatch);
+    connect(m_thumbnailDock, &QDockWidget::visibilityChanged, this, [this](bool visible){
+        if (visible && m_thumbnailList && m_nextThumbnail < m_thumbnailList->count())
+            m_thumbnailTimer->start();
+    });
+
     connect(m_thumbnailList, &QListWidget::currentRowChanged, this, [this](int row){
         if (row >= 0 && m_view && m_view->pageNavigator()) {
             m_view->pageNavigator()->jump(row, QPointF(0, 0));
@@ -609,29 +1979,78 @@ void MainWindow::setupSearchMinimap()
 
 void MainWindow::updateThumbnails()
 {
+    TRACE_SCOPE("updateThumbnails");
     if (!m_thumbnailList || !m_doc)
         return;
 
+    m_thumbnailTimer->stop();
+    m_documentPool->cancelAll();
+    m_thumbnailsInFlight.clear();
     m_thumbnailList->clear();
+    m_nextThumbnail = 0;
+    m_reusedThumbnails.clear();
 
     const int pageCount = m_doc->pageCount();
     if (pageCount <= 0)
         return;
 
-    // Render high-quality thumbnails (2x resolution for sharpness)
+    // Create all items up front with a blank icon; the page images are
+    // rendered on the document pool (see renderThumbnailBatch).
+    QPixmap placeholder(m_thumbnailList->iconSize());
+    placeholder.fill(Qt::white);
+    const QIcon placeholderIcon(placeholder);
+    m_thumbnailList->setUpdatesEnabled(false);
     for (int i = 0; i < pageCount; ++i) {
-        const QSize renderSize(440, 440);
-        QImage thumbnail = m_doc->render(i, renderSize);
-
-        auto* item = new QListWidgetItem(QIcon(QPixmap::fromImage(thumbnail)),
-                                         QString::number(i + 1),
-                                         m_thumbnailList);
+        auto* item = new QListWidgetItem(placeholderIcon, QString::number(i + 1), m_thumbnailList);
         item->setTextAlignment(Qt::AlignCenter);
         item->setData(Qt::UserRole, i);
     }
+    m_thumbnailList->setUpdatesEnabled(true);
+
+    m_thumbnailList->blockSignals(true);
+    m_thumbnailList->setCurrentRow(0);
+    m_thumbnailList->blockSignals(false);
 
-    if (pageCount > 0)
-        m_thumbnailList->setCurrentRow(0);
+    if (m_thumbnailDock && m_thumbnailDock->isVisible())
+        m_thumbnailTimer->start();
+}
+
+void MainWindow::renderThumbnailBatch()
+{
+    TRACE_SCOPE("renderThumbnailBatch");
+    m_thumbnailTimer->stop();
+    // Remote documents get thumbnails once their download is complete
+    const QString path = localDocumentPath();
+    if (!m_thumbnailList || !m_doc || path.isEmpty())
+        return;
+
+    // Thumbnails are rendered by the pool's own document instances; the GUI
+    // thread only queues pages and sets icons. A few pages per instance are
+    // kept queued so no instance idles between callbacks.
+    ensureDocumentPool();
+    const int maxInFlight = 2 * m_documentPool->instanceCount();
+    const int count = m_thumbnailList->count();
+    while (m_nextThumbnail < count && m_thumbnailsInFlight.size() < maxInFlight) {
+        const int i = m_nextThumbnail++;
+        if (m_reusedThumbnails.contains(i))
+            continue;
+        m_thumbnailsInFlight.insert(i);
+        // Render high-quality thumbnails (2x resolution for sharpness)
+        const QSize renderSize(kThumbnailRenderPx, kThumbnailRenderPx);
+        QElapsedTimer renderTimer;
+        renderTimer.start();
+        m_documentPool->renderPage(i, renderSize, DocumentPool::Priority::Low, this,
+                                   [this, i, renderTimer](const QImage& thumbnail){
+            // Time from queueing to delivery
+            PerfStats::recordThumbnailRender(renderTimer.nsecsElapsed());
+            m_thumbnailsInFlight.remove(i);
+            if (QListWidgetItem* item = m_thumbnailList->item(i))
+                item->setIcon(QIcon(QPixmap::fromImage(thumbnail)));
+            if (m_thumbnailDock && m_thumbnailDock->isVisible())
+                m_thumbnailTimer->start();
+            updatePerfMemory();
+        });
+    }
 }
 
 void MainWindow::updateCurrentPageHighlight()
@@ -788,6 +2207,7 @@ bool MainWindow::computePageOffsets(QVector<qreal>& offsets, qreal& totalHeight)
 
 void MainWindow::updateSearchMinimap(const QString& term)
 {
+    TRACE_SCOPE("updateSearchMinimap");
     if (!m_minimapPanel)
         return;
 
@@ -798,7 +2218,7 @@ void MainWindow::updateSearchMinimap(const QString& term)
         return;
     }
 
-    const int resultCount = m_searchModel ? m_searchModel->rowCount(QModelIndex()) : 0;
+    const int resultCount = searchResultCount();
     if (resultCount <= 0) {
         clearMinimapMarkers(tr("0 Results"));
         m_currentMinimapSource = MinimapSource::NormalSearch;
@@ -812,31 +2232,7 @@ void MainWindow::updateSearchMinimap(const QString& term)
         return;
     }
 
-    QVector<MiniMapMarker> markers;
-    markers.reserve(resultCount);
-    const QColor highlightColor(255, 215, 0, 180);
-    for (int i = 0; i < resultCount; ++i) {
-        QPdfLink link = m_searchModel->resultAtIndex(i);
-        if (!link.isValid())
-            continue;
-        const int page = link.page();
-        if (page < 0 || page >= offsets.size())
-            continue;
-        QRectF rect;
-        const auto rects = link.rectangles();
-        if (!rects.isEmpty())
-            rect = rects.first();
-        const qreal localY = rect.isValid() ? rect.center().y() : 0.0;
-
-        MiniMapMarker marker;
-        marker.page = page;
-        marker.label = trimmed;
-        marker.color = highlightColor;
-        marker.pageRect = rect;
-        marker.normalizedPos = qBound<qreal>(0.0, (offsets.at(page) + localY) / totalHeight, 1.0);
-        markers.append(marker);
-    }
-
+    const QVector<MiniMapMarker> markers = searchMarkers(m_resultsModel->hits(), {trimmed}, offsets, totalHeight);
     if (markers.isEmpty()) {
         clearMinimapMarkers(tr("0 Results"));
         m_currentMinimapSource = MinimapSource::NormalSearch;
@@ -847,9 +2243,24 @@ void MainWindow::updateSearchMinimap(const QString& term)
     m_currentMinimapSource = MinimapSource::NormalSearch;
 }
 
+void MainWindow::appendSearchMinimap(const QVector<SearchHit>& hits)
+{
+    // The query changed with the last full rebuild (runSearchFromSearchBox);
+    // hits of the running search are merged in as they arrive
+    if (!m_minimapPanel || m_currentMinimapSource != MinimapSource::NormalSearch)
+        return;
+    QVector<qreal> offsets;
+    qreal totalHeight = 0.0;
+    if (!computePageOffsets(offsets, totalHeight))
+        return;
+    const QString label = m_searchEdit ? m_searchEdit->text().trimmed() : QString();
+    m_minimapPanel->appendMarkers(searchMarkers(hits, {label}, offsets, totalHeight));
+}
+
 void MainWindow::runMultiTermSearch(const QString& termsText)
 {
     if (!m_minimapPanel) return;
+    m_multiTermMatches = 0;
     if (!m_doc || m_doc->pageCount() <= 0) {
         clearMinimapMarkers(tr("No PDF open"));
         return;
@@ -869,12 +2280,43 @@ void MainWindow::runMultiTermSearch(const QString& termsText)
         return;
     }
 
-    QVector<MiniMapMarker> markers;
-    QVector<int> counts;
-    collectMarkersForTerms(terms, markers, counts);
-
-    m_minimapPanel->setMarkers(markers);
+    // The engine runs one search at a time: a running search-box search
+    // stops here with the hits it has found
+    if (m_searchInProgress) {
+        m_searchInProgress = false;
+        updateSearchStatus();
+        emit searchFinished(searchResultCount());
+    }
+    clearMinimapMarkers();
     m_currentMinimapSource = MinimapSource::MultiTermSearch;
+    m_multiTermTerms = terms;
+    m_multiTermInProgress = true;
+    ensureDocumentPool();
+    // Markers are added as the pages are searched (appendMultiTermMarkers)
+    if (!m_searchEngine->start(terms, searchOptions())) {
+        clearMinimapMarkers(m_searchEngine->errorString());
+        finishMultiTermSearch();
+    }
+}
+
+void MainWindow::appendMultiTermMarkers(const QVector<SearchHit>& hits)
+{
+    m_multiTermMatches += int(hits.size());
+    if (!m_minimapPanel || m_currentMinimapSource != MinimapSource::MultiTermSearch)
+        return;
+    QVector<qreal> offsets;
+    qreal totalHeight = 0.0;
+    if (!computePageOffsets(offsets, totalHeight))
+        return;
+    m_minimapPanel->appendMarkers(searchMarkers(hits, m_multiTermTerms, offsets, totalHeight));
+}
+
+void MainWindow::finishMultiTermSearch()
+{
+    if (!m_multiTermInProgress)
+        return;
+    m_multiTermInProgress = false;
+    emit multiTermSearchFinished(m_multiTermMatches);
 }
 
 void MainWindow::setOriginalFile(const QString& originalPath)
@@ -909,77 +2351,3 @@ void MainWindow::setOriginalFile(const QString& originalPath)
         m_openOriginalAct->setToolTip(tr("Open: %1").arg(fi.fileName()));
     }
 }
-
-int MainWindow::collectMarkersForTerms(const QStringList& terms,
-                                       QVector<MiniMapMarker>& markers,
-                                       QVector<int>& counts)
-{
-    markers.clear();
-    counts.clear();
-
-    if (!m_doc || terms.isEmpty())
-        return 0;
-
-    if (m_pageHeights.size() != m_doc->pageCount())
-        updatePageMetrics();
-
-    QVector<qreal> pageHeights = m_pageHeights;
-    if (pageHeights.size() != m_doc->pageCount()) {
-        pageHeights.clear();
-        const int pc = m_doc->pageCount();
-        pageHeights.reserve(pc);
-        for (int i = 0; i < pc; ++i)
-            pageHeights.append(qMax<qreal>(m_doc->pagePointSize(i).height(), 1.0));
-    }
-
-    const int pageCount = m_doc->pageCount();
-    if (pageCount <= 0)
-        return 0;
-
-    QVector<qreal> pageOffsets(pageCount, 0.0);
-    qreal acc = 0.0;
-    for (int i = 0; i < pageCount; ++i) {
-        pageOffsets[i] = acc;
-        acc += (i < pageHeights.size()) ? pageHeights.at(i) : 1.0;
-    }
-    const qreal totalHeight = acc > 0.0 ? acc : 1.0;
-
-    counts = QVector<int>(terms.size(), 0);
-    const QColor highlightColor(255, 215, 0, 180);
-    int totalMatches = 0;
-
-    for (int page = 0; page < pageCount; ++page) {
-        QPdfSelection textSel = m_doc->getAllText(page);
-        if (!textSel.isValid())
-            continue;
-        const QString text = textSel.text();
-        if (text.isEmpty())
-            continue;
-
-        for (int termIdx = 0; termIdx < terms.size(); ++termIdx) {
-            const QString& term = terms.at(termIdx);
-            int pos = 0;
-            while ((pos = text.indexOf(term, pos, Qt::CaseInsensitive)) >= 0) {
-                const int advance = qMax(1, term.size());
-                QPdfSelection matchSel = m_doc->getSelectionAtIndex(page, pos, term.size());
-                if (matchSel.isValid()) {
-                    const QRectF bounds = matchSel.boundingRectangle();
-                    const qreal localY = bounds.isValid() ? bounds.center().y() : 0.0;
-                    MiniMapMarker marker;
-                    marker.page = page;
-                    marker.label = term;
-                    marker.color = highlightColor;
-                    marker.pageRect = bounds;
-                    const qreal ratio = qBound<qreal>(0.0, (pageOffsets.at(page) + localY) / totalHeight, 1.0);
-                    marker.normalizedPos = ratio;
-                    markers.append(marker);
-                    counts[termIdx] += 1;
-                    ++totalMatches;
-                }
-                pos += advance;
-            }
-        }
-    }
-
-    return totalMatches;
-}
@@ -28,21 +28,49 @@
 #include <QVector>
 #include <QPointer>
 #include <QTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QSet>
+#include <QIcon>
+#include <QStyle>
+#include <memory>
+#include <optional>
 
+#include "FolderSearch.h"
+#include "MemoryReport.h"
 #include "MiniMapWidget.h"
+#include "RecentDocuments.h"
+#include "SearchResultsModel.h"
+#include "SearchScheduler.h"
+#include "SessionStore.h"
+#include "TextLayer.h"
+#include "TextSearch.h"
 
 class QLineEdit;
 class QPdfDocument;
 class SelectablePdfView;
-class QPdfSearchModel;
+class QPdfPageSelector;
 class QLabel;
 class QAction;
 class QListWidget;
+class QListView;
 class QDockWidget;
+class QTreeWidget;
+class QTreeWidgetItem;
 class SearchMinimapPanel;
 class QScrollBar;
 class QDragEnterEvent;
 class QDropEvent;
+class FileCopier;
+class TextExporter;
+class DocumentPool;
+class FileReadDevice;
+class DocumentLoader;
+class HttpRangeReply;
+class PageFingerprinter;
+class QFileSystemWatcher;
+class QNetworkAccessManager;
+class QUrl;
 
 /**
  * @class MainWindow
@@ -58,20 +86,82 @@ public:
     explicit MainWindow(QWidget* parent = nullptr);
 
     /**
-     * @brief Triggers a multi-term search and displays results on minimap.
+     * @brief Starts a multi-term search and displays results on minimap.
      * @param terms Search terms separated by semicolons (e.g., "word1;word2;word3")
      *
      * This method searches for multiple terms simultaneously and shows
-     * all matches as markers on the scrollbar minimap.
+     * all matches as markers on the scrollbar minimap. It runs on the
+     * search engine like a search-box search (which it stops, as typing in
+     * the search box stops it): markers are added as pages are searched,
+     * and multiTermSearchFinished() reports the total.
      */
     void triggerMultiTermSearch(const QString& terms);
 
+    /**
+     * @brief Runs a search-box search immediately (without debounce).
+     * @param text Search text; shorter than 2 characters clears the search
+     */
+    void search(const QString& text);
+
+    /**
+     * @brief Jumps to a page.
+     * @param page Page number (0-indexed)
+     * @return False if there is no such page
+     */
+    bool goToPage(int page);
+
+    /**
+     * @brief Applies a zoom specification.
+     * @param spec "width", "page" or a custom zoom factor (e.g. "1.5")
+     * @return False if @p spec is not valid
+     */
+    bool applyZoom(const QString& spec);
+
+    /// Path of the document on screen (empty while none is loaded)
+    QString currentFilePath() const { return m_currentFilePath; }
+    /// True while a document is being loaded
+    bool isLoading() const { return !m_loadingFilePath.isEmpty(); }
+    /// Page count of the document on screen
+    int pageCount() const;
+    /// Number of search-box results found so far
+    int searchResultCount() const;
+    /// True while the search-box search is still running
+    bool isSearching() const { return m_searchInProgress; }
+    /// True while a multi-term search is still running
+    bool isMultiTermSearching() const { return m_multiTermInProgress; }
+    /// Matches of the last multi-term search found so far
+    int multiTermMatchCount() const { return m_multiTermMatches; }
+
+    /**
+     * @brief Selects the search-box matching mode.
+     * @param wholeWord Only match whole words
+     * @param regex Treat the search text as a regular expression
+     *
+     * Reruns the search-box search with the new mode.
+     */
+    void setSearchMode(bool wholeWord, bool regex);
+
+    /**
+     * @brief Searches every PDF below @p folder for @p query.
+     *
+     * Uses the search-box matching mode. Files with hits are listed in the
+     * "Folder Search" panel as they are searched; activating a hit opens the
+     * file and selects the hit.
+     */
+    void searchFolder(const QString& folder, const QString& query);
+
     /**
      * @brief Opens a PDF file for viewing.
-     * @param filePath Path to the PDF file
+     * @param filePath Path to the PDF file, or an http(s) URL
      *
-     * Loads the PDF document, updates thumbnails, and resets the view.
-     * Shows an error dialog if the file cannot be opened.
+     * Starts parsing the PDF document on a worker thread (DocumentLoader)
+     * and returns; the document is shown once parsed, while the window
+     * keeps painting the loading state. URLs are loaded progressively with range
+     * requests (see HttpRangeReply). Recently viewed documents are kept warm and are
+     * switched back to instantly; reopening the document already on screen
+     * does nothing unless it changed on disk. The page count and minimap are filled in as soon
+     * as they are known; thumbnails are rendered incrementally once the
+     * document is ready. Shows an error dialog if the file cannot be opened.
      */
     void openPdf(const QString& filePath);
 
@@ -93,14 +183,57 @@ public:
      */
     void raiseAndActivate();
 
+    /**
+     * @brief Restores the viewport of a saved session.
+     * @param state Session to restore
+     *
+     * If @p state refers to the document being loaded, the zoom is applied
+     * right away and the scroll position once the document is ready.
+     */
+    void restoreSession(const SessionState& state);
+
+    /**
+     * @brief Returns the current document and viewport as a session.
+     */
+    SessionState currentSessionState() const;
+
+    /**
+     * @brief Estimates memory held by each subsystem for the current document.
+     */
+    MemoryReport memoryReport() const;
+
+signals:
+    /**
+     * @brief Emitted when a document finished loading and is on screen.
+     */
+    void documentReady(const QString& filePath);
+
+    /**
+     * @brief Emitted when loading a document failed.
+     */
+    void documentLoadFailed(const QString& filePath);
+
+    /**
+     * @brief Emitted when the search-box search completed or was abandoned.
+     */
+    void searchFinished(int resultCount);
+
+    /**
+     * @brief Emitted when a multi-term search completed or was abandoned.
+     */
+    void multiTermSearchFinished(int matchCount);
+
 protected:
     void resizeEvent(QResizeEvent* ev) override;
+    void closeEvent(QCloseEvent* ev) override;
     void dragEnterEvent(QDragEnterEvent* ev) override;
     void dropEvent(QDropEvent* ev) override;
 
 private:
     // UI Setup
     void setupUi();
+    void setupDeferredUi();
+    void setupDeferredActions();
     void setupShortcuts();
     void setupThumbnailPanel();
     void setupSearchMinimap();
@@ -109,15 +242,63 @@ private:
     void updateSearchStatus();
     void jumpToSearchResult(int idx);
     void updateSearchMinimap(const QString& term);
+    void appendSearchMinimap(const QVector<SearchHit>& hits);
     void clearMinimapMarkers(const QString& message = QString());
+    void runSearchFromSearchBox();
     void runMultiTermSearch(const QString& terms);
-    int collectMarkersForTerms(const QStringList& terms,
-                               QVector<MiniMapMarker>& markers,
-                               QVector<int>& counts);
+    void appendMultiTermMarkers(const QVector<SearchHit>& hits);
+    void finishMultiTermSearch();
+    TextMatcher::Options searchOptions() const;
+    void onSearchResults(quint64 generation, const QVector<SearchHit>& hits);
+    void onSearchFinished(quint64 generation, qint64 elapsedNs);
+    void updateSearchSchedule();
+    void scheduleTextPrefetch();
+    bool searchResultAt(int idx, int* page, QRectF* rect) const;
+    int currentSearchIndex() const;
+    void stepSearchResult(int delta);
+    void selectSearchResult(int idx);
+    void setupSearchResultsPanel();
+    void syncSearchResultsSelection();
+
+    void exportText();
+
+    // Folder search
+    void searchInFolder();
+    void setupFolderSearchPanel();
+    void onFolderFileSearched(quint64 generation, const FolderFileResult& result);
+    void updateFolderSearchStatus();
+    void openFolderSearchHit(QTreeWidgetItem* item);
+    bool selectPendingFolderHit(const QVector<SearchHit>& hits, int firstIndex);
+
+    // Document lifetime
+    QPdfDocument* createDocument();
+    void connectDocument(QPdfDocument* doc);
+    void onDocumentLoaded(quint64 generation, const QString& path, QPdfDocument* doc, FileReadDevice* device);
+    void setActiveDocument(QPdfDocument* doc, FileReadDevice* device,
+                           std::unique_ptr<PageTextCache> textCache = nullptr);
+    std::unique_ptr<WarmDocument> detachCurrentDocument();
+    void activateWarmDocument(std::unique_ptr<WarmDocument> warm);
+    void restoreViewport(QPdfView::ZoomMode zoomMode, qreal zoomFactor, int horizontalScroll, int verticalScroll);
 
     // Page/document updates
+    void onDocumentReady();
+    void onDocumentLoadFailed(const QString& reason);
+    void openRemotePdf(const QUrl& url);
+    void onRemoteDownloadFinished();
+    QString localDocumentPath() const;
+    /// Opens the document pool on the local file; false if there is none yet
+    bool ensureDocumentPool();
+    void requestTextLayer();
+    void requestFingerprints();
+
+    // Reload on change
+    void watchFile(const QString& path);
+    void onWatchedFileChanged();
+    void reloadChangedFile();
+    void applyReloadCarryOver();
     void updatePageCountLabel();
     void updateThumbnails();
+    void renderThumbnailBatch();
     void updateCurrentPageHighlight();
     void updatePageMetrics();
     bool computePageOffsets(QVector<qreal>& offsets, qreal& totalHeight) const;
@@ -128,30 +309,122 @@ private:
 
     // Toolbar
     void adjustToolBarStyle();
+    void applyDeferredStyling();
+
+    // Performance HUD and memory report
+    void updatePerfMemory();
+    void showMemoryReport();
 
     // Document and view
     QPdfDocument* m_doc {nullptr};
     SelectablePdfView* m_view {nullptr};
     QString m_currentFilePath;
     QString m_originalFilePath;
+    FileReadDevice* m_fileDevice {nullptr};
+    QNetworkAccessManager* m_network {nullptr};   ///< Created on the first URL
+    QPointer<HttpRangeReply> m_remoteReply;       ///< Download of a remote active document
+    QString m_loadingFilePath;
+    DocumentLoader* m_documentLoader {nullptr};   ///< Parses local files off the GUI thread
+    quint64 m_loadGeneration {0};           ///< Request of m_loadingFilePath
+    qint64 m_currentFileSize {0};
+    QDateTime m_currentFileModified;
+    qint64 m_loadStartNs {0};               ///< Trace::now() when loading started
+    RecentDocuments m_recentDocuments;
+    SessionStore m_sessionStore;
+    bool m_hasCachedMetadata {false};
+    std::optional<SessionState> m_pendingSession;
+
+    // Reload on change: the open file is watched and reloaded once it has
+    // settled; caches of pages with an unchanged fingerprint are kept
+    struct ReloadCarryOver {
+        QString filePath;
+        QVector<QByteArray> fingerprints;   ///< Of the previous version
+        QVector<FoldedText> text;
+        QVector<bool> textCached;
+        QVector<QIcon> thumbnails;          ///< Null for pages not rendered
+    };
+    QFileSystemWatcher* m_fileWatcher {nullptr};
+    QTimer* m_reloadTimer {nullptr};
+    QString m_watchedFilePath;
+    qint64 m_reloadProbeSize {-1};          ///< File size when the debounce started
+    bool m_autoReload {false};              ///< Current load was started by a change
+    bool m_reloadFailed {false};            ///< Last reload failed; retry on the next change
+    PageFingerprinter* m_fingerprinter {nullptr};
+    QVector<QByteArray> m_pageFingerprints; ///< Of the active document, empty until computed
+    std::optional<ReloadCarryOver> m_reloadCarryOver;
+    QSet<int> m_reusedThumbnails;           ///< Pages whose thumbnail came from the previous version
 
     // Search components
     QLineEdit* m_searchEdit {nullptr};
-    QPdfSearchModel* m_searchModel {nullptr};
+    SearchEngine* m_searchEngine {nullptr};   ///< Owns the active document's text cache
+    TextLayerLoader* m_textLayerLoader {nullptr};
+    SearchResultsModel* m_resultsModel {nullptr};
+    QDockWidget* m_resultsDock {nullptr};
+    QListView* m_resultsList {nullptr};
     QLabel* m_searchStatus {nullptr};
     QAction* m_actFindPrev {nullptr};
     QAction* m_actFindNext {nullptr};
     QTimer* m_searchDebounce {nullptr};
+    QAction* m_actWholeWord {nullptr};
+    QAction* m_actRegex {nullptr};
+    QString m_searchError;                  ///< Invalid regular expression message
+    bool m_searchInProgress {false};
+    bool m_multiTermInProgress {false};     ///< The engine's current search is a multi-term one
+    QStringList m_multiTermTerms;           ///< Marker labels, by term index
+    int m_multiTermMatches {0};
+    int m_restoreSearchIndex {-1};          ///< Current hit to restore once found (warm switch)
+    SearchScheduler m_searchScheduler;      ///< Debounce from measured search cost
+    QElapsedTimer m_searchClock;            ///< Started with each search-box search
+    int m_searchCachedPages {0};            ///< Pages with cached text when the search started
+
+    // Folder search
+    FolderSearch* m_folderSearch {nullptr};
+    QDockWidget* m_folderDock {nullptr};
+    QTreeWidget* m_folderTree {nullptr};
+    QLabel* m_folderStatus {nullptr};
+    QString m_folderQuery;
+    TextMatcher::Options m_folderOptions;
+    int m_folderFileCount {-1};             ///< Files to search, -1 while listing
+    int m_folderFilesDone {0};
+    int m_folderHitCount {0};
+    bool m_folderSearchRunning {false};
+    /// Hit to select once the opened file has been searched
+    struct PendingFolderHit {
+        QString filePath;
+        int page {-1};
+        int start {-1};
+    } m_pendingFolderHit;
 
     // Toolbar and actions
     QToolBar* m_toolbar {nullptr};
     QAction* m_openOriginalAct {nullptr};
     QAction* m_toggleThumbnails {nullptr};
     QLabel* m_pageCountLabel {nullptr};
+    QPdfPageSelector* m_pageSelector {nullptr};
+    QAction* m_prevPageAct {nullptr};
+    bool m_deferredUiReady {false};
+    struct DeferredIcon {
+        QPointer<QAction> action;
+        const char* path;
+        QStyle::StandardPixmap fallback;
+    };
+    QVector<DeferredIcon> m_deferredIcons;   ///< Toolbar icons loaded by applyDeferredStyling()
+
+    // Save As (background copy)
+    FileCopier* m_saveCopier {nullptr};
+    QString m_saveDestination;
+
+    // Export Text (background extraction)
+    TextExporter* m_textExporter {nullptr};
+    QString m_exportDestination;
 
     // Thumbnails
     QListWidget* m_thumbnailList {nullptr};
     QDockWidget* m_thumbnailDock {nullptr};
+    QTimer* m_thumbnailTimer {nullptr};
+    int m_nextThumbnail {0};
+    DocumentPool* m_documentPool {nullptr};  ///< Instances of the current file for all page work
+    QSet<int> m_thumbnailsInFlight;           ///< Pages queued in m_documentPool
 
     // Search minimap
     SearchMinimapPanel* m_minimapPanel {nullptr};
@@ -0,0 +1,125 @@
+/**
+ * @file MemoryReport.cpp
+ * @brief Implementation of the memory report.
+ */
+
+#include "MemoryReport.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QTextStream>
+
+#if defined(Q_OS_WIN)
+#  include <windows.h>
+#  include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#  include <unistd.h>
+#endif
+
+namespace {
+QString formatBytes(qint64 bytes)
+{
+    if (bytes < 0)
+        return QStringLiteral("n/a");
+    if (bytes < 1024 * 1024)
+        return QString::number(double(bytes) / 1024.0, 'f', 1) + QStringLiteral(" KB");
+    return QString::number(double(bytes) / (1024.0 * 1024.0), 'f', 1) + QStringLiteral(" MB");
+}
+}
+
+void MemoryReport::add(const QString& name, qint64 bytes, qint64 items, const QString& unit,
+                       const QString& note)
+{
+    entries.append({name, bytes, items, unit, note});
+}
+
+qint64 MemoryReport::totalBytes() const
+{
+    qint64 total = 0;
+    for (const Entry& e : entries)
+        total += e.bytes;
+    return total;
+}
+
+QString MemoryReport::format() const
+{
+    QString out;
+    QTextStream ts(&out);
+    ts << "Memory report (estimated)\n";
+    for (const Entry& e : entries) {
+        ts << qSetFieldWidth(22) << Qt::left << e.name
+           << qSetFieldWidth(11) << Qt::right << formatBytes(e.bytes)
+           << qSetFieldWidth(0) << "  " << e.items << ' ' << e.unit;
+        if (!e.note.isEmpty())
+            ts << " (" << e.note << ')';
+        ts << '\n';
+    }
+    ts << qSetFieldWidth(22) << Qt::left << "Total"
+       << qSetFieldWidth(11) << Qt::right << formatBytes(totalBytes()) << qSetFieldWidth(0) << '\n';
+    ts << qSetFieldWidth(22) << Qt::left << "Process resident"
+       << qSetFieldWidth(11) << Qt::right << formatBytes(residentBytes) << qSetFieldWidth(0) << '\n';
+    return out;
+}
+
+QJsonObject MemoryReport::toJson() const
+{
+    QJsonArray list;
+    for (const Entry& e : entries) {
+        QJsonObject o{{QStringLiteral("name"), e.name},
+                      {QStringLiteral("bytes"), e.bytes},
+                      {QStringLiteral("items"), e.items},
+                      {QStringLiteral("unit"), e.unit}};
+        if (!e.note.isEmpty())
+            o.insert(QStringLiteral("note"), e.note);
+        list.append(o);
+    }
+    return QJsonObject{{QStringLiteral("residentBytes"), residentBytes},
+                       {QStringLiteral("totalBytes"), totalBytes()},
+                       {QStringLiteral("entries"), list}};
+}
+
+qint64 MemoryReport::currentResidentBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.WorkingSetSize);
+    return -1;
+#elif defined(Q_OS_LINUX)
+    // Second field of statm: resident pages
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * qint64(sysconf(_SC_PAGESIZE));
+#else
+    return -1;
+#endif
+}
+
+qint64 MemoryReport::peakResidentBytes()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.PeakWorkingSetSize);
+    return -1;
+#elif defined(Q_OS_LINUX)
+    // "VmHWM:   123456 kB" in status: resident high-water mark
+    QFile status(QStringLiteral("/proc/self/status"));
+    if (!status.open(QIODevice::ReadOnly))
+        return -1;
+    while (!status.atEnd()) {
+        const QByteArray line = status.readLine();
+        if (line.startsWith("VmHWM:")) {
+            const QList<QByteArray> fields = line.mid(6).simplified().split(' ');
+            return fields.value(0).toLongLong() * 1024;
+        }
+    }
+    return -1;
+#else
+    return -1;
+#endif
+}
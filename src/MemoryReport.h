@@ -0,0 +1,67 @@
+/**
+ * @file MemoryReport.h
+ * @brief Breakdown of the viewer's memory use by owning subsystem.
+ *
+ * Resident memory alone does not tell which structure grows on large
+ * documents. MainWindow::memoryReport() fills one entry per owner
+ * (document, rendered pages, thumbnails, document pool, selections, minimap markers,
+ * search results, text caches, warm documents) with estimated bytes and
+ * item counts; the report is shown from the "Memory Report" action and
+ * printed by --memory-report.
+ *
+ * Byte counts are estimates of the payload each structure holds (pixels,
+ * points, characters); allocator overhead and pdfium's internal heap are
+ * not included, so the sum is usually below the process resident size.
+ *
+ * Usage:
+ * @code
+ *   MemoryReport report = window.memoryReport();
+ *   std::puts(qPrintable(report.format()));
+ * @endcode
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+/**
+ * @struct MemoryReport
+ * @brief Per-subsystem byte and item counts plus process resident size.
+ */
+struct MemoryReport {
+    struct Entry {
+        QString name;       ///< Owner, e.g. "Thumbnails"
+        qint64 bytes {0};   ///< Estimated bytes
+        qint64 items {0};   ///< Number of items held
+        QString unit;       ///< What an item is, e.g. "pages"
+        QString note;       ///< Optional remark (e.g. "file mapping")
+    };
+
+    QVector<Entry> entries;
+    qint64 residentBytes {-1};   ///< Process resident size, -1 if unknown
+
+    /// Adds an entry.
+    void add(const QString& name, qint64 bytes, qint64 items, const QString& unit,
+             const QString& note = QString());
+
+    /// Sum of all entries.
+    qint64 totalBytes() const;
+
+    /// Human readable table.
+    QString format() const;
+
+    /// JSON object: { "residentBytes": n, "totalBytes": n, "entries": [...] }
+    QJsonObject toJson() const;
+
+    /**
+     * @brief Returns the process resident set size in bytes, or -1.
+     */
+    static qint64 currentResidentBytes();
+
+    /**
+     * @brief Returns the highest resident set size of the process so far in bytes, or -1.
+     */
+    static qint64 peakResidentBytes();
+};
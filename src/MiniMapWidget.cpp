@@ -26,7 +26,6 @@ MiniMapWidget::MiniMapWidget(QWidget* parent)
     setMouseTracking(true);
     setAttribute(Qt::WA_TranslucentBackground, true);
     setAttribute(Qt::WA_NoSystemBackground, true);
-    setStyleSheet(QStringLiteral("background: transparent;"));
     setAutoFillBackground(false);
     setMinimumWidth(kMiniMapMinWidthPx);
     setMaximumWidth(kMiniMapMaxWidthPx);
@@ -58,6 +57,22 @@ void MiniMapWidget::setMarkers(const QVector<MiniMapMarker>& markers)
     update();
 }
 
+void MiniMapWidget::appendMarkers(const QVector<MiniMapMarker>& markers)
+{
+    if (markers.isEmpty())
+        return;
+    auto byPos = [](const MiniMapMarker& a, const MiniMapMarker& b){
+        return a.normalizedPos < b.normalizedPos;
+    };
+    const qsizetype existing = m_markers.size();
+    m_markers += markers;
+    const auto middle = m_markers.begin() + existing;
+    std::stable_sort(middle, m_markers.end(), byPos);
+    if (existing > 0 && byPos(*middle, *(middle - 1)))
+        std::inplace_merge(m_markers.begin(), middle, m_markers.end(), byPos);
+    update();
+}
+
 void MiniMapWidget::setViewportRange(qreal startNormalized, qreal endNormalized)
 {
     if (startNormalized < 0.0 || endNormalized < 0.0 || endNormalized <= startNormalized) {
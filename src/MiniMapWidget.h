@@ -72,6 +72,20 @@ public:
      */
     void setMarkers(const QVector<MiniMapMarker>& markers);
 
+    /**
+     * @brief Adds markers to the ones shown.
+     * @param markers Markers to merge in, in any order
+     *
+     * Costs O(n) for n new markers when they all lie below the existing
+     * ones (results arriving in page order), and a linear merge otherwise.
+     */
+    void appendMarkers(const QVector<MiniMapMarker>& markers);
+
+    /**
+     * @brief Returns the markers currently shown.
+     */
+    const QVector<MiniMapMarker>& markers() const { return m_markers; }
+
     /**
      * @brief Sets the currently visible viewport range.
      * @param startNormalized Start position (0.0 to 1.0)
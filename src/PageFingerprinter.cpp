@@ -0,0 +1,101 @@
+/**
+ * @file PageFingerprinter.cpp
+ * @brief Implementation of the page fingerprinter.
+ */
+
+#include "PageFingerprinter.h"
+#include "PageRenderer.h"
+#include "Trace.h"
+
+#include <QCryptographicHash>
+#include <QImage>
+#include <QPdfDocument>
+#include <QPdfSelection>
+#include <QPolygonF>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <vector>
+
+namespace {
+constexpr int kWindowPages = 32;
+constexpr int kRenderBoxPx = 64;            ///< Rendering hashed per page
+
+void addDouble(QCryptographicHash& hash, double value)
+{
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(&value), sizeof(value)));
+}
+}
+
+PageFingerprinter::PageFingerprinter(QObject* parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+PageFingerprinter::~PageFingerprinter()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+QByteArray PageFingerprinter::pageFingerprint(QPdfDocument& doc, int page)
+{
+    const QPdfSelection text = doc.getAllText(page);
+    const QString chars = text.text();
+    if (chars.trimmed().isEmpty())
+        return {};
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    const QSizeF size = doc.pagePointSize(page);
+    addDouble(hash, size.width());
+    addDouble(hash, size.height());
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(chars.utf16()),
+                                chars.size() * qsizetype(sizeof(char16_t))));
+    // Line outlines catch moved text with the same characters
+    for (const QPolygonF& polygon : text.bounds()) {
+        for (const QPointF& p : polygon) {
+            addDouble(hash, p.x());
+            addDouble(hash, p.y());
+        }
+    }
+    // Graphics and images that the text does not show
+    const QImage image = PageRenderer::renderToFit(doc, page, QSize(kRenderBoxPx, kRenderBoxPx))
+                             .convertToFormat(QImage::Format_Grayscale8);
+    for (int y = 0; y < image.height(); ++y)
+        hash.addData(QByteArrayView(reinterpret_cast<const char*>(image.constScanLine(y)), image.width()));
+    return hash.result();
+}
+
+QVector<QByteArray> PageFingerprinter::fingerprints(int pageCount, const DocumentPool::PageRunner& forPages)
+{
+    TRACE_SCOPE("PageFingerprinter::fingerprints");
+    std::vector<QByteArray> out(pageCount);
+    // In windows, so other low-priority jobs (thumbnails) are not queued behind the whole document
+    for (int first = 0; first < pageCount; first += kWindowPages) {
+        const bool done = forPages(first, qMin(kWindowPages, pageCount - first), [&out](int page, QPdfDocument& doc){
+            out[page] = pageFingerprint(doc, page);
+        });
+        if (!done)
+            return {};
+    }
+    return QVector<QByteArray>(out.begin(), out.end());
+}
+
+void PageFingerprinter::cancel()
+{
+    ++m_generation;
+}
+
+void PageFingerprinter::request(const QString& pdfPath, DocumentPool* pool, int pageCount)
+{
+    const quint64 generation = ++m_generation;
+    if (!pool || pool->filePath() != pdfPath || pageCount <= 0)
+        return;
+    const quint64 session = pool->session();
+    QtConcurrent::run(&m_pool, [this, pdfPath, pool, session, pageCount, generation]{
+        auto cancelled = [this, generation]{ return m_generation.load() != generation; };
+        const QVector<QByteArray> pages =
+            fingerprints(pageCount, pool->pageRunner(session, DocumentPool::Priority::Low, cancelled));
+        if (!pages.isEmpty() && !cancelled())
+            emit ready(pdfPath, pages);
+    });
+}
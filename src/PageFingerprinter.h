@@ -0,0 +1,80 @@
+/**
+ * @file PageFingerprinter.h
+ * @brief Per-page content fingerprints for reusing caches across reloads.
+ *
+ * When a document is regenerated while open, most of its pages usually
+ * come out the same. A page fingerprint is a SHA-1 of the page size, its
+ * text, the outline of its text lines and a small grayscale rendering, so
+ * a page whose text, layout or graphics changed gets a new fingerprint,
+ * while renumbered objects or a rewritten cross-reference table do not
+ * matter. MainWindow compares the fingerprints of the old and the reloaded
+ * document and keeps thumbnails and search text of the pages that match,
+ * even if pages were inserted before them.
+ *
+ * Pages without text (scans, full-page images) get an empty fingerprint
+ * and are never carried over: the small rendering cannot tell a rescanned
+ * page from the old one.
+ *
+ * Pages are fingerprinted as low-priority DocumentPool jobs, so the
+ * viewer's document is not touched, no extra instance of the file is
+ * parsed and thumbnails and searches go first.
+ *
+ * Usage:
+ * @code
+ *   connect(fingerprinter, &PageFingerprinter::ready, this,
+ *           [](const QString& path, const QVector<QByteArray>& pages){ ... });
+ *   fingerprinter->request(filePath, pool, pageCount);   // pool has filePath open
+ * @endcode
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+
+#include "DocumentPool.h"
+
+class QPdfDocument;
+
+/**
+ * @class PageFingerprinter
+ * @brief Computes the page fingerprints of a document on a worker thread.
+ */
+class PageFingerprinter : public QObject {
+    Q_OBJECT
+public:
+    explicit PageFingerprinter(QObject* parent = nullptr);
+    ~PageFingerprinter() override;
+
+    /// Fingerprint of one page of @p doc; empty if the page has no text
+    static QByteArray pageFingerprint(QPdfDocument& doc, int page);
+
+    /**
+     * @brief Fingerprints @p pageCount pages through @p forPages.
+     * @return One fingerprint per page; empty if @p forPages was cancelled
+     */
+    static QVector<QByteArray> fingerprints(int pageCount, const DocumentPool::PageRunner& forPages);
+
+    /**
+     * @brief Starts fingerprinting @p pdfPath, cancelling the previous request.
+     *
+     * Runs on @p pool, which must have @p pdfPath open; nothing happens
+     * otherwise.
+     */
+    void request(const QString& pdfPath, DocumentPool* pool, int pageCount);
+
+    /// Cancels the running request; ready() is not emitted for it.
+    void cancel();
+
+signals:
+    /// One fingerprint per page of @p pdfPath.
+    void ready(const QString& pdfPath, const QVector<QByteArray>& fingerprints);
+
+private:
+    QThreadPool m_pool;                     ///< One thread, waiting for the pool's jobs
+    std::atomic<quint64> m_generation {0};
+};
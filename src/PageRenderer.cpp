@@ -0,0 +1,50 @@
+/**
+ * @file PageRenderer.cpp
+ * @brief Implementation of the shared page rendering helpers.
+ */
+
+#include "PageRenderer.h"
+#include "Trace.h"
+
+#include <QPdfDocument>
+#include <cmath>
+
+QSize PageRenderer::fitSize(const QSizeF& pagePoints, const QSize& box)
+{
+    if (pagePoints.isEmpty() || box.isEmpty())
+        return {};
+    const QSizeF scaled = pagePoints.scaled(QSizeF(box), Qt::KeepAspectRatio);
+    return QSize(qMax(1, qRound(scaled.width())), qMax(1, qRound(scaled.height())));
+}
+
+QSize PageRenderer::sizeAtDpi(const QSizeF& pagePoints, qreal dpi)
+{
+    if (pagePoints.isEmpty() || dpi <= 0)
+        return {};
+    const qreal scale = dpi / 72.0;
+    return QSize(qMax(1, int(std::ceil(pagePoints.width() * scale))),
+                 qMax(1, int(std::ceil(pagePoints.height() * scale))));
+}
+
+QImage PageRenderer::renderToFit(QPdfDocument& doc, int page, const QSize& box)
+{
+    if (page < 0 || page >= doc.pageCount())
+        return {};
+    return render(doc, page, fitSize(doc.pagePointSize(page), box));
+}
+
+QImage PageRenderer::renderAtDpi(QPdfDocument& doc, int page, qreal dpi)
+{
+    if (page < 0 || page >= doc.pageCount())
+        return {};
+    return render(doc, page, sizeAtDpi(doc.pagePointSize(page), dpi));
+}
+
+QImage PageRenderer::render(QPdfDocument& doc, int page, const QSize& size)
+{
+    if (size.isEmpty())
+        return {};
+    TRACE_SCOPE("PageRenderer::render");
+    // Default options, like QPdfView; QtPdf fills the background white
+    return doc.render(page, size);
+}
@@ -0,0 +1,56 @@
+/**
+ * @file PageRenderer.h
+ * @brief Page rasterization shared by thumbnails, printing and batch rendering.
+ *
+ * QPdfDocument::render() scales the page to exactly the size it is given,
+ * so callers have to work out a size with the page's aspect ratio first.
+ * PageRenderer does that in one place: a page is rendered either to fit a
+ * box (thumbnails, printer pages) or at a resolution in dots per inch
+ * (--render), with the same render options as the view.
+ *
+ * The functions only touch the QPdfDocument they are given, so they can be
+ * used from worker threads that own their instance (DocumentPool,
+ * BatchRenderer).
+ *
+ * Usage:
+ * @code
+ *   QImage thumb = PageRenderer::renderToFit(doc, page, QSize(440, 440));
+ *   QImage print = PageRenderer::renderAtDpi(doc, page, 300);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QImage>
+#include <QSize>
+#include <QSizeF>
+
+class QPdfDocument;
+
+/**
+ * @class PageRenderer
+ * @brief Aspect-correct page rendering helpers.
+ */
+class PageRenderer {
+public:
+    /// Largest size with the aspect ratio of @p pagePoints that fits in @p box
+    static QSize fitSize(const QSizeF& pagePoints, const QSize& box);
+
+    /// Pixel size of a page of @p pagePoints at @p dpi (72 points per inch)
+    static QSize sizeAtDpi(const QSizeF& pagePoints, qreal dpi);
+
+    /**
+     * @brief Renders @p page scaled to fit @p box.
+     * @return Null image if the page does not exist or @p box is empty
+     */
+    static QImage renderToFit(QPdfDocument& doc, int page, const QSize& box);
+
+    /**
+     * @brief Renders @p page at @p dpi.
+     * @return Null image if the page does not exist or @p dpi is not positive
+     */
+    static QImage renderAtDpi(QPdfDocument& doc, int page, qreal dpi);
+
+    /// Renders @p page at exactly @p size (the other functions end here)
+    static QImage render(QPdfDocument& doc, int page, const QSize& size);
+};
@@ -0,0 +1,144 @@
+/**
+ * @file PageTextCache.cpp
+ * @brief Implementation of the page text cache.
+ */
+
+#include "PageTextCache.h"
+
+#include <QMutexLocker>
+#include <QPdfDocument>
+
+void PageTextCache::attachLocked(QPdfDocument* doc)
+{
+    const int pageCount = doc ? doc->pageCount() : 0;
+    if (m_doc == doc && m_pages.size() == pageCount)
+        return;
+    m_doc = doc;
+    ++m_epoch;
+    m_layer.reset();
+    m_pages = QVector<FoldedText>(pageCount);
+    m_cached.fill(false, pageCount);
+    m_cachedCount = 0;
+    m_bytes = 0;
+}
+
+FoldedText PageTextCache::page(QPdfDocument* doc, int page)
+{
+    attach(doc);
+    return extract(page, doc);
+}
+
+FoldedText PageTextCache::page(int page, QPdfDocument& source)
+{
+    return extract(page, &source);
+}
+
+bool PageTextCache::cachedPage(QPdfDocument* doc, int page, FoldedText* text)
+{
+    {
+        const QMutexLocker locker(&m_mutex);
+        if (!doc || m_doc != doc || page < 0 || page >= m_pages.size())
+            return false;
+        if (!m_cached.at(page) && !m_layer)
+            return false;
+    }
+    *text = extract(page, nullptr);
+    return true;
+}
+
+void PageTextCache::attach(QPdfDocument* doc)
+{
+    const QMutexLocker locker(&m_mutex);
+    attachLocked(doc);
+}
+
+FoldedText PageTextCache::extract(int page, QPdfDocument* source)
+{
+    TextLayerPtr layer;
+    quint64 epoch = 0;
+    {
+        const QMutexLocker locker(&m_mutex);
+        if (page < 0 || page >= m_pages.size())
+            return {};
+        if (m_cached.at(page))
+            return m_pages.at(page);
+        layer = m_layer;
+        epoch = m_epoch;
+    }
+
+    // Another thread may fold the same page meanwhile; the first one stored wins
+    if (!layer && !source)
+        return {};
+    const QString text = layer ? layer->pageText(page).toString() : source->getAllText(page).text();
+    const FoldedText folded = FoldedText::fold(text);
+
+    const QMutexLocker locker(&m_mutex);
+    if (m_epoch != epoch || page >= m_pages.size())
+        return folded;
+    if (!m_cached.at(page)) {
+        m_pages[page] = folded;
+        m_cached[page] = true;
+        m_bytes += folded.byteSize();
+        ++m_cachedCount;
+    }
+    return m_pages.at(page);
+}
+
+void PageTextCache::setTextLayer(QPdfDocument* doc, TextLayerPtr layer)
+{
+    const QMutexLocker locker(&m_mutex);
+    attachLocked(doc);
+    if (layer && layer->pageCount() != m_pages.size())
+        return;
+    m_layer = std::move(layer);
+}
+
+TextLayerPtr PageTextCache::textLayer() const
+{
+    const QMutexLocker locker(&m_mutex);
+    return m_layer;
+}
+
+QVector<FoldedText> PageTextCache::snapshot(QVector<bool>* cached) const
+{
+    const QMutexLocker locker(&m_mutex);
+    if (cached)
+        *cached = m_cached;
+    return m_pages;
+}
+
+void PageTextCache::insert(QPdfDocument* doc, int page, const FoldedText& text)
+{
+    const QMutexLocker locker(&m_mutex);
+    attachLocked(doc);
+    if (page < 0 || page >= m_pages.size() || m_cached.at(page))
+        return;
+    m_pages[page] = text;
+    m_cached[page] = true;
+    m_bytes += text.byteSize();
+    ++m_cachedCount;
+}
+
+void PageTextCache::clear()
+{
+    const QMutexLocker locker(&m_mutex);
+    m_doc = nullptr;
+    ++m_epoch;
+    m_layer.reset();
+    m_pages.clear();
+    m_cached.clear();
+    m_cachedCount = 0;
+    m_bytes = 0;
+}
+
+int PageTextCache::cachedPageCount() const
+{
+    const QMutexLocker locker(&m_mutex);
+    return m_cachedCount;
+}
+
+qint64 PageTextCache::byteSize() const
+{
+    const QMutexLocker locker(&m_mutex);
+    return m_bytes;
+}
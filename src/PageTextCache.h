@@ -0,0 +1,126 @@
+/**
+ * @file PageTextCache.h
+ * @brief Per-document cache of folded page text for searching.
+ *
+ * Extracting and folding page text is the expensive part of a search;
+ * matching the folded text is cheap. PageTextCache extracts each page once,
+ * folds it and keeps the result until the document changes. The cache
+ * travels with a document when it is kept warm in RecentDocuments.
+ *
+ * The cache is thread-safe: SearchEngine workers fill it while the results
+ * panel reads snippets from it on the GUI thread. The cache is keyed by the
+ * viewer's document, which belongs to the GUI thread; workers never touch
+ * it and extract from a document instance of their own (see DocumentPool)
+ * instead. Text extraction runs outside the cache lock; QtPdf serializes
+ * pdfium calls itself, so several workers extract one page at a time but
+ * fold in parallel. Once a TextLayer of the document is attached, text is
+ * read from the mapped layer instead of pdfium, so extraction runs in
+ * parallel too.
+ *
+ * Usage:
+ * @code
+ *   cache.attach(doc);                            // on the GUI thread
+ *   const FoldedText text = cache.page(3, workerDoc);
+ *   QVector<TextMatch> hits = matcher.findAll(text);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QMutex>
+#include <QPointer>
+#include <QVector>
+
+#include "TextLayer.h"
+#include "TextSearch.h"
+
+class QPdfDocument;
+
+/**
+ * @class PageTextCache
+ * @brief Lazily filled FoldedText for every page of one document.
+ */
+class PageTextCache {
+public:
+    PageTextCache() = default;
+    PageTextCache(const PageTextCache&) = delete;
+    PageTextCache& operator=(const PageTextCache&) = delete;
+
+    /**
+     * @brief Returns the folded text of one page; empty if out of range.
+     *
+     * Extracts and folds the page on first use. Switches the cache to
+     * @p doc if it held another document. Call on the thread of @p doc.
+     */
+    FoldedText page(QPdfDocument* doc, int page);
+
+    /**
+     * @brief Returns the folded text of one page of the attached document.
+     *
+     * Extracts from @p source, an instance of the same file owned by the
+     * calling thread, on first use. Empty if out of range.
+     */
+    FoldedText page(int page, QPdfDocument& source);
+
+    /**
+     * @brief Folded text of @p page of @p doc, if available without pdfium.
+     *
+     * True if the page is cached or a text layer is attached; never
+     * extracts, so it is safe to call while painting.
+     */
+    bool cachedPage(QPdfDocument* doc, int page, FoldedText* text);
+
+    /**
+     * @brief Switches the cache to @p doc if it held another document.
+     *
+     * Call on the thread of @p doc, before workers read pages of it.
+     */
+    void attach(QPdfDocument* doc);
+
+    /**
+     * @brief Reads page text of @p doc from @p layer from now on.
+     *
+     * Ignored if the layer's page count differs from @p doc. The layer is
+     * dropped when the cache switches to another document.
+     */
+    void setTextLayer(QPdfDocument* doc, TextLayerPtr layer);
+
+    /// Text layer in use, or null
+    TextLayerPtr textLayer() const;
+
+    /**
+     * @brief Returns the text of every page, empty for pages not extracted.
+     * @param cached Receives which pages have been extracted
+     */
+    QVector<FoldedText> snapshot(QVector<bool>* cached) const;
+
+    /**
+     * @brief Stores text of @p page of @p doc obtained elsewhere.
+     *
+     * Used to carry pages over from a previous version of the document.
+     * Switches the cache to @p doc if it held another document.
+     */
+    void insert(QPdfDocument* doc, int page, const FoldedText& text);
+
+    /// Drops all cached text.
+    void clear();
+
+    /// Number of pages extracted so far
+    int cachedPageCount() const;
+
+    /// Estimated bytes held
+    qint64 byteSize() const;
+
+private:
+    void attachLocked(QPdfDocument* doc);
+    FoldedText extract(int page, QPdfDocument* source);
+
+    mutable QMutex m_mutex;
+    QPointer<QPdfDocument> m_doc;
+    QVector<FoldedText> m_pages;
+    QVector<bool> m_cached;
+    TextLayerPtr m_layer;
+    quint64 m_epoch {0};                ///< Bumped whenever the pages are dropped
+    int m_cachedCount {0};
+    qint64 m_bytes {0};
+};
@@ -0,0 +1,210 @@
+/**
+ * @file PerfStats.cpp
+ * @brief Implementation of the performance counters.
+ */
+
+#include "PerfStats.h"
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <array>
+
+namespace {
+constexpr int kSampleWindow = 120;
+
+/// Fixed-size ring of the most recent duration samples.
+struct SampleRing {
+    std::array<qint64, kSampleWindow> durationNs {};
+    std::array<qint64, kSampleWindow> timestampNs {};
+    int next {0};
+    int count {0};
+
+    void add(qint64 ns, qint64 now)
+    {
+        durationNs[size_t(next)] = ns;
+        timestampNs[size_t(next)] = now;
+        next = (next + 1) % kSampleWindow;
+        count = qMin(count + 1, kSampleWindow);
+    }
+
+    double averageMs() const
+    {
+        if (count == 0)
+            return 0.0;
+        qint64 sum = 0;
+        for (int i = 0; i < count; ++i)
+            sum += durationNs[size_t(i)];
+        return double(sum) / count / 1e6;
+    }
+
+    double maxMs() const
+    {
+        qint64 max = 0;
+        for (int i = 0; i < count; ++i)
+            max = qMax(max, durationNs[size_t(i)]);
+        return double(max) / 1e6;
+    }
+
+    int countSince(qint64 since) const
+    {
+        int n = 0;
+        for (int i = 0; i < count; ++i) {
+            if (timestampNs[size_t(i)] >= since)
+                ++n;
+        }
+        return n;
+    }
+};
+
+struct StatsState {
+    QMutex mutex;
+    QElapsedTimer clock;
+    SampleRing frames;
+    SampleRing renders;
+    quint64 renderHits {0};
+    quint64 renderMisses {0};
+    quint64 thumbnailHits {0};
+    quint64 thumbnailMisses {0};
+    qint64 thumbnailNs {0};
+    int searchPages {0};
+    qint64 searchNs {0};
+    int searchDebounceMs {0};
+    qint64 searchExpectedNs {0};
+    double searchColdNsPerPage {0.0};
+    double searchWarmNsPerPage {0.0};
+    bool searchPrefetch {false};
+    qint64 mappedBytes {0};
+    qint64 thumbnailBytes {0};
+
+    StatsState() { clock.start(); }
+};
+
+StatsState& state()
+{
+    static StatsState s;
+    return s;
+}
+}
+
+double PerfStats::Snapshot::renderHitRate() const
+{
+    const quint64 total = renderHits + renderMisses;
+    return total ? double(renderHits) / double(total) : 0.0;
+}
+
+double PerfStats::Snapshot::thumbnailHitRate() const
+{
+    const quint64 total = thumbnailHits + thumbnailMisses;
+    return total ? double(thumbnailHits) / double(total) : 0.0;
+}
+
+void PerfStats::recordFrame(qint64 ns)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.frames.add(ns, s.clock.nsecsElapsed());
+}
+
+void PerfStats::recordPageRender(qint64 ns)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.renders.add(ns, s.clock.nsecsElapsed());
+}
+
+void PerfStats::recordRenderCacheLookup(bool hit)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    if (hit)
+        ++s.renderHits;
+    else
+        ++s.renderMisses;
+}
+
+void PerfStats::recordThumbnailHits(int count)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.thumbnailHits += quint64(qMax(0, count));
+}
+
+void PerfStats::recordThumbnailRender(qint64 ns)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    ++s.thumbnailMisses;
+    s.thumbnailNs += ns;
+}
+
+void PerfStats::recordSearch(int pages, qint64 ns)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.searchPages = pages;
+    s.searchNs = ns;
+}
+
+void PerfStats::setSearchSchedule(int debounceMs, qint64 expectedNs, double coldNsPerPage,
+                                  double warmNsPerPage, bool prefetch)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.searchDebounceMs = debounceMs;
+    s.searchExpectedNs = expectedNs;
+    s.searchColdNsPerPage = coldNsPerPage;
+    s.searchWarmNsPerPage = warmNsPerPage;
+    s.searchPrefetch = prefetch;
+}
+
+void PerfStats::setDocumentMemory(qint64 mappedBytes, qint64 thumbnailBytes)
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.mappedBytes = mappedBytes;
+    s.thumbnailBytes = thumbnailBytes;
+}
+
+void PerfStats::reset()
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    s.frames = SampleRing();
+    s.renders = SampleRing();
+    s.renderHits = s.renderMisses = 0;
+    s.thumbnailHits = s.thumbnailMisses = 0;
+    s.thumbnailNs = 0;
+    s.searchPages = 0;
+    s.searchNs = 0;
+}
+
+PerfStats::Snapshot PerfStats::snapshot()
+{
+    StatsState& s = state();
+    QMutexLocker lock(&s.mutex);
+    Snapshot snap;
+    snap.frameSamples = s.frames.count;
+    snap.frameAvgMs = s.frames.averageMs();
+    snap.frameMaxMs = s.frames.maxMs();
+    snap.framesPerSecond = s.frames.countSince(s.clock.nsecsElapsed() - 1000000000LL);
+    snap.renderSamples = s.renders.count;
+    snap.renderAvgMs = s.renders.averageMs();
+    snap.renderMaxMs = s.renders.maxMs();
+    snap.renderHits = s.renderHits;
+    snap.renderMisses = s.renderMisses;
+    snap.thumbnailHits = s.thumbnailHits;
+    snap.thumbnailMisses = s.thumbnailMisses;
+    snap.thumbnailAvgMs = s.thumbnailMisses ? double(s.thumbnailNs) / double(s.thumbnailMisses) / 1e6 : 0.0;
+    snap.searchPages = s.searchPages;
+    snap.searchMs = double(s.searchNs) / 1e6;
+    snap.searchPagesPerSecond = s.searchNs > 0 ? s.searchPages / (double(s.searchNs) / 1e9) : 0.0;
+    snap.searchDebounceMs = s.searchDebounceMs;
+    snap.searchExpectedMs = double(s.searchExpectedNs) / 1e6;
+    snap.searchColdUsPerPage = s.searchColdNsPerPage / 1e3;
+    snap.searchWarmUsPerPage = s.searchWarmNsPerPage / 1e3;
+    snap.searchPrefetch = s.searchPrefetch;
+    snap.mappedBytes = s.mappedBytes;
+    snap.thumbnailBytes = s.thumbnailBytes;
+    return snap;
+}
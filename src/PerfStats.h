@@ -0,0 +1,102 @@
+/**
+ * @file PerfStats.h
+ * @brief Process-wide performance counters shown by the performance HUD.
+ *
+ * When a document feels slow, the HUD (see SelectablePdfView::setPerfHudVisible)
+ * shows whether the time goes into painting/layout, page rendering or text
+ * extraction. The counters are fed from the places that do that work:
+ * - SelectablePdfView: paint times, page render latency, render cache hits
+ * - MainWindow: thumbnail renders and reuse, search throughput and debounce,
+ *   document memory
+ *
+ * Recording takes a mutex and a few arithmetic operations; frame and render
+ * samples are only recorded while the HUD is visible.
+ *
+ * Usage:
+ * @code
+ *   QElapsedTimer timer;
+ *   timer.start();
+ *   ...scan pages...
+ *   PerfStats::recordSearch(pageCount, timer.nsecsElapsed());
+ *   PerfStats::Snapshot s = PerfStats::snapshot();
+ * @endcode
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * @class PerfStats
+ * @brief Thread-safe counters for frame, render, thumbnail and search timing.
+ */
+class PerfStats {
+public:
+    /**
+     * @brief Copy of all counters at one point in time.
+     */
+    struct Snapshot {
+        int frameSamples {0};
+        double frameAvgMs {0.0};
+        double frameMaxMs {0.0};
+        double framesPerSecond {0.0};   ///< Frames painted during the last second
+
+        int renderSamples {0};
+        double renderAvgMs {0.0};       ///< Visible page shown blank until rendered
+        double renderMaxMs {0.0};
+        quint64 renderHits {0};         ///< Page paints served from the render cache
+        quint64 renderMisses {0};       ///< Page paints still waiting for a render
+
+        quint64 thumbnailHits {0};      ///< Thumbnails reused from a warm document
+        quint64 thumbnailMisses {0};    ///< Thumbnails rendered
+        double thumbnailAvgMs {0.0};
+
+        int searchPages {0};            ///< Pages scanned by the last search
+        double searchMs {0.0};
+        double searchPagesPerSecond {0.0};
+        int searchDebounceMs {0};       ///< Debounce chosen for the next keystroke
+        double searchExpectedMs {0.0};  ///< Expected cost of the next search
+        double searchColdUsPerPage {0.0};
+        double searchWarmUsPerPage {0.0};
+        bool searchPrefetch {false};    ///< Text extracted while idle (small document)
+
+        qint64 mappedBytes {0};         ///< File size of the current document
+        qint64 thumbnailBytes {0};      ///< Rendered thumbnails of the current document
+
+        double renderHitRate() const;
+        double thumbnailHitRate() const;
+    };
+
+    /// Records the duration of one SelectablePdfView paint event.
+    static void recordFrame(qint64 ns);
+
+    /// Records the time a visible page waited for its rendered image.
+    static void recordPageRender(qint64 ns);
+
+    /// Records whether a painted page was already rendered.
+    static void recordRenderCacheLookup(bool hit);
+
+    /// Records thumbnails reused without rendering.
+    static void recordThumbnailHits(int count);
+
+    /// Records one rendered thumbnail.
+    static void recordThumbnailRender(qint64 ns);
+
+    /// Records a completed search over @p pages pages.
+    static void recordSearch(int pages, qint64 ns);
+
+    /**
+     * @brief Publishes the search scheduling decision (see SearchScheduler).
+     */
+    static void setSearchSchedule(int debounceMs, qint64 expectedNs, double coldNsPerPage,
+                                  double warmNsPerPage, bool prefetch);
+
+    /// Sets the memory attributed to the current document.
+    static void setDocumentMemory(qint64 mappedBytes, qint64 thumbnailBytes);
+
+    /// Clears all counters.
+    static void reset();
+
+    /// Returns a copy of the counters.
+    static Snapshot snapshot();
+};
@@ -0,0 +1,71 @@
+/**
+ * @file RecentDocuments.cpp
+ * @brief Implementation of the warm document LRU.
+ */
+
+#include "RecentDocuments.h"
+#include "FileReadDevice.h"
+
+#include <QPdfDocument>
+#include <QtGlobal>
+#include <algorithm>
+
+WarmDocument::~WarmDocument()
+{
+    // The document reads from the device; delete in order
+    delete document;
+    delete device;
+}
+
+qint64 WarmDocument::estimatedBytes() const
+{
+    return thumbnailBytes + (textCache ? textCache->byteSize() : 0)
+        + qint64(pageHeights.size()) * qint64(sizeof(qreal));
+}
+
+RecentDocuments::RecentDocuments(int maxEntries, qint64 budgetBytes)
+    : m_maxEntries(qMax(1, maxEntries))
+    , m_budgetBytes(budgetBytes)
+{
+}
+
+std::unique_ptr<WarmDocument> RecentDocuments::take(const QString& filePath)
+{
+    auto it = std::find_if(m_entries.begin(), m_entries.end(), [&](const auto& entry){
+        return entry->filePath == filePath;
+    });
+    if (it == m_entries.end())
+        return nullptr;
+    std::unique_ptr<WarmDocument> entry = std::move(*it);
+    m_entries.erase(it);
+    return entry;
+}
+
+void RecentDocuments::put(std::unique_ptr<WarmDocument> entry)
+{
+    if (!entry)
+        return;
+    // Replace a stale entry for the same file
+    take(entry->filePath);
+    m_entries.push_front(std::move(entry));
+    evict();
+}
+
+qint64 RecentDocuments::totalBytes() const
+{
+    qint64 total = 0;
+    for (const auto& entry : m_entries)
+        total += entry->estimatedBytes();
+    return total;
+}
+
+void RecentDocuments::evict()
+{
+    while (int(m_entries.size()) > m_maxEntries)
+        m_entries.pop_back();
+    qint64 total = totalBytes();
+    while (m_entries.size() > 1 && total > m_budgetBytes) {
+        total -= m_entries.back()->estimatedBytes();
+        m_entries.pop_back();
+    }
+}
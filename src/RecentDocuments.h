@@ -0,0 +1,140 @@
+/**
+ * @file RecentDocuments.h
+ * @brief Bounded LRU of recently opened documents kept warm in memory.
+ *
+ * Switching between a handful of PDFs (e.g. via the single-instance IPC)
+ * used to reload each document from scratch. RecentDocuments keeps the
+ * QPdfDocument of recently viewed files alive together with its page text
+ * cache, rendered thumbnails and viewport state, so switching back is a
+ * matter of reattaching them to the view.
+ *
+ * The cache is bounded both by entry count and by an estimated memory
+ * budget; least recently used entries are evicted first. The most recently
+ * stored entry is always kept.
+ *
+ * Usage:
+ * @code
+ *   RecentDocuments recent(6, 1024ll * 1024 * 1024);
+ *   recent.put(std::move(entry));                 // keep outgoing document warm
+ *   if (auto warm = recent.take(path))            // later: switch back
+ *       if (warm->matchesFile(QFileInfo(path))) ...
+ * @endcode
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QIcon>
+#include <QPdfView>
+#include <QString>
+#include <QVector>
+#include <deque>
+#include <memory>
+
+#include "PageTextCache.h"
+
+class QPdfDocument;
+class FileReadDevice;
+
+/**
+ * @struct WarmDocument
+ * @brief A loaded document plus the state needed to show it again instantly.
+ *
+ * Owns the document, its source device and its text cache; they are
+ * deleted with the entry.
+ */
+struct WarmDocument {
+    QString filePath;
+    qint64 fileSize {0};
+    QDateTime lastModified;
+
+    QPdfDocument* document {nullptr};
+    FileReadDevice* device {nullptr};
+
+    // Viewport state
+    QPdfView::ZoomMode zoomMode {QPdfView::ZoomMode::FitToWidth};
+    qreal zoomFactor {1.0};
+    int horizontalScroll {0};
+    int verticalScroll {0};
+    int searchResultIndex {-1};
+
+    // Caches
+    QVector<qreal> pageHeights;
+    QVector<QIcon> thumbnails;
+    int thumbnailsRendered {0};
+    qint64 thumbnailBytes {0};
+    std::unique_ptr<PageTextCache> textCache;
+
+    WarmDocument() = default;
+    ~WarmDocument();
+    WarmDocument(const WarmDocument&) = delete;
+    WarmDocument& operator=(const WarmDocument&) = delete;
+
+    /**
+     * @brief Returns true if the file on disk still matches this entry.
+     */
+    bool matchesFile(const QFileInfo& fi) const
+    {
+        return fi.size() == fileSize && fi.lastModified() == lastModified;
+    }
+
+    /**
+     * @brief Estimated memory held by this entry in bytes.
+     *
+     * Counts the rendered thumbnails and the cached page text; the file
+     * itself is read on demand and not held.
+     */
+    qint64 estimatedBytes() const;
+};
+
+/**
+ * @class RecentDocuments
+ * @brief LRU container of WarmDocument entries with a memory budget.
+ */
+class RecentDocuments {
+public:
+    /**
+     * @brief Constructs the cache.
+     * @param maxEntries Maximum number of warm documents
+     * @param budgetBytes Maximum total estimated memory of all entries
+     */
+    explicit RecentDocuments(int maxEntries = 6, qint64 budgetBytes = 1024ll * 1024 * 1024);
+
+    /**
+     * @brief Removes and returns the entry for @p filePath, or nullptr.
+     */
+    std::unique_ptr<WarmDocument> take(const QString& filePath);
+
+    /**
+     * @brief Stores @p entry as the most recently used one and evicts
+     *        older entries beyond the count or memory limit.
+     */
+    void put(std::unique_ptr<WarmDocument> entry);
+
+    /**
+     * @brief Drops all entries.
+     */
+    void clear() { m_entries.clear(); }
+
+    int count() const { return int(m_entries.size()); }
+    qint64 totalBytes() const;
+    qint64 budgetBytes() const { return m_budgetBytes; }
+
+    /**
+     * @brief Visits entries from most to least recently used.
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const
+    {
+        for (const auto& entry : m_entries)
+            fn(*entry);
+    }
+
+private:
+    void evict();
+
+    std::deque<std::unique_ptr<WarmDocument>> m_entries;  ///< Front = most recent
+    int m_maxEntries;
+    qint64 m_budgetBytes;
+};
@@ -0,0 +1,203 @@
+/**
+ * @file SearchEngine.cpp
+ * @brief Implementation of the search engine.
+ */
+
+#include "SearchEngine.h"
+#include "DocumentPool.h"
+#include "PerfStats.h"
+#include "Trace.h"
+
+#include <QElapsedTimer>
+#include <QPdfDocument>
+#include <QPdfSelection>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+// Pages per emitted batch: small enough for the first hits to show up
+// quickly, large enough to keep all cores busy between emits
+constexpr int kBatchPages = 16;
+}
+
+SearchEngine::SearchEngine(QObject* parent)
+    : QObject(parent)
+    , m_cache(std::make_unique<PageTextCache>())
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+SearchEngine::~SearchEngine()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void SearchEngine::setDocument(QPdfDocument* doc, DocumentPool* pool, std::unique_ptr<PageTextCache> cache)
+{
+    cancel();
+    m_pool.waitForDone();
+    m_doc = doc;
+    m_documents = pool;
+    m_cache = cache ? std::move(cache) : std::make_unique<PageTextCache>();
+}
+
+std::unique_ptr<PageTextCache> SearchEngine::takeTextCache()
+{
+    cancel();
+    m_pool.waitForDone();
+    std::unique_ptr<PageTextCache> cache = std::move(m_cache);
+    m_cache = std::make_unique<PageTextCache>();
+    return cache;
+}
+
+void SearchEngine::cancel()
+{
+    ++m_generation;
+}
+
+bool SearchEngine::isRunning() const
+{
+    return m_pool.activeThreadCount() > 0;
+}
+
+SearchEngine::Matchers SearchEngine::compile(const QStringList& terms, TextMatcher::Options options)
+{
+    m_errorString.clear();
+    auto matchers = std::make_shared<QVector<TextMatcher>>();
+    matchers->reserve(terms.size());
+    for (const QString& term : terms) {
+        TextMatcher matcher(term, options);
+        if (!matcher.isValid() && !matcher.errorString().isEmpty()) {
+            m_errorString = matcher.errorString();
+            return nullptr;
+        }
+        matchers->append(matcher);
+    }
+    return matchers;
+}
+
+bool SearchEngine::start(const QStringList& terms, TextMatcher::Options options)
+{
+    const quint64 generation = ++m_generation;
+    const Matchers matchers = compile(terms, options);
+    if (!matchers)
+        return false;
+    if (!m_doc || m_doc->status() != QPdfDocument::Status::Ready || matchers->isEmpty()
+        || !m_documents || m_documents->instanceCount() == 0) {
+        emit finished(generation, 0, 0);
+        return true;
+    }
+    // Attached here, on the document's thread; workers only read pages
+    m_cache->attach(m_doc);
+    const int pageCount = m_doc->pageCount();
+    const quint64 session = m_documents->session();
+    // The pool has one thread: a cancelled job returns at its next page and
+    // this one starts right after
+    QtConcurrent::run(&m_pool, [this, matchers, generation, session, pageCount]{
+        runBatches(matchers, generation, session, pageCount);
+    });
+    return true;
+}
+
+void SearchEngine::prefetch()
+{
+    if (!m_doc || m_doc->status() != QPdfDocument::Status::Ready
+        || !m_documents || m_documents->instanceCount() == 0)
+        return;
+    const quint64 generation = ++m_generation;
+    m_cache->attach(m_doc);
+    const int pageCount = m_doc->pageCount();
+    const quint64 session = m_documents->session();
+    QtConcurrent::run(&m_pool, [this, generation, session, pageCount]{
+        TRACE_SCOPE("SearchEngine::prefetch");
+        auto cancelled = [this, generation]{ return m_generation.load() != generation; };
+        for (int first = 0; first < pageCount; first += kBatchPages) {
+            const bool done = m_documents->runPages(session, first, qMin(kBatchPages, pageCount - first),
+                                                    DocumentPool::Priority::Low, cancelled,
+                                                    [this, &cancelled](int page, QPdfDocument& source){
+                if (!cancelled())
+                    m_cache->page(page, source);
+            });
+            if (!done)
+                return;
+        }
+    });
+}
+
+QVector<SearchHit> SearchEngine::searchPage(const Matchers& matchers, int page, quint64 generation,
+                                            QPdfDocument& source) const
+{
+    QVector<SearchHit> hits;
+    if (generation != 0 && m_generation.load() != generation)
+        return hits;
+    const FoldedText text = m_cache->page(page, source);
+    for (int term = 0; term < matchers->size(); ++term) {
+        for (const TextMatch& match : matchers->at(term).findAll(text)) {
+            const QPdfSelection sel = source.getSelectionAtIndex(page, match.start, match.length);
+            if (!sel.isValid())
+                continue;
+            hits.append({page, term, match.start, match.length, sel.boundingRectangle(), sel.bounds()});
+        }
+    }
+    // Several terms: keep hits in reading order on the page
+    if (matchers->size() > 1) {
+        std::stable_sort(hits.begin(), hits.end(), [](const SearchHit& a, const SearchHit& b){
+            return a.start < b.start;
+        });
+    }
+    return hits;
+}
+
+void SearchEngine::runBatches(const Matchers& matchers, quint64 generation, quint64 session, int pageCount)
+{
+    TRACE_SCOPE("SearchEngine::search");
+    QElapsedTimer timer;
+    timer.start();
+    auto cancelled = [this, generation]{ return m_generation.load() != generation; };
+    int hitCount = 0;
+    bool complete = true;
+    for (int first = 0; first < pageCount; first += kBatchPages) {
+        const int count = qMin(kBatchPages, pageCount - first);
+        std::vector<QVector<SearchHit>> perPage(count);
+        const bool done = m_documents->runPages(session, first, count, DocumentPool::Priority::Normal, cancelled,
+                                                [this, &matchers, &perPage, first, generation](int page, QPdfDocument& source){
+            perPage[page - first] = searchPage(matchers, page, generation, source);
+        });
+        if (cancelled())
+            return;
+        // The pool closed under the search: report what was found
+        if (!done) {
+            complete = false;
+            break;
+        }
+        QVector<SearchHit> hits;
+        for (const QVector<SearchHit>& pageHits : perPage)
+            hits += pageHits;
+        hitCount += int(hits.size());
+        emit resultsReady(generation, first, count, hits);
+    }
+    if (complete)
+        PerfStats::recordSearch(pageCount, timer.nsecsElapsed());
+    emit finished(generation, hitCount, timer.nsecsElapsed());
+}
+
+QVector<SearchHit> SearchEngine::run(const QStringList& terms, TextMatcher::Options options)
+{
+    TRACE_SCOPE("SearchEngine::run");
+    const Matchers matchers = compile(terms, options);
+    if (!matchers || !m_doc || m_doc->status() != QPdfDocument::Status::Ready)
+        return {};
+    QElapsedTimer timer;
+    timer.start();
+    m_cache->attach(m_doc);
+    const int pageCount = m_doc->pageCount();
+    // Generation 0: a blocking search is never cancelled
+    QVector<SearchHit> hits;
+    for (int page = 0; page < pageCount; ++page)
+        hits += searchPage(matchers, page, 0, *m_doc);
+    PerfStats::recordSearch(pageCount, timer.nsecsElapsed());
+    return hits;
+}
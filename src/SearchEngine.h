@@ -0,0 +1,158 @@
+/**
+ * @file SearchEngine.h
+ * @brief Asynchronous, cancellable full-text search over a document.
+ *
+ * SearchEngine is the single search path of the viewer: the search box,
+ * the results panel, the highlight overlay, the minimap and multi-term
+ * searches all consume its hits. A search runs on a worker thread and
+ * processes pages in small batches; each batch's hits are emitted in page
+ * order, so consumers can append them as they arrive.
+ *
+ * Starting a new search or switching documents cancels the running one
+ * immediately: every search gets a generation number, workers stop at the
+ * next page once the generation moved on, and results of stale generations
+ * are dropped by the receiver.
+ *
+ * The viewer's document belongs to the GUI thread, so workers never touch
+ * it: each page is searched as a DocumentPool job, with the pool's own
+ * instance of the file providing text and hit outlines. The search thread
+ * only queues a batch of pages and waits for it.
+ *
+ * Page text comes from the engine's PageTextCache, so only the first
+ * search of a document extracts text; later searches just match. prefetch()
+ * fills the cache ahead of the first search; it runs as a cancellable job
+ * like a search, so starting a search stops it at the next page.
+ *
+ * Usage:
+ * @code
+ *   connect(engine, &SearchEngine::resultsReady, this, &Viewer::appendHits);
+ *   engine->setDocument(doc, pool);             // pool->open(file of doc)
+ *   if (!engine->start({query}, TextMatcher::WholeWord))
+ *       showError(engine->errorString());
+ * @endcode
+ */
+
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QPolygonF>
+#include <QRectF>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <memory>
+
+#include "PageTextCache.h"
+#include "TextSearch.h"
+
+class DocumentPool;
+class QPdfDocument;
+
+/**
+ * @struct SearchHit
+ * @brief One match with its position in the page text and on the page.
+ */
+struct SearchHit {
+    int page {0};
+    int term {0};                ///< Index of the matching term
+    int start {0};               ///< First character in the page text
+    int length {0};
+    QRectF rect;                 ///< Bounding rectangle in page points
+    QList<QPolygonF> bounds;     ///< Per-line outlines in page points
+};
+
+/**
+ * @class SearchEngine
+ * @brief Runs searches on worker threads and streams hits page by page.
+ */
+class SearchEngine : public QObject {
+    Q_OBJECT
+public:
+    explicit SearchEngine(QObject* parent = nullptr);
+    ~SearchEngine() override;
+
+    /**
+     * @brief Searches @p doc from now on, using @p cache for its page text.
+     *
+     * start() and prefetch() run their pages on @p pool, which must have
+     * the file of @p doc open (or be closed, in which case nothing is
+     * searched). Without a pool only run() works. Cancels and waits for the
+     * running search. A new empty cache is used if @p cache is null.
+     */
+    void setDocument(QPdfDocument* doc, DocumentPool* pool,
+                     std::unique_ptr<PageTextCache> cache = nullptr);
+
+    /**
+     * @brief Cancels the running search and hands out the text cache.
+     *
+     * Used to keep a document's text with it when it goes warm; the engine
+     * continues with an empty cache.
+     */
+    std::unique_ptr<PageTextCache> takeTextCache();
+
+    PageTextCache* textCache() const { return m_cache.get(); }
+
+    /**
+     * @brief Starts searching for @p terms, cancelling the running search.
+     * @return False if a term is an invalid pattern (see errorString())
+     */
+    bool start(const QStringList& terms, TextMatcher::Options options);
+
+    /// Cancels the running search; its remaining results are not emitted.
+    void cancel();
+
+    /**
+     * @brief Extracts the text of all pages into the cache in the background.
+     *
+     * Cancelled like a search by start(), cancel() and document changes;
+     * pages extracted until then stay cached.
+     */
+    void prefetch();
+
+    /**
+     * @brief Searches synchronously and returns all hits in page order.
+     *
+     * For headless use (BatchSearch); the viewer always uses start(). Uses
+     * the same per-page code and cache as start(), but searches the pages
+     * on the calling thread, which must own the document.
+     */
+    QVector<SearchHit> run(const QStringList& terms, TextMatcher::Options options);
+
+    /// Generation of the latest search; results carrying another one are stale
+    quint64 generation() const { return m_generation.load(); }
+
+    bool isRunning() const;
+
+    /// Error of the last start() or run() with an invalid pattern
+    QString errorString() const { return m_errorString; }
+
+signals:
+    /**
+     * @brief Hits of pages [@p firstPage, @p firstPage + @p pageCount), in page order.
+     *
+     * Emitted from a worker thread; connect with the default (queued)
+     * connection type.
+     */
+    void resultsReady(quint64 generation, int firstPage, int pageCount, const QVector<SearchHit>& hits);
+
+    /// The search of @p generation went through all pages.
+    void finished(quint64 generation, int hitCount, qint64 elapsedNs);
+
+private:
+    using Matchers = std::shared_ptr<const QVector<TextMatcher>>;
+
+    Matchers compile(const QStringList& terms, TextMatcher::Options options);
+    /// Hits of one page of @p source; returns early once @p generation is stale (0: never)
+    QVector<SearchHit> searchPage(const Matchers& matchers, int page, quint64 generation,
+                                  QPdfDocument& source) const;
+    void runBatches(const Matchers& matchers, quint64 generation, quint64 session, int pageCount);
+
+    QPdfDocument* m_doc {nullptr};          ///< Used on the GUI thread only
+    DocumentPool* m_documents {nullptr};
+    std::unique_ptr<PageTextCache> m_cache;
+    QThreadPool m_pool;                     ///< One thread: at most one search job at a time
+    std::atomic<quint64> m_generation {0};
+    QString m_errorString;
+};
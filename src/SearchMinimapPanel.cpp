@@ -40,6 +40,18 @@ void SearchMinimapPanel::setMarkers(const QVector<MiniMapMarker>& markers)
         m_minimap->setMarkers(markers);
 }
 
+void SearchMinimapPanel::appendMarkers(const QVector<MiniMapMarker>& markers)
+{
+    if (m_minimap)
+        m_minimap->appendMarkers(markers);
+}
+
+const QVector<MiniMapMarker>& SearchMinimapPanel::markers() const
+{
+    static const QVector<MiniMapMarker> empty;
+    return m_minimap ? m_minimap->markers() : empty;
+}
+
 void SearchMinimapPanel::setViewportRange(qreal start, qreal end)
 {
     if (m_minimap)
@@ -55,6 +55,16 @@ public:
      */
     void setMarkers(const QVector<MiniMapMarker>& markers);
 
+    /**
+     * @brief Merges more markers into the ones shown (see MiniMapWidget::appendMarkers).
+     */
+    void appendMarkers(const QVector<MiniMapMarker>& markers);
+
+    /**
+     * @brief Returns the markers currently shown.
+     */
+    const QVector<MiniMapMarker>& markers() const;
+
     /**
      * @brief Sets the currently visible viewport range.
      * @param start Normalized start position (0.0 to 1.0)
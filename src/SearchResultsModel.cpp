@@ -0,0 +1,153 @@
+/**
+ * @file SearchResultsModel.cpp
+ * @brief Implementation of the search results model.
+ */
+
+#include "SearchResultsModel.h"
+#include "PageTextCache.h"
+
+#include <QPdfDocument>
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+constexpr int kContextChars = 40;
+constexpr int kSnippetCacheRows = 512;
+}
+
+SearchResultsModel::SearchResultsModel(QObject* parent)
+    : QAbstractListModel(parent)
+    , m_snippets(kSnippetCacheRows)
+{
+}
+
+void SearchResultsModel::reset(PageTextCache* cache, QPdfDocument* doc, DocumentPool* pool)
+{
+    beginResetModel();
+    m_hits.clear();
+    m_textCache = cache;
+    m_doc = doc;
+    m_pool = pool;
+    m_snippets.clear();
+    m_pendingPages.clear();
+    ++m_epoch;
+    endResetModel();
+}
+
+void SearchResultsModel::appendHits(const QVector<SearchHit>& hits)
+{
+    if (hits.isEmpty())
+        return;
+    const int first = int(m_hits.size());
+    beginInsertRows(QModelIndex(), first, first + int(hits.size()) - 1);
+    m_hits += hits;
+    endInsertRows();
+}
+
+int SearchResultsModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return int(m_hits.size());
+}
+
+QVariant SearchResultsModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_hits.size())
+        return {};
+    const int row = index.row();
+    const int page = m_hits.at(row).page;
+
+    switch (role) {
+    case PageRole:
+        return page;
+    case SnippetRole:
+        return snippet(row);
+    case Qt::DisplayRole: {
+        const QString text = snippet(row);
+        return tr("p. %1").arg(page + 1) + QStringLiteral("   ") + (text.isNull() ? tr("Loading...") : text);
+    }
+    case Qt::ToolTipRole:
+        return tr("Page %1").arg(page + 1);
+    default:
+        return {};
+    }
+}
+
+QString SearchResultsModel::snippet(int row) const
+{
+    if (const QString* cached = m_snippets.object(row))
+        return *cached;
+
+    const SearchHit& hit = m_hits.at(row);
+    FoldedText page;
+    if (!m_textCache || !m_doc || !m_textCache->cachedPage(m_doc, hit.page, &page)) {
+        // Not cached: extracted off the GUI thread. data() is const, queueing the page is not.
+        QMetaObject::invokeMethod(const_cast<SearchResultsModel*>(this),
+                                  [self = const_cast<SearchResultsModel*>(this), p = hit.page]{ self->fetchPage(p); },
+                                  Qt::QueuedConnection);
+        return {};
+    }
+    const QString& original = page.original();
+    const int from = qMax(0, hit.start - kContextChars);
+    const int to = qMin(int(original.size()), hit.start + hit.length + kContextChars);
+    // simplified() keeps the snippet on one line
+    const QString text = (from > 0 ? QStringLiteral("…") : QString())
+        + original.mid(from, to - from).simplified()
+        + (to < original.size() ? QStringLiteral("…") : QString());
+    m_snippets.insert(row, new QString(text));
+    return text;
+}
+
+void SearchResultsModel::fetchPage(int page)
+{
+    if (!m_pool || !m_doc || m_pendingPages.contains(page))
+        return;
+    m_pendingPages.insert(page);
+    const quint64 epoch = m_epoch;
+    const QPointer<SearchResultsModel> self(this);
+    // Released when the job has run or was dropped (cancelAll(), close()),
+    // so the page can be asked for again
+    std::shared_ptr<void> pending(nullptr, [self, epoch, page](void*){
+        QMetaObject::invokeMethod(self, [self, epoch, page]{
+            if (self && self->m_epoch == epoch)
+                self->m_pendingPages.remove(page);
+        }, Qt::QueuedConnection);
+    });
+    m_pool->run(DocumentPool::Priority::High, [self, epoch, page, pending](QPdfDocument& doc){
+        const QString text = doc.getAllText(page).text();
+        QMetaObject::invokeMethod(self, [self, epoch, page, text]{
+            if (self)
+                self->onPageText(epoch, page, text);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void SearchResultsModel::onPageText(quint64 epoch, int page, const QString& text)
+{
+    if (epoch != m_epoch || !m_textCache || !m_doc)
+        return;
+    m_textCache->insert(m_doc, page, FoldedText::fold(text));
+    // Hits are in page order: update the rows of this page
+    auto byPage = [](const SearchHit& hit, int p){ return hit.page < p; };
+    const auto first = std::lower_bound(m_hits.cbegin(), m_hits.cend(), page, byPage);
+    auto last = first;
+    while (last != m_hits.cend() && last->page == page)
+        ++last;
+    if (first == last)
+        return;
+    emit dataChanged(index(int(first - m_hits.cbegin())), index(int(last - m_hits.cbegin()) - 1),
+                     {Qt::DisplayRole, SnippetRole});
+}
+
+qint64 SearchResultsModel::byteSize() const
+{
+    qint64 bytes = qint64(m_hits.size()) * qint64(sizeof(SearchHit));
+    for (const SearchHit& hit : m_hits) {
+        for (const QPolygonF& poly : hit.bounds)
+            bytes += qint64(poly.size()) * qint64(sizeof(QPointF));
+    }
+    // QCache does not expose its entries; assume full rows of context
+    return bytes + qint64(m_snippets.size()) * (2 * kContextChars + 16) * qint64(sizeof(QChar));
+}
@@ -0,0 +1,86 @@
+/**
+ * @file SearchResultsModel.h
+ * @brief List model of search hits with lazily built context snippets.
+ *
+ * A search can produce hundreds of thousands of hits. SearchResultsModel
+ * stores the hits as SearchEngine delivers them; the context snippet shown
+ * for a row is cut from the cached page text when the view asks for it,
+ * which a QListView with uniform item sizes only does for visible rows.
+ * Recently built snippets are kept in a small cache.
+ *
+ * data() never calls pdfium: a row whose page text is not cached shows a
+ * placeholder, the page is extracted as a DocumentPool job and the rows of
+ * that page are updated through dataChanged() once it arrives.
+ *
+ * Usage:
+ * @code
+ *   auto* model = new SearchResultsModel(this);
+ *   model->reset(engine->textCache(), doc, pool);  // pool has doc's file open
+ *   model->appendHits(hits);              // per SearchEngine::resultsReady
+ *   listView->setUniformItemSizes(true);
+ *   listView->setModel(model);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QPointer>
+#include <QSet>
+#include <QVector>
+
+#include "DocumentPool.h"
+#include "SearchEngine.h"
+
+class PageTextCache;
+class QPdfDocument;
+
+/**
+ * @class SearchResultsModel
+ * @brief Virtualized model behind the search results panel.
+ */
+class SearchResultsModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    enum Role {
+        PageRole = Qt::UserRole + 1,   ///< 0-based page of the hit
+        SnippetRole                    ///< Context without the page label
+    };
+
+    explicit SearchResultsModel(QObject* parent = nullptr);
+
+    /**
+     * @brief Removes all rows; snippets of new rows are cut from @p cache.
+     *
+     * Pages missing from @p cache are extracted on @p pool, which must
+     * have the file of @p doc open; without it they keep the placeholder.
+     */
+    void reset(PageTextCache* cache, QPdfDocument* doc, DocumentPool* pool);
+
+    /// Appends hits delivered in page order.
+    void appendHits(const QVector<SearchHit>& hits);
+
+    /// All hits, in row order
+    const QVector<SearchHit>& hits() const { return m_hits; }
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+    /// Estimated bytes held (hits and cached snippets)
+    qint64 byteSize() const;
+
+private:
+    /// Snippet of @p row; empty and queues its page if the text is not cached
+    QString snippet(int row) const;
+    void fetchPage(int page);
+    void onPageText(quint64 epoch, int page, const QString& text);
+
+    QVector<SearchHit> m_hits;
+    PageTextCache* m_textCache {nullptr};
+    QPointer<QPdfDocument> m_doc;
+    QPointer<DocumentPool> m_pool;
+    mutable QCache<int, QString> m_snippets;
+    QSet<int> m_pendingPages;            ///< Pages queued on m_pool, until run or dropped
+    quint64 m_epoch {0};                 ///< Bumped by reset(); drops late page text
+};
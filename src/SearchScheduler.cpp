@@ -0,0 +1,68 @@
+/**
+ * @file SearchScheduler.cpp
+ * @brief Implementation of the search cost model.
+ */
+
+#include "SearchScheduler.h"
+
+#include <algorithm>
+
+namespace {
+// Weight of a new sample in the running per-page averages
+constexpr double kSmoothing = 0.5;
+
+double blend(double current, double sample)
+{
+    return current + kSmoothing * (sample - current);
+}
+}
+
+void SearchScheduler::setPageCount(int pageCount)
+{
+    if (pageCount == m_pageCount)
+        return;
+    m_pageCount = qMax(0, pageCount);
+    m_cancelledNs = 0;
+}
+
+void SearchScheduler::recordSearch(int pages, int pagesExtracted, qint64 ns)
+{
+    if (pages <= 0 || ns <= 0)
+        return;
+    pagesExtracted = qBound(0, pagesExtracted, pages);
+    const int warmPages = pages - pagesExtracted;
+    if (pagesExtracted == 0) {
+        m_warmNsPerPage = blend(m_warmNsPerPage, double(ns) / pages);
+    } else {
+        // Attribute the time not explained by the warm rate to extraction
+        const double cold = (double(ns) - warmPages * m_warmNsPerPage) / pagesExtracted;
+        m_coldNsPerPage = blend(m_coldNsPerPage, std::max(cold, m_warmNsPerPage));
+    }
+    m_cancelledNs = 0;
+}
+
+void SearchScheduler::recordCancelled(qint64 ns)
+{
+    m_cancelledNs = std::max(m_cancelledNs, ns);
+}
+
+qint64 SearchScheduler::expectedSearchNs(int cachedPages) const
+{
+    const int cached = qBound(0, cachedPages, m_pageCount);
+    const double ns = cached * m_warmNsPerPage + (m_pageCount - cached) * m_coldNsPerPage;
+    return std::max(qint64(ns), m_cancelledNs);
+}
+
+int SearchScheduler::debounceMs(int cachedPages) const
+{
+    const qint64 expected = expectedSearchNs(cachedPages);
+    if (expected < kImmediateNs)
+        return 0;
+    return qBound(kMinDebounceMs, int(expected / 4 / 1000000), kMaxDebounceMs);
+}
+
+bool SearchScheduler::shouldPrefetch(int cachedPages) const
+{
+    return m_pageCount > 0 && cachedPages < m_pageCount
+        && (m_pageCount - cachedPages) * m_coldNsPerPage < kPrefetchNs;
+}
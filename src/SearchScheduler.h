@@ -0,0 +1,84 @@
+/**
+ * @file SearchScheduler.h
+ * @brief Chooses the search-box debounce from the measured cost of searches.
+ *
+ * A fixed debounce is too slow for a three page memo and too eager for a
+ * 4,000 page exhibit. SearchScheduler keeps a per-page cost estimate for
+ * pages whose text still has to be extracted ("cold") and for pages whose
+ * folded text is cached ("warm"), refines both from every completed
+ * search, and derives from them the expected cost of the next search and
+ * the debounce interval:
+ * - expected cost below kImmediateNs: search on every keystroke
+ * - otherwise a quarter of the expected cost, between kMinDebounceMs and
+ *   kMaxDebounceMs
+ *
+ * A search cancelled by the next keystroke after running longer than the
+ * estimate raises the estimate, so fast typists on large documents get a
+ * longer interval before any search completes. Small documents (a cold
+ * search below kPrefetchNs) have their text extracted while the viewer is
+ * idle, so the first search only matches.
+ *
+ * The rates survive document switches as the prior for the next document.
+ * The current choice is shown in the performance HUD (F12).
+ *
+ * Usage:
+ * @code
+ *   scheduler.setPageCount(doc->pageCount());
+ *   debounce->start(scheduler.debounceMs(cache->cachedPageCount()));
+ *   ...
+ *   scheduler.recordSearch(pages, pagesExtracted, elapsedNs);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+/**
+ * @class SearchScheduler
+ * @brief Cost model behind the adaptive search debounce.
+ */
+class SearchScheduler {
+public:
+    static constexpr qint64 kImmediateNs = 30 * 1000 * 1000;    ///< Cheaper searches are not debounced
+    static constexpr qint64 kPrefetchNs = 150 * 1000 * 1000;    ///< Cold searches below this prefetch text
+    static constexpr int kMinDebounceMs = 40;
+    static constexpr int kMaxDebounceMs = 400;
+
+    /**
+     * @brief Starts estimating for a document with @p pageCount pages.
+     */
+    void setPageCount(int pageCount);
+
+    /**
+     * @brief Records a search that went through all pages.
+     * @param pages Pages searched
+     * @param pagesExtracted Pages whose text was not cached before the search
+     * @param ns Wall time of the search
+     */
+    void recordSearch(int pages, int pagesExtracted, qint64 ns);
+
+    /**
+     * @brief Records a search cancelled after @p ns without completing.
+     */
+    void recordCancelled(qint64 ns);
+
+    /// Expected time of a full search when @p cachedPages pages have cached text
+    qint64 expectedSearchNs(int cachedPages) const;
+
+    /// Debounce interval for the next keystroke
+    int debounceMs(int cachedPages) const;
+
+    /// True if the document is small enough to extract its text while idle
+    bool shouldPrefetch(int cachedPages) const;
+
+    int pageCount() const { return m_pageCount; }
+    double coldNsPerPage() const { return m_coldNsPerPage; }
+    double warmNsPerPage() const { return m_warmNsPerPage; }
+
+private:
+    int m_pageCount {0};
+    double m_coldNsPerPage {1.0e6};     ///< Extract, fold and match
+    double m_warmNsPerPage {2.0e4};     ///< Match cached text
+    qint64 m_cancelledNs {0};           ///< Longest cancelled search on this document
+};
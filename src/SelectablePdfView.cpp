@@ -4,11 +4,16 @@
  */
 
 #include "SelectablePdfView.h"
+#include "PerfStats.h"
+#include "TextSearch.h"
+#include "Trace.h"
 
 #include <QAbstractItemModel>
 #include <QContextMenuEvent>
 #include <QCursor>
 #include <QEvent>
+#include <QFont>
+#include <QFontMetrics>
 #include <QGuiApplication>
 #include <QClipboard>
 #include <QMenu>
@@ -16,17 +21,52 @@
 #include <QPainter>
 #include <QPdfDocument>
 #include <QPdfPageNavigator>
+#include <QPdfPageRenderer>
 #include <QResizeEvent>
 #include <QScrollBar>
+#include <QStringList>
+#include <QTimer>
 #include <QtGlobal>
 #include <QtMath>
+#include <algorithm>
 #include <array>
+#include <tuple>
 
 SelectablePdfView::SelectablePdfView(QWidget* parent)
     : QPdfView(parent)
 {
     setMouseTracking(true);
     viewport()->setMouseTracking(true);
+
+    // QPdfView renders pages through an internal QPdfPageRenderer; watching
+    // it tells which pages are cached and how long visible pages stay blank.
+    m_perfClock.start();
+    m_pageRenderer = findChild<QPdfPageRenderer*>();
+    if (m_pageRenderer) {
+        connect(m_pageRenderer, &QPdfPageRenderer::pageRendered, this, [this](int page, QSize imageSize){
+            m_renderedPages.insert(page, imageSize);
+            const auto pending = m_pendingRenders.constFind(page);
+            if (pending != m_pendingRenders.constEnd()) {
+                PerfStats::recordPageRender(m_perfClock.nsecsElapsed() - pending.value());
+                m_pendingRenders.erase(pending);
+            }
+        });
+    }
+    connect(this, &QPdfView::documentChanged, this, &SelectablePdfView::invalidateRenderCache);
+    connect(this, &QPdfView::documentChanged, this, [this]{
+        m_searchHighlights.clear();
+        m_currentSearchHighlight = -1;
+        m_textLayer.reset();
+        m_placeholderPages.clear();
+    });
+    // QPdfView resets the scroll range of an empty document after zooming
+    connect(this, &QPdfView::zoomModeChanged, this, &SelectablePdfView::updatePlaceholderScrollBars,
+            Qt::QueuedConnection);
+    connect(this, &QPdfView::zoomFactorChanged, this, &SelectablePdfView::updatePlaceholderScrollBars,
+            Qt::QueuedConnection);
+    connect(this, &QPdfView::zoomFactorChanged, this, &SelectablePdfView::invalidateRenderCache);
+    connect(this, &QPdfView::zoomModeChanged, this, &SelectablePdfView::invalidateRenderCache);
+    connect(this, &QPdfView::pageModeChanged, this, &SelectablePdfView::invalidateRenderCache);
 }
 
 bool SelectablePdfView::hasSelection() const
@@ -100,8 +140,113 @@ void SelectablePdfView::updateSelectionFromDrag()
 
 void SelectablePdfView::paintEvent(QPaintEvent* ev)
 {
+    TRACE_SCOPE("SelectablePdfView::paintEvent");
+    QElapsedTimer frameTimer;
+    if (m_perfHudVisible)
+        frameTimer.start();
+
     QPdfView::paintEvent(ev);
+    paintPlaceholderPages();
+
+    if (!m_firstPagePainted && document() && document()->pageCount() > 0) {
+        m_firstPagePainted = true;
+        QMetaObject::invokeMethod(this, &SelectablePdfView::firstPagePainted, Qt::QueuedConnection);
+    }
+
+    paintSearchHighlights();
+    paintSelectionOverlay();
+
+    if (m_perfHudVisible) {
+        trackRenderCache();
+        PerfStats::recordFrame(frameTimer.nsecsElapsed());
+        QPainter p(viewport());
+        drawPerfHud(p);
+    }
+}
+
+void SelectablePdfView::setPlaceholderPages(const QVector<QSizeF>& pageSizes)
+{
+    m_placeholderPages = pageSizes;
+    updatePlaceholderScrollBars();
+    viewport()->update();
+}
+
+bool SelectablePdfView::hasPlaceholderPages() const
+{
+    return !m_placeholderPages.isEmpty() && (!document() || document()->pageCount() == 0);
+}
+
+qreal SelectablePdfView::placeholderScale() const
+{
+    // Same rule as currentScale(), for the first page
+    const QSizeF pts = m_placeholderPages.constFirst();
+    if (pts.width() <= 0.0 || pts.height() <= 0.0)
+        return 1.0;
+    const auto m = documentMargins();
+    const qreal availW = viewport()->width() - m.left() - m.right();
+    const qreal availH = viewport()->height() - m.top() - m.bottom();
+    switch (zoomMode()) {
+    case QPdfView::ZoomMode::FitToWidth:
+        return (availW > 0.0) ? (availW / pts.width()) : 1.0;
+    case QPdfView::ZoomMode::FitInView: {
+        const qreal sW = (availW > 0.0) ? (availW / pts.width()) : 1.0;
+        const qreal sH = (availH > 0.0) ? (availH / pts.height()) : 1.0;
+        return qMin(sW, sH);
+    }
+    default:
+        return zoomFactor() * (logicalDpiX() / 72.0);
+    }
+}
 
+void SelectablePdfView::updatePlaceholderScrollBars()
+{
+    if (!hasPlaceholderPages())
+        return;
+    const qreal s = placeholderScale();
+    const auto m = documentMargins();
+    qreal width = 0.0;
+    qreal height = 0.0;
+    for (const QSizeF& pts : std::as_const(m_placeholderPages)) {
+        width = qMax(width, pts.width() * s);
+        height += pts.height() * s;
+    }
+    height += qreal(pageSpacing()) * (m_placeholderPages.size() - 1);
+    const QSize content(qCeil(width) + m.left() + m.right(), qCeil(height) + m.top() + m.bottom());
+    const QSize view = viewport()->size();
+    horizontalScrollBar()->setRange(0, qMax(0, content.width() - view.width()));
+    horizontalScrollBar()->setPageStep(view.width());
+    verticalScrollBar()->setRange(0, qMax(0, content.height() - view.height()));
+    verticalScrollBar()->setPageStep(view.height());
+}
+
+void SelectablePdfView::paintPlaceholderPages()
+{
+    if (!hasPlaceholderPages())
+        return;
+    QPainter p(viewport());
+    p.setPen(QColor(0, 0, 0, 40));
+    p.setBrush(Qt::white);
+    const qreal s = placeholderScale();
+    const auto m = documentMargins();
+    const int hOff = horizontalScrollBar()->value();
+    const int vOff = verticalScrollBar()->value();
+    const int viewH = viewport()->height();
+    qreal y = m.top() - vOff;
+    for (const QSizeF& pts : std::as_const(m_placeholderPages)) {
+        const QSizeF size = pts * s;
+        if (y > viewH)
+            break;
+        if (y + size.height() >= 0.0) {
+            const qreal extra = viewport()->width() - (size.width() + m.left() + m.right());
+            const qreal x = m.left() + (extra > 0.0 ? extra / 2.0 : 0.0) - hOff;
+            p.drawRect(QRectF(QPointF(x, y), size));
+        }
+        y += size.height() + pageSpacing();
+    }
+}
+
+void SelectablePdfView::paintSelectionOverlay()
+{
     if (!hasSelection())
         return;
 
@@ -270,6 +415,13 @@ void SelectablePdfView::contextMenuEvent(QContextMenuEvent* ev)
     actCopy->setEnabled(hasSelection());
     QAction* actSelectAll = menu.addAction(tr("Select All (This Page)"));
     QAction* actSelectAllDoc = menu.addAction(tr("Select All (Document)"));
+    if (!m_contextMenuActions.isEmpty()) {
+        menu.addSeparator();
+        for (const QPointer<QAction>& action : std::as_const(m_contextMenuActions)) {
+            if (action)
+                menu.addAction(action);
+        }
+    }
 
     QAction* chosen = menu.exec(ev->globalPos());
     if (!chosen) return;
@@ -378,6 +530,10 @@ void SelectablePdfView::leaveEvent(QEvent* ev)
 void SelectablePdfView::resizeEvent(QResizeEvent* ev)
 {
     QPdfView::resizeEvent(ev);
+    updatePlaceholderScrollBars();
+    // Fit modes re-render all pages at the new size
+    if (zoomMode() != QPdfView::ZoomMode::Custom)
+        invalidateRenderCache();
     emit viewportGeometryChanged();
 }
 
@@ -390,28 +546,33 @@ void SelectablePdfView::selectWordAt(const QPointF& viewportPos)
     if (!hit || hit->page < 0)
         return;
 
-    QPdfSelection pageTextSel = document()->getAllText(hit->page);
-    if (!pageTextSel.isValid())
-        return;
-
-    const QString pageText = pageTextSel.text();
-    if (pageText.isEmpty() || hit->charIndex < 0 || hit->charIndex >= pageText.size())
-        return;
+    int wordStart = -1;
+    int length = 0;
+    if (m_textLayer) {
+        std::tie(wordStart, length) = m_textLayer->wordAt(hit->page, hit->charIndex);
+    } else {
+        QPdfSelection pageTextSel = document()->getAllText(hit->page);
+        if (!pageTextSel.isValid())
+            return;
 
-    if (!isWordCharacter(pageText.at(hit->charIndex)))
-        return;
+        const QString pageText = pageTextSel.text();
+        if (pageText.isEmpty() || hit->charIndex < 0 || hit->charIndex >= pageText.size())
+            return;
 
-    int wordStart = hit->charIndex;
-    while (wordStart > 0 && isWordCharacter(pageText.at(wordStart - 1)))
-        --wordStart;
+        if (!isWordCharacter(pageText.at(hit->charIndex)))
+            return;
 
-    int wordEnd = hit->charIndex + 1;
-    const int textSize = pageText.size();
-    while (wordEnd < textSize && isWordCharacter(pageText.at(wordEnd)))
-        ++wordEnd;
+        wordStart = hit->charIndex;
+        while (wordStart > 0 && isWordCharacter(pageText.at(wordStart - 1)))
+            --wordStart;
 
-    const int length = wordEnd - wordStart;
-    if (length <= 0)
+        int wordEnd = hit->charIndex + 1;
+        const int textSize = pageText.size();
+        while (wordEnd < textSize && isWordCharacter(pageText.at(wordEnd)))
+            ++wordEnd;
+        length = wordEnd - wordStart;
+    }
+    if (wordStart < 0 || length <= 0)
         return;
 
     QPdfSelection wordSelection = document()->getSelectionAtIndex(hit->page, wordStart, length);
@@ -465,6 +626,17 @@ std::optional<SelectablePdfView::TextHitResult> SelectablePdfView::hitTestCharac
     const QPointF pagePt = contentToPagePointsFor(page, contentPos);
 
     constexpr qreal probeDelta = 3.0;
+    if (m_textLayer) {
+        const int index = m_textLayer->charIndexAt(page, pagePt, probeDelta);
+        if (index < 0)
+            return std::nullopt;
+        TextHitResult info;
+        info.page = page;
+        info.charIndex = index;
+        info.hasGlyph = true;
+        return info;
+    }
+
     const std::array<QPointF, 4> probes = {
         QPointF(pagePt.x() + probeDelta, pagePt.y()),
         QPointF(pagePt.x() - probeDelta, pagePt.y()),
@@ -509,11 +681,8 @@ void SelectablePdfView::updateHoverCursor(const QPointF& viewportPos)
 
 bool SelectablePdfView::isWordCharacter(QChar ch)
 {
-    if (ch.isLetterOrNumber())
-        return true;
-    if (ch.category() == QChar::Punctuation_Connector)
-        return true;
-    return ch == QLatin1Char('_') || ch == QLatin1Char('-');
+    // Shared with whole-word search
+    return TextMatcher::isWordCharacter(ch);
 }
 
 std::optional<qreal> SelectablePdfView::documentPointYForViewportY(qreal viewportY) const
@@ -552,3 +721,259 @@ qreal SelectablePdfView::totalDocumentPointsHeight() const
         total += document()->pagePointSize(i).height();
     return total;
 }
+
+void SelectablePdfView::setPerfHudVisible(bool visible)
+{
+    if (m_perfHudVisible == visible)
+        return;
+    m_perfHudVisible = visible;
+    if (visible) {
+        if (!m_perfHudTimer) {
+            m_perfHudTimer = new QTimer(this);
+            m_perfHudTimer->setInterval(250);
+            connect(m_perfHudTimer, &QTimer::timeout, this, [this]{ viewport()->update(perfHudRect()); });
+        }
+        m_perfHudTimer->start();
+    } else {
+        if (m_perfHudTimer)
+            m_perfHudTimer->stop();
+        m_pendingRenders.clear();
+    }
+    viewport()->update();
+}
+
+qint64 SelectablePdfView::renderCacheBytes() const
+{
+    qint64 bytes = 0;
+    for (const QSize& size : m_renderedPages)
+        bytes += qint64(size.width()) * size.height() * 4;
+    return bytes;
+}
+
+qint64 SelectablePdfView::selectionBytes(int* pages) const
+{
+    auto bytesOf = [](const QPdfSelection& sel) -> qint64 {
+        if (!sel.isValid())
+            return 0;
+        qint64 bytes = qint64(sel.text().size()) * qint64(sizeof(QChar));
+        for (const QPolygonF& poly : sel.bounds())
+            bytes += qint64(poly.size()) * qint64(sizeof(QPointF));
+        return bytes;
+    };
+
+    qint64 bytes = 0;
+    int count = 0;
+    for (const QPdfSelection& sel : m_allPageSelections) {
+        if (sel.isValid()) {
+            bytes += bytesOf(sel);
+            ++count;
+        }
+    }
+    if (m_selection && m_selection->isValid()) {
+        bytes += bytesOf(*m_selection);
+        ++count;
+    }
+    if (pages)
+        *pages = count;
+    return bytes;
+}
+
+void SelectablePdfView::addContextMenuAction(QAction* action)
+{
+    m_contextMenuActions.append(action);
+}
+
+void SelectablePdfView::invalidateRenderCache()
+{
+    m_renderedPages.clear();
+    m_pendingRenders.clear();
+}
+
+bool SelectablePdfView::visiblePageRange(int& first, int& last) const
+{
+    first = -1;
+    last = -1;
+    QPdfDocument* doc = document();
+    if (!doc || doc->pageCount() <= 0)
+        return false;
+
+    // One pass over the page heights
+    if (pageMode() == QPdfView::PageMode::SinglePage) {
+        const int current = pageNavigator() ? pageNavigator()->currentPage() : 0;
+        first = last = qBound(0, current, doc->pageCount() - 1);
+    } else {
+        const qreal s = currentScale();
+        const int spacing = pageSpacing();
+        const qreal top = verticalScrollBar()->value() - documentMargins().top();
+        const qreal bottom = top + viewport()->height();
+        qreal y = 0.0;
+        for (int i = 0; i < doc->pageCount() && y < bottom; ++i) {
+            const qreal h = doc->pagePointSize(i).height() * s;
+            if (y + h >= top) {
+                if (first < 0)
+                    first = i;
+                last = i;
+            }
+            y += h + spacing;
+        }
+    }
+    return first >= 0;
+}
+
+void SelectablePdfView::trackRenderCache()
+{
+    int first = -1;
+    int last = -1;
+    if (!m_pageRenderer || !visiblePageRange(first, last))
+        return;
+
+    const qint64 now = m_perfClock.nsecsElapsed();
+    for (int page = first; page <= last; ++page) {
+        const bool hit = m_renderedPages.contains(page);
+        PerfStats::recordRenderCacheLookup(hit);
+        if (!hit && !m_pendingRenders.contains(page))
+            m_pendingRenders.insert(page, now);
+    }
+}
+
+QRect SelectablePdfView::perfHudRect() const
+{
+    constexpr int kWidth = 340;
+    constexpr int kHeight = 142;
+    constexpr int kMargin = 8;
+    return QRect(viewport()->width() - kWidth - kMargin, kMargin, kWidth, kHeight);
+}
+
+void SelectablePdfView::drawPerfHud(QPainter& p)
+{
+    const PerfStats::Snapshot s = PerfStats::snapshot();
+    auto mb = [](qint64 bytes){ return QString::number(double(bytes) / (1024.0 * 1024.0), 'f', 1); };
+    auto percent = [](double rate){ return QString::number(rate * 100.0, 'f', 0) + QLatin1Char('%'); };
+
+    const QStringList lines {
+        tr("Paint   %1 ms avg  %2 ms max  %3 fps")
+            .arg(s.frameAvgMs, 0, 'f', 1).arg(s.frameMaxMs, 0, 'f', 1).arg(s.framesPerSecond, 0, 'f', 0),
+        tr("Render  %1 ms avg  %2 ms max  (%3 pages)")
+            .arg(s.renderAvgMs, 0, 'f', 1).arg(s.renderMaxMs, 0, 'f', 1).arg(s.renderSamples),
+        tr("Render cache  %1 hit  (%2/%3 page paints)")
+            .arg(percent(s.renderHitRate())).arg(s.renderHits).arg(s.renderHits + s.renderMisses),
+        tr("Thumbnails  %1 hit  %2 ms/render")
+            .arg(percent(s.thumbnailHitRate())).arg(s.thumbnailAvgMs, 0, 'f', 1),
+        tr("Search  %1 pages/s  (%2 pages, %3 ms)")
+            .arg(s.searchPagesPerSecond, 0, 'f', 0).arg(s.searchPages).arg(s.searchMs, 0, 'f', 0),
+        tr("Debounce  %1 ms  est %2 ms  %3/%4 us/page%5")
+            .arg(s.searchDebounceMs).arg(s.searchExpectedMs, 0, 'f', 0)
+            .arg(s.searchColdUsPerPage, 0, 'f', 0).arg(s.searchWarmUsPerPage, 0, 'f', 0)
+            .arg(s.searchPrefetch ? tr("  prefetch") : QString()),
+        tr("Memory  %1 MB file  %2 MB thumbs  %3 MB pages")
+            .arg(mb(s.mappedBytes), mb(s.thumbnailBytes), mb(renderCacheBytes())),
+    };
+
+    const QRect box = perfHudRect();
+    p.setRenderHint(QPainter::Antialiasing, true);
+    p.setPen(Qt::NoPen);
+    p.setBrush(QColor(20, 20, 20, 200));
+    p.drawRoundedRect(box, 6, 6);
+
+    QFont font = p.font();
+    font.setStyleHint(QFont::Monospace);
+    font.setFamily(QStringLiteral("monospace"));
+    font.setPointSizeF(8.5);
+    p.setFont(font);
+    p.setPen(QColor(230, 230, 230));
+    const int lineHeight = p.fontMetrics().height() + 2;
+    int y = box.top() + 8 + p.fontMetrics().ascent();
+    for (const QString& line : lines) {
+        p.drawText(box.left() + 10, y, line);
+        y += lineHeight;
+    }
+}
+
+void SelectablePdfView::setSearchHighlights(const QVector<SearchHighlight>& highlights)
+{
+    m_searchHighlights = highlights;
+    m_currentSearchHighlight = -1;
+    viewport()->update();
+}
+
+void SelectablePdfView::appendSearchHighlights(const QVector<SearchHighlight>& highlights)
+{
+    if (highlights.isEmpty())
+        return;
+    m_searchHighlights += highlights;
+    int first = -1;
+    int last = -1;
+    if (visiblePageRange(first, last) && highlights.first().page <= last && highlights.last().page >= first)
+        viewport()->update();
+}
+
+void SelectablePdfView::setTextLayer(TextLayerPtr layer)
+{
+    if (layer && (!document() || layer->pageCount() != document()->pageCount()))
+        return;
+    m_textLayer = std::move(layer);
+}
+
+void SelectablePdfView::setCurrentSearchHighlight(int index)
+{
+    if (index < -1 || index >= m_searchHighlights.size())
+        index = -1;
+    if (index == m_currentSearchHighlight)
+        return;
+    m_currentSearchHighlight = index;
+    viewport()->update();
+    emit currentSearchHighlightChanged(index);
+}
+
+void SelectablePdfView::paintSearchHighlights()
+{
+    if (m_searchHighlights.isEmpty())
+        return;
+    int first = -1;
+    int last = -1;
+    if (!visiblePageRange(first, last))
+        return;
+
+    // Hits are sorted by page: only walk the visible ones
+    const auto begin = std::lower_bound(m_searchHighlights.cbegin(), m_searchHighlights.cend(), first,
+                                        [](const SearchHighlight& h, int page){ return h.page < page; });
+
+    QPainter p(viewport());
+    p.setRenderHint(QPainter::Antialiasing, true);
+    p.setPen(Qt::NoPen);
+    const QColor fill(255, 215, 0, 110);
+    const QColor currentFill(255, 140, 0, 150);
+
+    const qreal s = currentScale();
+    const auto m = documentMargins();
+    const int hOff = horizontalScrollBar()->value();
+    const int vOff = verticalScrollBar()->value();
+    int offsetPage = -1;
+    qreal xOffCenter = 0.0;
+    qreal yOffPage = 0.0;
+    auto toViewport = [&](const QPointF& pt) {
+        return QPointF(xOffCenter + m.left() + pt.x() * s - hOff,
+                       m.top() + yOffPage + pt.y() * s - vOff);
+    };
+
+    for (auto it = begin; it != m_searchHighlights.cend() && it->page <= last; ++it) {
+        if (it->page != offsetPage) {
+            offsetPage = it->page;
+            xOffCenter = contentXOffsetFor(offsetPage);
+            yOffPage = pageOffsetY(offsetPage);
+        }
+        const bool current = int(it - m_searchHighlights.cbegin()) == m_currentSearchHighlight;
+        p.setBrush(current ? currentFill : fill);
+        if (it->bounds.isEmpty()) {
+            p.drawRect(QRectF(toViewport(it->rect.topLeft()), toViewport(it->rect.bottomRight())));
+            continue;
+        }
+        for (const QPolygonF& poly : it->bounds) {
+            QPolygonF polyPx;
+            polyPx.reserve(poly.size());
+            for (const QPointF& pt : poly)
+                polyPx << toViewport(pt);
+            p.drawPolygon(polyPx);
+        }
+    }
+}
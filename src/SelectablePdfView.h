@@ -26,11 +26,26 @@
 #include <QPdfView>
 #include <QPdfSelection>
 #include <QChar>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QPolygonF>
+#include <QPointer>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QSizeF>
 #include <QVector>
 #include <optional>
 
+#include "TextLayer.h"
+
 class QResizeEvent;
 class QEvent;
+class QAction;
+class QPainter;
+class QPdfPageRenderer;
+class QTimer;
 
 /**
  * @class SelectablePdfView
@@ -42,10 +57,22 @@ class QEvent;
  * - Right-click context menu with Copy and Select All
  * - Ctrl+C keyboard shortcut support
  * - Select all on current page or entire document
+ * - Highlight overlay for search hits, filled incrementally while searching
+ * - Optional performance HUD (paint times, render latency, cache hit rates)
  */
 class SelectablePdfView : public QPdfView {
     Q_OBJECT
 public:
+    /**
+     * @struct SearchHighlight
+     * @brief A search hit drawn by the view's own highlight overlay.
+     */
+    struct SearchHighlight {
+        int page {-1};
+        QRectF rect;                ///< Bounding rectangle in page points
+        QList<QPolygonF> bounds;    ///< Outline in page points (empty: use rect)
+    };
+
     /**
      * @brief Constructs a SelectablePdfView.
      * @param parent Parent widget
@@ -108,6 +135,92 @@ public:
      */
     qreal totalDocumentPointsHeight() const;
 
+    /**
+     * @brief Sets the search hits drawn by the highlight overlay.
+     * @param highlights Hits sorted by page
+     *
+     * Replaces QPdfView's search model highlighting, which the viewer no
+     * longer uses.
+     */
+    void setSearchHighlights(const QVector<SearchHighlight>& highlights);
+
+    /**
+     * @brief Appends hits of pages after the ones already shown.
+     *
+     * Only repaints if one of the new hits is on a visible page.
+     */
+    void appendSearchHighlights(const QVector<SearchHighlight>& highlights);
+
+    /**
+     * @brief Returns the hits drawn by the highlight overlay.
+     */
+    const QVector<SearchHighlight>& searchHighlights() const { return m_searchHighlights; }
+
+    /**
+     * @brief Marks hit @p index as the current one (-1 for none).
+     */
+    void setCurrentSearchHighlight(int index);
+
+    /**
+     * @brief Index of the current overlay hit, -1 if none.
+     */
+    int currentSearchHighlight() const { return m_currentSearchHighlight; }
+
+    /**
+     * @brief Uses @p layer for hover and double-click hit testing.
+     *
+     * Character boxes and word boundaries are then looked up in the mapped
+     * layer instead of asking pdfium. Cleared when the document changes;
+     * pass null to go back to pdfium.
+     */
+    void setTextLayer(TextLayerPtr layer);
+
+    /**
+     * @brief Lays out empty page frames of @p pageSizes (in points).
+     *
+     * Used while a document is still being parsed: the frames are laid out
+     * like QPdfView lays out pages in multi-page mode, so the scroll range
+     * and a restored scroll position are right before the first page has
+     * rendered. Shown only while the view's document has no pages; cleared
+     * when the document changes.
+     */
+    void setPlaceholderPages(const QVector<QSizeF>& pageSizes);
+
+    /**
+     * @brief Shows or hides the performance HUD overlay.
+     * @param visible True to show the HUD in the top-right corner
+     *
+     * The HUD shows the counters collected in PerfStats. Paint and render
+     * timings are only recorded while it is visible.
+     */
+    void setPerfHudVisible(bool visible);
+
+    /**
+     * @brief Returns true if the performance HUD is shown.
+     */
+    bool isPerfHudVisible() const { return m_perfHudVisible; }
+
+    /**
+     * @brief Approximate bytes held by QPdfView's rendered page images.
+     */
+    qint64 renderCacheBytes() const;
+
+    /**
+     * @brief Number of rendered page images counted by renderCacheBytes().
+     */
+    int renderCachePageCount() const { return int(m_renderedPages.size()); }
+
+    /**
+     * @brief Estimated bytes held by the current text selection.
+     * @param pages Receives the number of pages with a selection
+     */
+    qint64 selectionBytes(int* pages = nullptr) const;
+
+    /**
+     * @brief Appends @p action to the context menu (after a separator).
+     */
+    void addContextMenuAction(QAction* action);
+
 protected:
     void paintEvent(QPaintEvent* ev) override;
     void mousePressEvent(QMouseEvent* ev) override;
@@ -127,6 +240,19 @@ signals:
      */
     void viewportGeometryChanged();
 
+    /**
+     * @brief Emitted once, after the first paint that shows document pages.
+     *
+     * Delivered through the event loop so that receivers can do heavier
+     * work (e.g. deferred UI construction) outside of the paint event.
+     */
+    void firstPagePainted();
+
+    /**
+     * @brief Emitted when the current overlay hit changes.
+     */
+    void currentSearchHighlightChanged(int index);
+
 private:
     struct TextHitResult {
         int page {-1};
@@ -145,6 +271,17 @@ private:
     std::optional<TextHitResult> hitTestCharacter(const QPointF& viewportPos) const;
     void updateHoverCursor(const QPointF& viewportPos);
     static bool isWordCharacter(QChar ch);
+    void paintSelectionOverlay();
+    void paintSearchHighlights();
+    bool visiblePageRange(int& first, int& last) const;
+    bool hasPlaceholderPages() const;
+    qreal placeholderScale() const;
+    void updatePlaceholderScrollBars();
+    void paintPlaceholderPages();
+    void trackRenderCache();
+    void invalidateRenderCache();
+    QRect perfHudRect() const;
+    void drawPerfHud(QPainter& p);
 
     bool m_dragging {false};
     QPointF m_dragStartViewport;
@@ -153,5 +290,19 @@ private:
     int m_selectionPage {-1};
     bool m_allDocSelected {false};
     bool m_textCursorActive {false};
+    bool m_firstPagePainted {false};
     QVector<QPdfSelection> m_allPageSelections;
+    QList<QPointer<QAction>> m_contextMenuActions;
+    QVector<SearchHighlight> m_searchHighlights;
+    int m_currentSearchHighlight {-1};
+    TextLayerPtr m_textLayer;
+    QVector<QSizeF> m_placeholderPages;     ///< Cached page sizes while parsing
+
+    // Performance HUD
+    bool m_perfHudVisible {false};
+    QTimer* m_perfHudTimer {nullptr};
+    QPdfPageRenderer* m_pageRenderer {nullptr};
+    QElapsedTimer m_perfClock;
+    QHash<int, QSize> m_renderedPages;      ///< Page -> rendered image size
+    QHash<int, qint64> m_pendingRenders;    ///< Page -> time first painted blank
 };
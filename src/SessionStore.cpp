@@ -0,0 +1,112 @@
+/**
+ * @file SessionStore.cpp
+ * @brief Implementation of session and metadata persistence.
+ */
+
+#include "SessionStore.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QtGlobal>
+
+namespace {
+constexpr quint32 kMetadataMagic = 0x51505644;  // "QPVD"
+constexpr quint16 kMetadataVersion = 1;
+}
+
+QVector<qreal> DocumentMetadata::pageHeights() const
+{
+    QVector<qreal> heights;
+    heights.reserve(pageSizes.size());
+    for (const QSizeF& size : pageSizes)
+        heights.append(qMax<qreal>(size.height(), 1.0));
+    return heights;
+}
+
+SessionStore::SessionStore()
+    : m_cacheDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+                 + QStringLiteral("/metadata"))
+{
+}
+
+SessionState SessionStore::loadSession() const
+{
+    QSettings settings(QStringLiteral("QtPdfView"), QStringLiteral("QtPdfView"));
+    settings.beginGroup(QStringLiteral("session"));
+    SessionState state;
+    state.filePath = settings.value(QStringLiteral("file")).toString();
+    state.originalPath = settings.value(QStringLiteral("original")).toString();
+    state.page = settings.value(QStringLiteral("page"), 0).toInt();
+    state.zoomMode = QPdfView::ZoomMode(settings.value(QStringLiteral("zoomMode"),
+                                                       int(QPdfView::ZoomMode::FitToWidth)).toInt());
+    state.zoomFactor = settings.value(QStringLiteral("zoomFactor"), 1.0).toDouble();
+    state.horizontalScroll = settings.value(QStringLiteral("scrollX"), 0).toInt();
+    state.verticalScroll = settings.value(QStringLiteral("scrollY"), 0).toInt();
+    settings.endGroup();
+    return state;
+}
+
+void SessionStore::saveSession(const SessionState& state)
+{
+    QSettings settings(QStringLiteral("QtPdfView"), QStringLiteral("QtPdfView"));
+    settings.beginGroup(QStringLiteral("session"));
+    settings.setValue(QStringLiteral("file"), state.filePath);
+    settings.setValue(QStringLiteral("original"), state.originalPath);
+    settings.setValue(QStringLiteral("page"), state.page);
+    settings.setValue(QStringLiteral("zoomMode"), int(state.zoomMode));
+    settings.setValue(QStringLiteral("zoomFactor"), state.zoomFactor);
+    settings.setValue(QStringLiteral("scrollX"), state.horizontalScroll);
+    settings.setValue(QStringLiteral("scrollY"), state.verticalScroll);
+    settings.endGroup();
+}
+
+QString SessionStore::metadataPath(const QString& filePath) const
+{
+    const QByteArray key = QCryptographicHash::hash(filePath.toUtf8(), QCryptographicHash::Sha1).toHex();
+    return m_cacheDir + QLatin1Char('/') + QString::fromLatin1(key) + QStringLiteral(".meta");
+}
+
+std::optional<DocumentMetadata> SessionStore::loadMetadata(const QFileInfo& fi) const
+{
+    QFile file(metadataPath(fi.absoluteFilePath()));
+    if (!file.open(QIODevice::ReadOnly))
+        return std::nullopt;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_6_2);
+    quint32 magic = 0;
+    quint16 version = 0;
+    in >> magic >> version;
+    if (magic != kMetadataMagic || version != kMetadataVersion)
+        return std::nullopt;
+
+    DocumentMetadata meta;
+    QString storedPath;
+    in >> storedPath >> meta.fileSize >> meta.lastModified >> meta.pageSizes;
+    if (in.status() != QDataStream::Ok || storedPath != fi.absoluteFilePath())
+        return std::nullopt;
+    if (meta.fileSize != fi.size() || meta.lastModified != fi.lastModified())
+        return std::nullopt;
+    return meta;
+}
+
+void SessionStore::saveMetadata(const QString& filePath, const DocumentMetadata& metadata)
+{
+    if (!QDir().mkpath(m_cacheDir))
+        return;
+    QSaveFile file(metadataPath(filePath));
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_6_2);
+    out << kMetadataMagic << kMetadataVersion << filePath
+        << metadata.fileSize << metadata.lastModified << metadata.pageSizes;
+    if (out.status() == QDataStream::Ok)
+        file.commit();
+    else
+        file.cancelWriting();
+}
@@ -0,0 +1,98 @@
+/**
+ * @file SessionStore.h
+ * @brief Persists the viewing session and per-document metadata.
+ *
+ * SessionStore remembers which document was open and where the user was
+ * (page, zoom, scroll offset) so the next start can put them back. It also
+ * caches each document's page count and page-size table on disk, keyed by
+ * path and validated against file size and modification time, so the view
+ * and minimap can be laid out before pdfium has finished parsing.
+ *
+ * The session lives in QSettings; metadata files live in the cache
+ * directory as small versioned binary files.
+ *
+ * Usage:
+ * @code
+ *   SessionStore store;
+ *   SessionState state = store.loadSession();
+ *   if (auto meta = store.loadMetadata(QFileInfo(state.filePath)))
+ *       minimap->setPageHeights(meta->pageHeights());
+ * @endcode
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QPdfView>
+#include <QSizeF>
+#include <QString>
+#include <QVector>
+#include <optional>
+
+/**
+ * @struct SessionState
+ * @brief Document and viewport of the last session.
+ */
+struct SessionState {
+    QString filePath;
+    QString originalPath;
+    int page {0};
+    QPdfView::ZoomMode zoomMode {QPdfView::ZoomMode::FitToWidth};
+    qreal zoomFactor {1.0};
+    int horizontalScroll {0};
+    int verticalScroll {0};
+
+    bool isValid() const { return !filePath.isEmpty(); }
+};
+
+/**
+ * @struct DocumentMetadata
+ * @brief Precomputed layout information of a document.
+ */
+struct DocumentMetadata {
+    qint64 fileSize {0};
+    QDateTime lastModified;
+    QVector<QSizeF> pageSizes;   ///< Page sizes in points
+
+    int pageCount() const { return pageSizes.size(); }
+
+    /**
+     * @brief Page heights in points, clamped to at least 1.0 like the minimap expects.
+     */
+    QVector<qreal> pageHeights() const;
+};
+
+/**
+ * @class SessionStore
+ * @brief Loads and saves SessionState and DocumentMetadata.
+ */
+class SessionStore {
+public:
+    SessionStore();
+
+    /**
+     * @brief Returns the last saved session (invalid if none).
+     */
+    SessionState loadSession() const;
+
+    /**
+     * @brief Saves @p state as the current session.
+     */
+    void saveSession(const SessionState& state);
+
+    /**
+     * @brief Returns cached metadata for a file if it is still up to date.
+     */
+    std::optional<DocumentMetadata> loadMetadata(const QFileInfo& fi) const;
+
+    /**
+     * @brief Stores metadata for @p filePath.
+     */
+    void saveMetadata(const QString& filePath, const DocumentMetadata& metadata);
+
+private:
+    QString metadataPath(const QString& filePath) const;
+
+    QString m_cacheDir;
+};
@@ -0,0 +1,88 @@
+/**
+ * @file StartupTimeline.cpp
+ * @brief Implementation of the startup phase recorder.
+ */
+
+#include "StartupTimeline.h"
+
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <cstdio>
+
+namespace {
+struct TimelineState {
+    QElapsedTimer clock;
+    QVector<StartupTimeline::Phase> phases;
+    bool finished {false};
+    bool printEnabled {false};
+};
+
+TimelineState& state()
+{
+    static TimelineState s;
+    return s;
+}
+}
+
+void StartupTimeline::start()
+{
+    TimelineState& s = state();
+    if (s.clock.isValid())
+        return;
+    s.clock.start();
+    s.phases.reserve(16);
+}
+
+void StartupTimeline::mark(const char* phase)
+{
+    TimelineState& s = state();
+    if (s.finished)
+        return;
+    if (!s.clock.isValid())
+        s.clock.start();
+    s.phases.append({QString::fromLatin1(phase), s.clock.nsecsElapsed()});
+}
+
+void StartupTimeline::finish()
+{
+    TimelineState& s = state();
+    if (s.finished)
+        return;
+    mark("startup complete");
+    s.finished = true;
+    if (s.printEnabled) {
+        const QByteArray text = format().toLocal8Bit();
+        std::fwrite(text.constData(), 1, size_t(text.size()), stderr);
+        std::fflush(stderr);
+    }
+}
+
+void StartupTimeline::setPrintEnabled(bool enabled)
+{
+    state().printEnabled = enabled;
+}
+
+bool StartupTimeline::isFinished()
+{
+    return state().finished;
+}
+
+QVector<StartupTimeline::Phase> StartupTimeline::phases()
+{
+    return state().phases;
+}
+
+QString StartupTimeline::format()
+{
+    QString out;
+    QTextStream ts(&out);
+    ts << "Startup timeline (ms since start, delta)\n";
+    qint64 previous = 0;
+    for (const Phase& phase : state().phases) {
+        ts << qSetFieldWidth(9) << Qt::right << QString::number(double(phase.elapsedNs) / 1e6, 'f', 2)
+           << qSetFieldWidth(9) << QString::number(double(phase.elapsedNs - previous) / 1e6, 'f', 2)
+           << qSetFieldWidth(0) << "  " << phase.name << '\n';
+        previous = phase.elapsedNs;
+    }
+    return out;
+}
@@ -0,0 +1,76 @@
+/**
+ * @file StartupTimeline.h
+ * @brief Lightweight timeline of named startup phases.
+ *
+ * The viewer is launched from a file manager for every document, so cold
+ * start latency matters. StartupTimeline records a timestamp for each
+ * startup phase (relative to the first call to start()) and can print the
+ * timeline when the application is run with --startup-timeline.
+ *
+ * Recording a mark costs a clock read and a vector append; marks are only
+ * taken on the GUI thread during startup.
+ *
+ * Usage:
+ * @code
+ *   StartupTimeline::start();
+ *   ...
+ *   StartupTimeline::mark("QApplication");
+ *   ...
+ *   StartupTimeline::finish();  // prints if enabled
+ * @endcode
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+/**
+ * @class StartupTimeline
+ * @brief Process-wide recorder of startup phase timestamps.
+ */
+class StartupTimeline {
+public:
+    struct Phase {
+        QString name;
+        qint64 elapsedNs {0};   ///< Time since start()
+    };
+
+    /**
+     * @brief Starts the clock. Call first thing in main().
+     */
+    static void start();
+
+    /**
+     * @brief Records the end of a startup phase.
+     * @param phase Phase name (e.g. "MainWindow constructed")
+     */
+    static void mark(const char* phase);
+
+    /**
+     * @brief Marks startup as complete and prints the timeline if enabled.
+     *
+     * Later calls to mark() or finish() are ignored.
+     */
+    static void finish();
+
+    /**
+     * @brief Enables printing the timeline on finish().
+     */
+    static void setPrintEnabled(bool enabled);
+
+    /**
+     * @brief Returns true once finish() has been called.
+     */
+    static bool isFinished();
+
+    /**
+     * @brief Returns the recorded phases in order.
+     */
+    static QVector<Phase> phases();
+
+    /**
+     * @brief Formats the timeline as a human readable table.
+     */
+    static QString format();
+};
@@ -0,0 +1,121 @@
+/**
+ * @file TextExporter.h
+ * @brief Background export of a document's text to a UTF-8 file.
+ *
+ * TextExporter writes the text of every page of a PDF to a file, for
+ * indexing pipelines and the "Export Text" action. Pages are extracted in
+ * windows of kWindowPages; each window is encoded to UTF-8 and written in
+ * page order before the next one starts, so memory stays at one window of
+ * text however large the document is. Each page is followed by a form
+ * feed and a newline, the page separator pdftotext uses.
+ *
+ * The pages are extracted as DocumentPool jobs, in parallel on the pool's
+ * instances: in the viewer on its pool, so the viewer's document is not
+ * touched, and on the command line on a pool of its own. Like Save As,
+ * the destination is written through QSaveFile and only replaced once the
+ * export is complete.
+ *
+ * Usage:
+ * @code
+ *   auto* exporter = new TextExporter(this);
+ *   connect(exporter, &TextExporter::finished, this, [](const TextExporter::Result& r){ ... });
+ *   exporter->start(pool, doc->pageCount(), QStringLiteral("document.txt"));
+ *
+ *   // or synchronously, e.g. from the command line
+ *   TextExporter::Result r = TextExporter::exportText(pdfPath, textPath);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <atomic>
+#include <functional>
+
+#include "DocumentPool.h"
+
+class QThread;
+
+/**
+ * @class TextExporter
+ * @brief Exports one document's text at a time on a worker thread.
+ */
+class TextExporter : public QObject {
+    Q_OBJECT
+public:
+    static constexpr int kWindowPages = 64;   ///< Pages extracted before writing
+
+    /**
+     * @struct Result
+     * @brief Outcome of a finished export.
+     */
+    struct Result {
+        bool ok {false};
+        bool cancelled {false};
+        QString errorString;
+        int pages {0};            ///< Pages written
+        qint64 bytes {0};         ///< UTF-8 bytes written
+        qint64 elapsedMs {0};
+
+        /// Throughput in pages per second (0 if unknown)
+        double pagesPerSecond() const
+        {
+            return elapsedMs > 0 ? double(pages) * 1000.0 / double(elapsedMs) : 0.0;
+        }
+    };
+
+    explicit TextExporter(QObject* parent = nullptr);
+    ~TextExporter() override;
+
+    /**
+     * @brief Starts exporting the text of the file open in @p pool to @p destination.
+     * @param pageCount Pages of the document
+     * @return False if an export is already running or @p pool has no file open
+     */
+    bool start(DocumentPool* pool, int pageCount, const QString& destination);
+
+    /**
+     * @brief Requests cancellation; the destination is left untouched.
+     */
+    void cancel();
+
+    bool isRunning() const { return m_thread != nullptr; }
+
+    /**
+     * @brief Performs the export and waits for it.
+     *
+     * Pages are extracted on a DocumentPool opened for @p pdfPath and
+     * written on the calling thread.
+     * @param pdfPath Document to read
+     * @param destination Text file to write (replaced atomically)
+     * @param cancel Optional cancellation flag polled between windows
+     * @param onProgress Optional callback receiving (pagesWritten, pageCount)
+     */
+    static Result exportText(const QString& pdfPath, const QString& destination,
+                             const std::atomic_bool* cancel = nullptr,
+                             const std::function<void(int, int)>& onProgress = {});
+
+    /**
+     * @brief Exports @p pageCount pages extracted through @p forPages.
+     *
+     * exportText() without loading; the export ends as cancelled if
+     * @p forPages is.
+     */
+    static Result exportPages(int pageCount, const DocumentPool::PageRunner& forPages,
+                              const QString& destination, const std::atomic_bool* cancel = nullptr,
+                              const std::function<void(int, int)>& onProgress = {});
+
+signals:
+    /// Emitted after each written window of pages.
+    void progress(int pagesWritten, int pageCount);
+
+    /// Emitted once when the export ends (successfully or not).
+    void finished(const TextExporter::Result& result);
+
+private:
+    QThread* m_thread {nullptr};
+    std::atomic_bool m_cancel {false};
+};
+
+Q_DECLARE_METATYPE(TextExporter::Result)
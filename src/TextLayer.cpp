@@ -0,0 +1,475 @@
+/**
+ * @file TextLayer.cpp
+ * @brief Implementation of the text layer file and its loader.
+ */
+
+#include "TextLayer.h"
+#include "TextSearch.h"
+#include "Trace.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPdfDocument>
+#include <QPdfSelection>
+#include <QPolygonF>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QVector>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+struct TextLayer::Header {
+    char magic[4];
+    quint16 version;
+    quint16 reserved;
+    quint32 byteOrder;
+    quint32 pageCount;
+    quint32 textUnits;
+    quint32 wordCount;
+    quint64 pagesOffset;
+    quint64 textOffset;
+    quint64 boxesOffset;
+    quint64 wordsOffset;
+    quint64 fileSize;
+    quint32 checksum;          ///< CRC-32 of bytes [sizeof(Header), fileSize)
+    quint32 reserved2;
+    char fingerprint[20];
+    char padding[4];
+};
+
+struct TextLayer::PageEntry {
+    quint32 textStart;
+    quint32 textLength;
+    quint32 wordStart;
+    quint32 wordCount;
+};
+
+struct TextLayer::Box {
+    float x, y, width, height;
+};
+
+struct TextLayer::Word {
+    quint32 start;
+    quint32 length;
+};
+
+namespace {
+constexpr char kMagic[4] = {'Q', 'P', 'V', 'L'};
+constexpr quint16 kVersion = 1;
+constexpr quint32 kByteOrderMark = 0x01020304;
+constexpr qint64 kFingerprintSampleBytes = 1024 * 1024;
+constexpr int kWindowPages = 32;            ///< Pages extracted per round of pool jobs
+
+QString layersDir()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/layers");
+}
+
+quint64 align4(quint64 offset)
+{
+    return (offset + 3) & ~quint64(3);
+}
+
+const std::array<quint32, 256>& crcTable()
+{
+    static const std::array<quint32, 256> table = []{
+        std::array<quint32, 256> t {};
+        for (quint32 i = 0; i < 256; ++i) {
+            quint32 c = i;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[i] = c;
+        }
+        return t;
+    }();
+    return table;
+}
+
+/// Continues a CRC-32 (IEEE) over @p size bytes; start with 0
+quint32 crc32(quint32 crc, const uchar* data, qint64 size)
+{
+    const std::array<quint32, 256>& table = crcTable();
+    crc = ~crc;
+    for (qint64 i = 0; i < size; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+/**
+ * Passes the box of each of the @p length characters of @p text at
+ * @p start, which contain no spaces, to @p assign. pdfium is asked for the
+ * whole span: if it fits one rectangle, that is split evenly between the
+ * characters, which is what hit testing and selection need at a fraction
+ * of one query per character. Spans that break over lines or runs of
+ * different fonts fall back to one query per character.
+ */
+template <typename Assign>
+void spanBoxes(QPdfDocument& doc, int page, const QString& text, int start, int length,
+               const Assign& assign)
+{
+    const QList<QPolygonF> bounds = doc.getSelectionAtIndex(page, start, length).bounds();
+    if (bounds.size() == 1) {
+        int characters = 0;
+        for (int i = start; i < start + length; ++i)
+            characters += text.at(i).isLowSurrogate() ? 0 : 1;
+        const QRectF r = bounds.first().boundingRect();
+        const qreal width = r.width() / qMax(1, characters);
+        int n = 0;
+        for (int i = start; i < start + length; ++i) {
+            if (!text.at(i).isLowSurrogate())
+                assign(i, QRectF(r.x() + width * n++, r.y(), width, r.height()));
+        }
+        return;
+    }
+    if (bounds.isEmpty())
+        return;
+    for (int i = start; i < start + length; ++i) {
+        if (!text.at(i).isLowSurrogate())
+            assign(i, doc.getSelectionAtIndex(page, i, 1).boundingRectangle());
+    }
+}
+}
+
+TextLayer::~TextLayer()
+{
+    if (m_file && m_data)
+        m_file->unmap(const_cast<uchar*>(m_data));
+}
+
+QByteArray TextLayer::fingerprint(const QString& pdfPath)
+{
+    QFile file(pdfPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return {};
+    const qint64 size = file.size();
+    // The samples miss changes in the middle of the file; the time does not
+    const qint64 modified = QFileInfo(file).lastModified().toMSecsSinceEpoch();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(&size), sizeof(size)));
+    hash.addData(QByteArrayView(reinterpret_cast<const char*>(&modified), sizeof(modified)));
+    hash.addData(file.read(kFingerprintSampleBytes));
+    if (size > kFingerprintSampleBytes) {
+        // PDFs are updated by appending, so the tail carries most changes
+        file.seek(qMax(kFingerprintSampleBytes, size - kFingerprintSampleBytes));
+        hash.addData(file.read(kFingerprintSampleBytes));
+    }
+    return hash.result();
+}
+
+QString TextLayer::layerPath(const QByteArray& fingerprint)
+{
+    return layersDir() + QLatin1Char('/') + QString::fromLatin1(fingerprint.toHex()) + QStringLiteral(".layer");
+}
+
+void TextLayer::trimCache(qint64 budgetBytes)
+{
+    TRACE_SCOPE("TextLayer::trimCache");
+    // Newest first; the modification time is bumped by every open()
+    const QFileInfoList layers = QDir(layersDir()).entryInfoList({QStringLiteral("*.layer")},
+                                                                 QDir::Files, QDir::Time);
+    qint64 total = 0;
+    for (const QFileInfo& fi : layers) {
+        total += fi.size();
+        if (total > budgetBytes && QFile::remove(fi.absoluteFilePath()))
+            total -= fi.size();
+    }
+}
+
+std::shared_ptr<const TextLayer> TextLayer::open(const QString& path, const QByteArray& fingerprint)
+{
+    TRACE_SCOPE("TextLayer::open");
+    if (fingerprint.size() != int(sizeof(Header::fingerprint)))
+        return nullptr;
+    auto file = std::make_unique<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly))
+        return nullptr;
+    const qint64 size = file->size();
+    if (size < qint64(sizeof(Header)))
+        return nullptr;
+    uchar* data = file->map(0, size);
+    if (!data)
+        return nullptr;
+
+    std::shared_ptr<TextLayer> layer(new TextLayer);
+    layer->m_file = std::move(file);
+    layer->m_data = data;
+    layer->m_size = size;
+
+    const auto* h = reinterpret_cast<const Header*>(data);
+    const quint64 pagesEnd = h->pagesOffset + quint64(h->pageCount) * sizeof(PageEntry);
+    if (std::memcmp(h->magic, kMagic, sizeof(kMagic)) != 0 || h->version != kVersion
+        || h->byteOrder != kByteOrderMark || h->fileSize != quint64(size)
+        || h->pagesOffset != sizeof(Header) || h->textOffset != pagesEnd
+        || h->boxesOffset != align4(h->textOffset + quint64(h->textUnits) * sizeof(char16_t))
+        || h->wordsOffset != h->boxesOffset + quint64(h->textUnits) * sizeof(Box)
+        || h->fileSize != h->wordsOffset + quint64(h->wordCount) * sizeof(Word)
+        || std::memcmp(h->fingerprint, fingerprint.constData(), sizeof(h->fingerprint)) != 0)
+        return nullptr;
+
+    layer->m_header = h;
+    layer->m_pages = reinterpret_cast<const PageEntry*>(data + h->pagesOffset);
+    layer->m_text = reinterpret_cast<const char16_t*>(data + h->textOffset);
+    layer->m_boxes = reinterpret_cast<const Box*>(data + h->boxesOffset);
+    layer->m_words = reinterpret_cast<const Word*>(data + h->wordsOffset);
+    for (quint32 p = 0; p < h->pageCount; ++p) {
+        const PageEntry& e = layer->m_pages[p];
+        if (quint64(e.textStart) + e.textLength > h->textUnits
+            || quint64(e.wordStart) + e.wordCount > h->wordCount)
+            return nullptr;
+    }
+    layer->m_file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+    return layer;
+}
+
+bool TextLayer::verify() const
+{
+    TRACE_SCOPE("TextLayer::verify");
+    return crc32(0, m_data + sizeof(Header), m_size - qint64(sizeof(Header))) == m_header->checksum;
+}
+
+bool TextLayer::build(int pageCount, const DocumentPool::PageRunner& forPages,
+                      const QByteArray& fingerprint, const QString& path)
+{
+    TRACE_SCOPE("TextLayer::build");
+    if (fingerprint.size() != int(sizeof(Header::fingerprint)))
+        return false;
+
+    // Pass 1: text and words, which fix the size of every section
+    std::vector<QString> texts(pageCount);
+    for (int first = 0; first < pageCount; first += kWindowPages) {
+        const bool done = forPages(first, qMin(kWindowPages, pageCount - first), [&texts](int p, QPdfDocument& doc){
+            texts[p] = doc.getAllText(p).text();
+        });
+        if (!done)
+            return false;
+    }
+    QVector<PageEntry> pages(pageCount);
+    QVector<Word> words;
+    quint32 textUnits = 0;
+    for (int p = 0; p < pageCount; ++p) {
+        const QString& text = texts[p];
+        PageEntry& e = pages[p];
+        e.textStart = textUnits;
+        e.textLength = quint32(text.size());
+        e.wordStart = quint32(words.size());
+        for (int i = 0; i < text.size();) {
+            if (!TextMatcher::isWordCharacter(text.at(i))) {
+                ++i;
+                continue;
+            }
+            const int start = i;
+            while (i < text.size() && TextMatcher::isWordCharacter(text.at(i)))
+                ++i;
+            words.append({quint32(start), quint32(i - start)});
+        }
+        e.wordCount = quint32(words.size()) - e.wordStart;
+        textUnits += e.textLength;
+    }
+
+    Header h {};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion;
+    h.byteOrder = kByteOrderMark;
+    h.pageCount = quint32(pageCount);
+    h.textUnits = textUnits;
+    h.wordCount = quint32(words.size());
+    h.pagesOffset = sizeof(Header);
+    h.textOffset = h.pagesOffset + quint64(pageCount) * sizeof(PageEntry);
+    h.boxesOffset = align4(h.textOffset + quint64(textUnits) * sizeof(char16_t));
+    h.wordsOffset = h.boxesOffset + quint64(textUnits) * sizeof(Box);
+    h.fileSize = h.wordsOffset + quint64(words.size()) * sizeof(Word);
+    std::memcpy(h.fingerprint, fingerprint.constData(), sizeof(h.fingerprint));
+
+    if (!QDir().mkpath(QFileInfo(path).absolutePath()))
+        return false;
+    QSaveFile out(path);
+    if (!out.open(QIODevice::WriteOnly))
+        return false;
+    quint32 crc = 0;
+    bool ok = out.write(reinterpret_cast<const char*>(&h), sizeof(h)) == qint64(sizeof(h));
+    auto write = [&out, &crc, &ok](const void* data, qint64 size){
+        if (!ok || size <= 0)
+            return;
+        crc = crc32(crc, static_cast<const uchar*>(data), size);
+        ok = out.write(static_cast<const char*>(data), size) == size;
+    };
+
+    write(pages.constData(), qint64(pages.size()) * qint64(sizeof(PageEntry)));
+    for (const QString& text : texts)
+        write(text.utf16(), qint64(text.size()) * qint64(sizeof(char16_t)));
+    const quint64 padding = h.boxesOffset - (h.textOffset + quint64(textUnits) * sizeof(char16_t));
+    const char zeros[4] = {};
+    write(zeros, qint64(padding));
+
+    // Pass 2: one box per code unit; spaces get none. Extracted a window
+    // of pages at a time and written in page order.
+    std::vector<QVector<Box>> boxes;
+    for (int first = 0; first < pageCount && ok; first += kWindowPages) {
+        const int count = qMin(kWindowPages, pageCount - first);
+        boxes.assign(count, {});
+        const bool done = forPages(first, count, [&texts, &boxes, first](int p, QPdfDocument& doc){
+            const QString& text = texts[p];
+            QVector<Box>& pageBoxes = boxes[p - first];
+            pageBoxes.fill(Box {0, 0, 0, 0}, text.size());
+            for (int i = 0; i < text.size();) {
+                if (text.at(i).isSpace()) {
+                    ++i;
+                    continue;
+                }
+                const int start = i;
+                while (i < text.size() && !text.at(i).isSpace())
+                    ++i;
+                spanBoxes(doc, p, text, start, i - start, [&pageBoxes](int c, const QRectF& r){
+                    pageBoxes[c] = {float(r.x()), float(r.y()), float(r.width()), float(r.height())};
+                });
+            }
+        });
+        if (!done) {
+            out.cancelWriting();
+            return false;
+        }
+        for (const QVector<Box>& pageBoxes : boxes)
+            write(pageBoxes.constData(), qint64(pageBoxes.size()) * qint64(sizeof(Box)));
+    }
+    write(words.constData(), qint64(words.size()) * qint64(sizeof(Word)));
+
+    h.checksum = crc;
+    if (!ok || !out.seek(0) || out.write(reinterpret_cast<const char*>(&h), sizeof(h)) != qint64(sizeof(h))) {
+        out.cancelWriting();
+        return false;
+    }
+    return out.commit();
+}
+
+int TextLayer::pageCount() const
+{
+    return int(m_header->pageCount);
+}
+
+const TextLayer::PageEntry* TextLayer::page(int page) const
+{
+    if (page < 0 || quint32(page) >= m_header->pageCount)
+        return nullptr;
+    return m_pages + page;
+}
+
+QStringView TextLayer::pageText(int p) const
+{
+    const PageEntry* e = page(p);
+    if (!e)
+        return {};
+    return QStringView(m_text + e->textStart, qsizetype(e->textLength));
+}
+
+QRectF TextLayer::charBox(int p, int index) const
+{
+    const PageEntry* e = page(p);
+    if (!e || index < 0 || quint32(index) >= e->textLength)
+        return {};
+    const Box& b = m_boxes[e->textStart + quint32(index)];
+    return QRectF(b.x, b.y, b.width, b.height);
+}
+
+int TextLayer::charIndexAt(int p, const QPointF& point, qreal tolerance) const
+{
+    const PageEntry* e = page(p);
+    if (!e)
+        return -1;
+    int nearest = -1;
+    qreal nearestDistance = tolerance;
+    const Box* boxes = m_boxes + e->textStart;
+    for (quint32 i = 0; i < e->textLength; ++i) {
+        const Box& b = boxes[i];
+        if (b.width <= 0 || b.height <= 0)
+            continue;
+        const qreal dx = qMax<qreal>(0.0, qMax(b.x - point.x(), point.x() - (b.x + b.width)));
+        const qreal dy = qMax<qreal>(0.0, qMax(b.y - point.y(), point.y() - (b.y + b.height)));
+        if (dx == 0.0 && dy == 0.0)
+            return int(i);
+        const qreal distance = std::hypot(dx, dy);
+        if (distance <= nearestDistance) {
+            nearestDistance = distance;
+            nearest = int(i);
+        }
+    }
+    return nearest;
+}
+
+std::pair<int, int> TextLayer::wordAt(int p, int index) const
+{
+    const PageEntry* e = page(p);
+    if (!e || index < 0)
+        return {-1, 0};
+    const Word* first = m_words + e->wordStart;
+    const Word* last = first + e->wordCount;
+    // Last word starting at or before index
+    const Word* it = std::upper_bound(first, last, quint32(index),
+                                      [](quint32 i, const Word& w){ return i < w.start; });
+    if (it == first)
+        return {-1, 0};
+    --it;
+    if (quint32(index) >= it->start + it->length || it->start + it->length > e->textLength)
+        return {-1, 0};
+    return {int(it->start), int(it->length)};
+}
+
+TextLayerLoader::TextLayerLoader(QObject* parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(1);
+    m_pool.setThreadPriority(QThread::LowPriority);
+}
+
+TextLayerLoader::~TextLayerLoader()
+{
+    cancel();
+    m_pool.waitForDone();
+}
+
+void TextLayerLoader::cancel()
+{
+    ++m_generation;
+}
+
+void TextLayerLoader::request(const QString& pdfPath, DocumentPool* pool, int pageCount)
+{
+    const quint64 generation = ++m_generation;
+    // Taken here, on the pool's thread; a build stops once the pool moved on
+    const bool canBuild = pool && pool->filePath() == pdfPath && pageCount > 0;
+    const quint64 session = canBuild ? pool->session() : 0;
+    QtConcurrent::run(&m_pool, [this, pdfPath, pool, canBuild, session, pageCount, generation]{
+        auto cancelled = [this, generation]{ return m_generation.load() != generation; };
+        if (cancelled())
+            return;
+        const QByteArray fp = TextLayer::fingerprint(pdfPath);
+        if (fp.isEmpty())
+            return;
+        const QString path = TextLayer::layerPath(fp);
+        TextLayerPtr layer = TextLayer::open(path, fp);
+        if (!layer) {
+            if (!canBuild)
+                return;
+            const DocumentPool::PageRunner forPages =
+                pool->pageRunner(session, DocumentPool::Priority::Low, cancelled);
+            if (!TextLayer::build(pageCount, forPages, fp, path))
+                return;
+            // A short or damaged write is caught here, not on every open
+            layer = TextLayer::open(path, fp);
+            if (layer && !layer->verify()) {
+                layer.reset();
+                QFile::remove(path);
+            }
+            TextLayer::trimCache();
+        }
+        if (layer && !cancelled())
+            emit ready(pdfPath, layer);
+    });
+}
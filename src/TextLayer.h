@@ -0,0 +1,189 @@
+/**
+ * @file TextLayer.h
+ * @brief Memory-mapped on-disk text layer of a document.
+ *
+ * Search, double-click word selection and the hover cursor all need the
+ * page text and where each character sits; asking pdfium for them page by
+ * page is what makes the first search and the first hover of a document
+ * slow. A TextLayer holds, for every page, the text (UTF-16), one bounding
+ * box per character (page points) and the word boundaries (same rule as
+ * TextMatcher::isWordCharacter). It is built once in the background and
+ * stored in the cache directory; reopening the document maps the file and
+ * uses it in place, with no parsing.
+ *
+ * File layout (native byte order, every section 4-byte aligned):
+ * @code
+ *   Header      magic "QPVL", version, byte order mark, page count,
+ *               section offsets, CRC-32 of everything after the header,
+ *               20-byte document fingerprint
+ *   Pages       per page: first character, length, first word, word count
+ *   Text        UTF-16 code units of all pages
+ *   Boxes       4 floats (x, y, width, height) per code unit
+ *   Words       2 quint32 (start, length) per word, relative to the page
+ * @endcode
+ *
+ * Files are named by the document fingerprint (SHA-1 of the file size,
+ * modification time and first and last MiB), so a renamed or moved
+ * document reuses its layer and a rewritten one gets a new one, also when
+ * only the middle of the file changed. A file whose contents are replaced
+ * with its size and modification time kept reuses the stale layer. A file whose version, byte
+ * order or sizes do not match is ignored and rebuilt. Opening only checks
+ * the header and the page table, so it costs the same for any file size;
+ * the checksum is verified once, right after a build.
+ *
+ * The layers directory is kept under kCacheBudgetBytes: opening a layer
+ * marks it as used, and trimCache() removes the least recently used layers
+ * once a build pushed the directory over the budget. FolderSearch builds
+ * and reads the same layers, so a searched folder opens fast and vice versa.
+ *
+ * TextLayerLoader finds or builds the layer of a document on a worker
+ * thread; a build extracts the pages as low-priority DocumentPool jobs.
+ * The layer itself is immutable and shared between threads.
+ *
+ * Usage:
+ * @code
+ *   connect(loader, &TextLayerLoader::ready, this, [this](const QString& path, TextLayerPtr layer){
+ *       view->setTextLayer(layer);
+ *   });
+ *   loader->request(filePath, pool, pageCount);    // pool has filePath open
+ * @endcode
+ */
+
+#pragma once
+
+#include <QByteArray>
+#include <QMetaType>
+#include <QObject>
+#include <QPointF>
+#include <QRectF>
+#include <QString>
+#include <QStringView>
+#include <QThreadPool>
+#include <atomic>
+#include <memory>
+
+#include "DocumentPool.h"
+
+class QFile;
+class QPdfDocument;
+
+/**
+ * @class TextLayer
+ * @brief Read-only view of a mapped text layer file.
+ */
+class TextLayer {
+public:
+    static constexpr qint64 kCacheBudgetBytes = 512ll * 1024 * 1024;  ///< All layers on disk
+
+    ~TextLayer();
+    TextLayer(const TextLayer&) = delete;
+    TextLayer& operator=(const TextLayer&) = delete;
+
+    /// Fingerprint of a PDF file; empty if it cannot be read
+    static QByteArray fingerprint(const QString& pdfPath);
+
+    /// Cache file of the layer with @p fingerprint
+    static QString layerPath(const QByteArray& fingerprint);
+
+    /**
+     * @brief Removes least recently used layers until all fit @p budgetBytes.
+     *
+     * Layers that are mapped stay usable; their files are gone once unmapped.
+     */
+    static void trimCache(qint64 budgetBytes = kCacheBudgetBytes);
+
+    /**
+     * @brief Maps @p path; null if missing, damaged or for another fingerprint.
+     *
+     * Marks the layer as recently used for trimCache().
+     */
+    static std::shared_ptr<const TextLayer> open(const QString& path, const QByteArray& fingerprint);
+
+    /// Whether the mapped file matches its checksum; reads the whole file
+    bool verify() const;
+
+    /**
+     * @brief Extracts the layer of a document and writes it to @p path.
+     * @param pageCount Pages of the document
+     * @param forPages Runs the extraction of pages; the file is not written if it is cancelled
+     */
+    static bool build(int pageCount, const DocumentPool::PageRunner& forPages,
+                      const QByteArray& fingerprint, const QString& path);
+
+    int pageCount() const;
+
+    /// Text of @p page; empty if out of range
+    QStringView pageText(int page) const;
+
+    /// Bounding box of character @p index of @p page in page points (empty for spaces)
+    QRectF charBox(int page, int index) const;
+
+    /**
+     * @brief Character of @p page under @p point (page points), or -1.
+     *
+     * If no box contains the point, the nearest box within @p tolerance
+     * points is taken.
+     */
+    int charIndexAt(int page, const QPointF& point, qreal tolerance) const;
+
+    /**
+     * @brief Word containing character @p index of @p page.
+     * @return {start, length}, or {-1, 0} if the character is not part of a word
+     */
+    std::pair<int, int> wordAt(int page, int index) const;
+
+    /// Size of the mapping
+    qint64 byteSize() const { return m_size; }
+
+private:
+    struct Header;
+    struct PageEntry;
+    struct Box;
+    struct Word;
+
+    TextLayer() = default;
+
+    const PageEntry* page(int page) const;
+
+    std::unique_ptr<QFile> m_file;
+    const uchar* m_data {nullptr};
+    qint64 m_size {0};
+    const Header* m_header {nullptr};
+    const PageEntry* m_pages {nullptr};
+    const char16_t* m_text {nullptr};
+    const Box* m_boxes {nullptr};
+    const Word* m_words {nullptr};
+};
+
+using TextLayerPtr = std::shared_ptr<const TextLayer>;
+Q_DECLARE_METATYPE(TextLayerPtr)
+
+/**
+ * @class TextLayerLoader
+ * @brief Opens or builds the text layer of a document on a worker thread.
+ */
+class TextLayerLoader : public QObject {
+    Q_OBJECT
+public:
+    explicit TextLayerLoader(QObject* parent = nullptr);
+    ~TextLayerLoader() override;
+
+    /**
+     * @brief Starts loading the layer of @p pdfPath, cancelling the previous request.
+     *
+     * Maps an existing layer, or builds one from the @p pageCount pages of
+     * @p pool, which must have @p pdfPath open.
+     */
+    void request(const QString& pdfPath, DocumentPool* pool, int pageCount);
+
+    /// Cancels the running request; ready() is not emitted for it.
+    void cancel();
+
+signals:
+    /// The layer of @p pdfPath is available. Emitted from a worker thread.
+    void ready(const QString& pdfPath, TextLayerPtr layer);
+
+private:
+    QThreadPool m_pool;                     ///< One thread, low priority
+    std::atomic<quint64> m_generation {0};
+};
@@ -0,0 +1,285 @@
+/**
+ * @file TextSearch.cpp
+ * @brief Implementation of the text matcher.
+ */
+
+#include "TextSearch.h"
+
+#include <QtConcurrent/QtConcurrentMap>
+
+#include <algorithm>
+
+namespace {
+constexpr char16_t kSoftHyphen = 0x00AD;
+constexpr char16_t kLatinTableEnd = 0x0250;   ///< Latin-1 Supplement up to Latin Extended-B
+
+bool isHyphen(QChar ch)
+{
+    return ch == QLatin1Char('-') || ch.unicode() == 0x2010;
+}
+
+bool isLineBreak(QChar ch)
+{
+    return ch == QLatin1Char('\n') || ch == QLatin1Char('\r') || ch.unicode() == 0x2028;
+}
+
+QString foldUnit(QStringView unit)
+{
+    // Turkish dotted capital and dotless small i; NFKD turns İ into I + U+0307
+    // but leaves ı alone, and case folding alone maps neither to 'i'
+    if (unit.size() == 1 && (unit.at(0).unicode() == 0x0130 || unit.at(0).unicode() == 0x0131))
+        return QStringLiteral("i");
+    const QString decomposed = unit.toString().normalized(QString::NormalizationForm_KD);
+    QString out;
+    out.reserve(decomposed.size());
+    for (QChar ch : decomposed) {
+        if (ch.category() != QChar::Mark_NonSpacing)
+            out.append(ch);
+    }
+    return out.toCaseFolded();
+}
+
+/// Folded form of one UTF-16 unit; the common Latin range is tabulated
+QString foldCharacter(QStringView unit)
+{
+    static const QVector<QString> latin = []{
+        QVector<QString> table(kLatinTableEnd);
+        for (char16_t c = 0; c < kLatinTableEnd; ++c) {
+            const QChar ch(c);
+            table[c] = foldUnit(QStringView(&ch, 1));
+        }
+        return table;
+    }();
+    if (unit.size() == 1 && unit.at(0).unicode() < kLatinTableEnd)
+        return latin.at(unit.at(0).unicode());
+    return foldUnit(unit);
+}
+}
+
+FoldedText FoldedText::fold(const QString& original)
+{
+    FoldedText out;
+    out.m_original = original;
+    QString& folded = out.m_folded;
+    folded.reserve(original.size());
+
+    // Appends a folded character produced by original index @p source
+    auto append = [&out, &folded](QChar ch, int source) {
+        const int index = int(folded.size());
+        if (out.m_anchors.isEmpty()
+            || out.m_anchors.last().original + (index - out.m_anchors.last().folded) != source)
+            out.m_anchors.append({index, source});
+        folded.append(ch);
+    };
+
+    const int n = int(original.size());
+    int pendingSpace = -1;   // original index of a whitespace run not yet emitted
+    for (int i = 0; i < n;) {
+        const QChar ch = original.at(i);
+
+        // "exam-\r\nple" -> "example": skip hyphen, line break and indentation
+        if (isHyphen(ch) && i > 0 && original.at(i - 1).isLetter()) {
+            int j = i + 1;
+            while (j < n && (original.at(j) == QLatin1Char(' ') || original.at(j) == QLatin1Char('\t')))
+                ++j;
+            if (j < n && isLineBreak(original.at(j))) {
+                while (j < n && original.at(j).isSpace())
+                    ++j;
+                if (j < n && original.at(j).isLetter()) {
+                    i = j;
+                    continue;
+                }
+            }
+        }
+        if (ch.unicode() == kSoftHyphen) {
+            ++i;
+            continue;
+        }
+        if (ch.isSpace()) {
+            if (pendingSpace < 0)
+                pendingSpace = i;
+            ++i;
+            continue;
+        }
+        if (pendingSpace >= 0) {
+            if (!folded.isEmpty())
+                append(QLatin1Char(' '), pendingSpace);
+            pendingSpace = -1;
+        }
+
+        if (ch.unicode() < 0x80) {
+            append(ch.toLower(), i);
+            ++i;
+            continue;
+        }
+        const int unitLength = (ch.isHighSurrogate() && i + 1 < n && original.at(i + 1).isLowSurrogate()) ? 2 : 1;
+        const QString f = foldCharacter(QStringView(original).mid(i, unitLength));
+        for (int k = 0; k < int(f.size()); ++k)
+            append(f.at(k), i + qMin(k, unitLength - 1));
+        i += unitLength;
+    }
+    folded.squeeze();
+    out.m_anchors.squeeze();
+    return out;
+}
+
+QString FoldedText::foldQuery(const QString& query)
+{
+    return fold(query).m_folded;
+}
+
+QString FoldedText::foldPattern(const QString& pattern)
+{
+    QString out;
+    out.reserve(pattern.size());
+    const int n = int(pattern.size());
+    for (int i = 0; i < n;) {
+        const QChar ch = pattern.at(i);
+        if (ch.unicode() < 0x80) {
+            out.append(ch);
+            ++i;
+            continue;
+        }
+        const int unitLength = (ch.isHighSurrogate() && i + 1 < n && pattern.at(i + 1).isLowSurrogate()) ? 2 : 1;
+        out.append(foldCharacter(QStringView(pattern).mid(i, unitLength)));
+        i += unitLength;
+    }
+    return out;
+}
+
+int FoldedText::originalIndex(int foldedIndex) const
+{
+    if (m_anchors.isEmpty())
+        return foldedIndex;
+    auto it = std::upper_bound(m_anchors.cbegin(), m_anchors.cend(), foldedIndex,
+                               [](int index, const Anchor& a){ return index < a.folded; });
+    if (it != m_anchors.cbegin())
+        --it;
+    return it->original + (foldedIndex - it->folded);
+}
+
+TextMatch FoldedText::toOriginal(const TextMatch& folded) const
+{
+    if (folded.length <= 0)
+        return {originalIndex(folded.start), 0};
+    const int start = originalIndex(folded.start);
+    int end = originalIndex(folded.start + folded.length - 1) + 1;
+    while (end < m_original.size() && m_original.at(end).category() == QChar::Mark_NonSpacing)
+        ++end;
+    return {start, end - start};
+}
+
+qint64 FoldedText::byteSize() const
+{
+    return qint64(m_original.size() + m_folded.size()) * qint64(sizeof(QChar))
+        + qint64(m_anchors.size()) * qint64(sizeof(Anchor));
+}
+
+TextMatcher::TextMatcher(const QString& query, Options options)
+    : m_query(query)
+    , m_options(options)
+{
+    const bool fold = !(m_options & CaseSensitive);
+    if (m_options & Regex) {
+        QRegularExpression::PatternOptions patternOptions = QRegularExpression::UseUnicodePropertiesOption;
+        if (fold)
+            patternOptions |= QRegularExpression::CaseInsensitiveOption;
+        m_pattern = fold ? FoldedText::foldPattern(query) : query;
+        m_regex = QRegularExpression(m_pattern, patternOptions);
+        // Compile (and JIT) now instead of lazily on the first worker thread
+        m_regex.optimize();
+    } else {
+        m_pattern = fold ? FoldedText::foldQuery(query) : query;
+    }
+}
+
+bool TextMatcher::isValid() const
+{
+    if (m_pattern.isEmpty())
+        return false;
+    return !(m_options & Regex) || m_regex.isValid();
+}
+
+QString TextMatcher::errorString() const
+{
+    return (m_options & Regex) && !m_regex.isValid() ? m_regex.errorString() : QString();
+}
+
+bool TextMatcher::isWordCharacter(QChar ch)
+{
+    if (ch.isLetterOrNumber())
+        return true;
+    if (ch.category() == QChar::Punctuation_Connector)
+        return true;
+    return ch == QLatin1Char('_') || ch == QLatin1Char('-');
+}
+
+bool TextMatcher::isWholeWordAt(const QString& text, int start, int length) const
+{
+    if (start > 0 && isWordCharacter(text.at(start - 1)) && isWordCharacter(text.at(start)))
+        return false;
+    const int end = start + length;
+    if (end < text.size() && isWordCharacter(text.at(end)) && isWordCharacter(text.at(end - 1)))
+        return false;
+    return true;
+}
+
+QVector<TextMatch> TextMatcher::findAll(const QString& text) const
+{
+    return match(text, (m_options & CaseSensitive) ? Qt::CaseSensitive : Qt::CaseInsensitive);
+}
+
+QVector<TextMatch> TextMatcher::match(const QString& text, Qt::CaseSensitivity cs) const
+{
+    QVector<TextMatch> matches;
+    if (!isValid() || text.isEmpty())
+        return matches;
+
+    const bool wholeWord = m_options & WholeWord;
+    if (m_options & Regex) {
+        QRegularExpressionMatchIterator it = m_regex.globalMatch(text);
+        while (it.hasNext()) {
+            const QRegularExpressionMatch m = it.next();
+            const int start = int(m.capturedStart());
+            const int length = int(m.capturedLength());
+            if (length <= 0)
+                continue;
+            if (wholeWord && !isWholeWordAt(text, start, length))
+                continue;
+            matches.append({start, length});
+        }
+        return matches;
+    }
+
+    const int length = int(m_pattern.size());
+    int pos = 0;
+    while ((pos = int(text.indexOf(m_pattern, pos, cs))) >= 0) {
+        if (!wholeWord || isWholeWordAt(text, pos, length)) {
+            matches.append({pos, length});
+            pos += length;
+        } else {
+            ++pos;
+        }
+    }
+    return matches;
+}
+
+QVector<TextMatch> TextMatcher::findAll(const FoldedText& text) const
+{
+    if (m_options & CaseSensitive)
+        return findAll(text.original());
+    // Query and text are both folded already: compare exactly
+    QVector<TextMatch> matches = match(text.folded(), Qt::CaseSensitive);
+    for (TextMatch& match : matches)
+        match = text.toOriginal(match);
+    return matches;
+}
+
+QVector<QVector<TextMatch>> TextMatcher::findInPages(const TextMatcher& matcher,
+                                                    const QVector<FoldedText>& pages)
+{
+    if (!matcher.isValid())
+        return QVector<QVector<TextMatch>>(pages.size());
+    return QtConcurrent::blockingMapped<QVector<QVector<TextMatch>>>(
+        pages, [&matcher](const FoldedText& text){ return matcher.findAll(text); });
+}
@@ -0,0 +1,178 @@
+/**
+ * @file TextSearch.h
+ * @brief Plain, whole-word and regular expression matching over page text.
+ *
+ * FoldedText is the search form of a page: case-folded, with diacritics
+ * removed, ligatures and compatibility characters expanded (NFKD), Turkish
+ * dotted and dotless I folded to 'i', soft hyphens dropped, words
+ * hyphenated across a line break joined and whitespace runs collapsed to
+ * one space. It is built once per page and keeps a compact map from folded
+ * to original character indices, so matches can be passed straight to
+ * QPdfDocument::getSelectionAtIndex().
+ *
+ * TextMatcher compiles a query once (regular expressions are optimized up
+ * front, which uses PCRE2's JIT where available) and can then be used from
+ * several threads at once. findInPages() runs a matcher over the text of
+ * many pages in parallel; the text itself must be extracted beforehand on
+ * the thread that owns the QPdfDocument, since pdfium is not thread-safe.
+ *
+ * Word boundaries follow the same rule as double-click word selection in
+ * SelectablePdfView (letters, digits, connector punctuation, '_' and '-').
+ *
+ * Usage:
+ * @code
+ *   TextMatcher matcher(QStringLiteral("\\d{4}-\\d{2}-\\d{2}"), TextMatcher::Regex);
+ *   if (!matcher.isValid())
+ *       qWarning() << matcher.errorString();
+ *   QVector<FoldedText> pages;                       // FoldedText::fold(page text)
+ *   QVector<QVector<TextMatch>> hits = TextMatcher::findInPages(matcher, pages);
+ * @endcode
+ */
+
+#pragma once
+
+#include <QChar>
+#include <QRegularExpression>
+#include <QString>
+#include <QVector>
+
+/**
+ * @struct TextMatch
+ * @brief A match as a character range of the page text.
+ */
+struct TextMatch {
+    int start {0};
+    int length {0};
+};
+
+/**
+ * @class FoldedText
+ * @brief Normalized search text of a page with a map back to the original.
+ *
+ * The map stores one anchor per position where folded and original indices
+ * stop advancing in step (dropped or expanded characters), so plain ASCII
+ * text needs a single anchor.
+ */
+class FoldedText {
+public:
+    FoldedText() = default;
+
+    /**
+     * @brief Folds @p original into its search form.
+     */
+    static FoldedText fold(const QString& original);
+
+    /**
+     * @brief Folds a plain search query the same way as page text.
+     */
+    static QString foldQuery(const QString& query);
+
+    /**
+     * @brief Folds the non-ASCII characters of a regular expression.
+     *
+     * ASCII is left alone so escapes and classes keep their meaning; ASCII
+     * letters are matched case-insensitively instead.
+     */
+    static QString foldPattern(const QString& pattern);
+
+    const QString& original() const { return m_original; }
+    const QString& folded() const { return m_folded; }
+
+    /// Original index of the folded character at @p foldedIndex
+    int originalIndex(int foldedIndex) const;
+
+    /**
+     * @brief Maps a match in folded() to the original character range.
+     *
+     * The range covers characters dropped inside the match (soft hyphens,
+     * line breaks) and combining marks following its last character.
+     */
+    TextMatch toOriginal(const TextMatch& folded) const;
+
+    /// Estimated bytes held (both texts plus the index map)
+    qint64 byteSize() const;
+
+private:
+    struct Anchor {
+        int folded;
+        int original;
+    };
+
+    QString m_original;
+    QString m_folded;
+    QVector<Anchor> m_anchors;   ///< Sorted by folded index
+};
+
+/**
+ * @class TextMatcher
+ * @brief Compiled search query.
+ */
+class TextMatcher {
+public:
+    /**
+     * @brief Matching options; can be combined.
+     */
+    enum Option {
+        NoOptions = 0x0,
+        WholeWord = 0x1,        ///< Match must not touch word characters on either side
+        Regex = 0x2,            ///< Query is a regular expression
+        CaseSensitive = 0x4
+    };
+    Q_DECLARE_FLAGS(Options, Option)
+
+    TextMatcher() = default;
+
+    /**
+     * @brief Compiles @p query with @p options.
+     *
+     * Unless CaseSensitive is set the query is folded like FoldedText and
+     * matched against FoldedText::folded().
+     */
+    explicit TextMatcher(const QString& query, Options options = NoOptions);
+
+    /// False for an empty query or an invalid regular expression
+    bool isValid() const;
+    /// Regular expression error, empty if the query is valid
+    QString errorString() const;
+
+    QString query() const { return m_query; }
+    Options options() const { return m_options; }
+
+    /**
+     * @brief Returns all non-overlapping matches in @p text, in order.
+     *
+     * @p text is matched as given; indices refer to it. Safe to call from
+     * several threads at once.
+     */
+    QVector<TextMatch> findAll(const QString& text) const;
+
+    /**
+     * @brief Returns all matches in @p text as original character ranges.
+     *
+     * Searches the folded text, or the original text if CaseSensitive is set.
+     */
+    QVector<TextMatch> findAll(const FoldedText& text) const;
+
+    /**
+     * @brief Matches every page in parallel.
+     * @return One match list per entry of @p pages, in original indices
+     */
+    static QVector<QVector<TextMatch>> findInPages(const TextMatcher& matcher,
+                                                   const QVector<FoldedText>& pages);
+
+    /**
+     * @brief Word character rule shared with word selection.
+     */
+    static bool isWordCharacter(QChar ch);
+
+private:
+    QVector<TextMatch> match(const QString& text, Qt::CaseSensitivity cs) const;
+    bool isWholeWordAt(const QString& text, int start, int length) const;
+
+    QString m_query;
+    QString m_pattern;           ///< Query in the form it is matched in
+    Options m_options {NoOptions};
+    QRegularExpression m_regex;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(TextMatcher::Options)
@@ -0,0 +1,164 @@
+/**
+ * @file Trace.cpp
+ * @brief Implementation of the trace-event recorder.
+ */
+
+#include "Trace.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+
+std::atomic_bool Trace::s_enabled {false};
+
+namespace {
+struct TraceEvent {
+    const char* name;
+    qint64 startNs;
+    qint64 durationNs;
+    int tid;
+};
+
+struct TraceThread {
+    int tid;
+    QString name;
+};
+
+struct TraceState {
+    QMutex mutex;
+    QElapsedTimer clock;
+    QString filePath;
+    QVector<TraceEvent> events;
+    QVector<TraceThread> threads;
+    std::atomic_int nextTid {1};
+    bool dropped {false};
+};
+
+TraceState& state()
+{
+    static TraceState s;
+    return s;
+}
+
+/// Small sequential id of the calling thread; its name is captured on first use.
+int currentTid()
+{
+    thread_local int tid = 0;
+    if (tid == 0) {
+        TraceState& s = state();
+        tid = s.nextTid.fetch_add(1);
+        QString name;
+        if (QThread* thread = QThread::currentThread()) {
+            name = thread->objectName();
+            if (name.isEmpty() && QCoreApplication::instance()
+                && thread == QCoreApplication::instance()->thread())
+                name = QStringLiteral("GUI");
+        }
+        if (name.isEmpty())
+            name = QStringLiteral("Thread %1").arg(tid);
+        QMutexLocker lock(&s.mutex);
+        s.threads.append({tid, name});
+    }
+    return tid;
+}
+
+QByteArray jsonString(const QString& text)
+{
+    QByteArray out;
+    out.reserve(text.size() + 2);
+    out.append('"');
+    for (const char c : text.toUtf8()) {
+        if (c == '"' || c == '\\')
+            out.append('\\').append(c);
+        else if (uchar(c) < 0x20)
+            out.append("\\u00").append(QByteArray::number(uchar(c), 16).rightJustified(2, '0'));
+        else
+            out.append(c);
+    }
+    out.append('"');
+    return out;
+}
+}
+
+void Trace::start(const QString& filePath)
+{
+    TraceState& s = state();
+    {
+        QMutexLocker lock(&s.mutex);
+        if (!s.clock.isValid())
+            s.clock.start();
+        s.filePath = filePath;
+        s.events.reserve(4096);
+    }
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+qint64 Trace::now()
+{
+    TraceState& s = state();
+    return s.clock.isValid() ? s.clock.nsecsElapsed() : 0;
+}
+
+void Trace::complete(const char* name, qint64 startNs, qint64 endNs)
+{
+    if (!isEnabled())
+        return;
+    const int tid = currentTid();
+    TraceState& s = state();
+    QMutexLocker lock(&s.mutex);
+    if (s.events.size() >= kMaxEvents) {
+        s.dropped = true;
+        return;
+    }
+    s.events.append({name, startNs, qMax<qint64>(0, endNs - startNs), tid});
+}
+
+bool Trace::finish()
+{
+    if (!isEnabled())
+        return true;
+    s_enabled.store(false, std::memory_order_relaxed);
+
+    TraceState& s = state();
+    QMutexLocker lock(&s.mutex);
+    QSaveFile file(s.filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        qWarning("Could not write trace file %s", qPrintable(s.filePath));
+        return false;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray out;
+    out.reserve(256 + s.events.size() * 96);
+    out.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    out.append("{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":").append(pid)
+       .append(",\"tid\":0,\"args\":{\"name\":\"QtPdfView\"}}");
+    for (const TraceThread& thread : std::as_const(s.threads)) {
+        out.append(",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":").append(pid)
+           .append(",\"tid\":").append(QByteArray::number(thread.tid))
+           .append(",\"args\":{\"name\":").append(jsonString(thread.name)).append("}}");
+    }
+    for (const TraceEvent& event : std::as_const(s.events)) {
+        // Timestamps are in microseconds; keep sub-microsecond precision
+        out.append(",\n{\"name\":").append(jsonString(QString::fromLatin1(event.name)))
+           .append(",\"cat\":\"qtpdfview\",\"ph\":\"X\",\"ts\":")
+           .append(QByteArray::number(double(event.startNs) / 1e3, 'f', 3))
+           .append(",\"dur\":").append(QByteArray::number(double(event.durationNs) / 1e3, 'f', 3))
+           .append(",\"pid\":").append(pid)
+           .append(",\"tid\":").append(QByteArray::number(event.tid)).append('}');
+        if (out.size() > (1 << 20)) {
+            file.write(out);
+            out.clear();
+        }
+    }
+    out.append("\n]}\n");
+    file.write(out);
+    if (s.dropped)
+        qWarning("Trace buffer full: only the first %d spans were written", kMaxEvents);
+    s.events.clear();
+    return file.commit();
+}
@@ -0,0 +1,105 @@
+/**
+ * @file Trace.h
+ * @brief Scoped tracing spans exported as Chrome trace-event JSON.
+ *
+ * Spans mark where time goes on documents that cannot be shared: the
+ * trace file only contains span names, thread ids and timestamps. The
+ * output loads in Perfetto (ui.perfetto.dev) and chrome://tracing.
+ *
+ * Tracing is enabled with --trace <file> or the QTPDFVIEW_TRACE=<file>
+ * environment variable. When it is off, a span costs one relaxed atomic
+ * load; when it is on, finished spans are appended to a mutex-protected
+ * buffer (capped at kMaxEvents) and written by Trace::finish().
+ *
+ * Usage:
+ * @code
+ *   Trace::start("trace.json");
+ *   ...
+ *   void MainWindow::updateThumbnails()
+ *   {
+ *       TRACE_SCOPE("updateThumbnails");
+ *       ...
+ *   }
+ *   ...
+ *   Trace::finish();  // writes the file
+ * @endcode
+ */
+
+#pragma once
+
+#include <QString>
+#include <atomic>
+
+/**
+ * @class Trace
+ * @brief Process-wide recorder of complete ("X") trace events.
+ */
+class Trace {
+public:
+    static constexpr int kMaxEvents = 1000000;
+
+    /**
+     * @brief Starts recording; events are written to @p filePath on finish().
+     */
+    static void start(const QString& filePath);
+
+    /**
+     * @brief Stops recording and writes the trace file.
+     * @return False if the file could not be written
+     */
+    static bool finish();
+
+    /**
+     * @brief Returns true while recording.
+     */
+    static bool isEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Monotonic timestamp in nanoseconds, for spans recorded with complete().
+     */
+    static qint64 now();
+
+    /**
+     * @brief Records a span that started and ended at the given times.
+     * @param name Static span name
+     * @param startNs Start from now()
+     * @param endNs End from now()
+     */
+    static void complete(const char* name, qint64 startNs, qint64 endNs);
+
+private:
+    static std::atomic_bool s_enabled;
+};
+
+/**
+ * @class TraceSpan
+ * @brief Records a span from construction to destruction when tracing is on.
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name)
+    {
+        if (Trace::isEnabled()) {
+            m_name = name;
+            m_startNs = Trace::now();
+        }
+    }
+
+    ~TraceSpan()
+    {
+        if (m_name)
+            Trace::complete(m_name, m_startNs, Trace::now());
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name {nullptr};
+    qint64 m_startNs {0};
+};
+
+#define TRACE_SCOPE_CONCAT_INNER(a, b) a##b
+#define TRACE_SCOPE_CONCAT(a, b) TRACE_SCOPE_CONCAT_INNER(a, b)
+/// Traces the enclosing scope under @p name (a string literal).
+#define TRACE_SCOPE(name) TraceSpan TRACE_SCOPE_CONCAT(traceSpan_, __LINE__)(name)
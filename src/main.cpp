@@ -8,44 +8,266 @@
  * - Application initialization
  *
  * Usage:
- *   QtPdfView.exe [pdf_path] [original_file_path]
+ *   QtPdfView.exe [options] [pdf_path] [original_file_path]
  *
  * Arguments:
- *   pdf_path           - Path to PDF file to display
+ *   pdf_path           - Path or http(s) URL of the PDF to display (default: last session)
  *   original_file_path - Optional path to original file (for "Open" button)
+ *
+ * Options:
+ *   --startup-timeline - Print startup phase timings to stderr
+ *   --page <n>         - Go to page n (1-based)
+ *   --zoom <mode>      - "width", "page" or a zoom factor
+ *   --search <text>    - Search for text
+ *   --terms <a;b;c>    - Multi-term search shown on the minimap
+ *   --reply            - Print the running instance's JSON reply to stdout
+ *   --memory-report    - Print the memory report once the file is open and exit
+ *                        (JSON reply when forwarded to a running instance)
+ *   --trace <file>     - Write Chrome trace-event JSON on exit
+ *                        (also: QTPDFVIEW_TRACE=<file>)
+ *   --export-text <file> - Write the text of pdf_path to <file> (UTF-8, one
+ *                        form feed per page), extracting on all cores, and
+ *                        exit without a window
+ *   --render <dir>     - Render pages of pdf_path to image files in <dir> on
+ *                        all cores and exit; runs on the offscreen platform
+ *   --dpi <n>          - Resolution for --render (default 150)
+ *   --pages <ranges>   - Pages for --render, e.g. "1-500" or "1,3,10-" (default all)
+ *   --format <fmt>     - png or jpg for --render (default png)
+ *   --quality <n>      - Encoder quality 0-100 for --render
+ *   --search-batch     - Search every PDF given (files or folders) for --terms
+ *                        and/or --terms-file without a window; prints one JSON
+ *                        object per file (JSON Lines) to stdout or --output
+ *   --terms-file <file> - Terms for --search-batch, one per line
+ *   --output <file>    - Write --search-batch results to <file>
+ *   --whole-word, --regex - Matching options for --search-batch
+ *
+ * If an instance is already running, the file and options are forwarded to
+ * it as one command batch (see InstanceServer.h) and this process exits.
  */
 
+#include "BatchRenderer.h"
+#include "BatchSearch.h"
+#include "HttpRangeReply.h"
 #include "MainWindow.h"
+#include "InstanceServer.h"
+#include "SessionStore.h"
+#include "StartupTimeline.h"
+#include "TextExporter.h"
+#include "Trace.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QString>
-#include <QLocalServer>
-#include <QLocalSocket>
-#include <QDataStream>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPdfDocument>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+/// Batch modes need no display; checked before QApplication picks a platform
+bool isHeadlessRun(int argc, char* argv[])
+{
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--render") == 0 || std::strncmp(argv[i], "--render=", 9) == 0
+            || std::strcmp(argv[i], "--search-batch") == 0
+            || std::strcmp(argv[i], "--export-text") == 0 || std::strncmp(argv[i], "--export-text=", 14) == 0)
+            return true;
+    }
+    return false;
+}
+}
 
 int main(int argc, char *argv[])
 {
+    StartupTimeline::start();
+    if (isHeadlessRun(argc, argv) && !qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
     QApplication app(argc, argv);
+    StartupTimeline::mark("QApplication");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("QtPdfView - a minimal, fast PDF viewer"));
+    parser.addHelpOption();
+    const QCommandLineOption timelineOption(QStringLiteral("startup-timeline"),
+        QCoreApplication::translate("main", "Print startup phase timings to stderr."));
+    parser.addOption(timelineOption);
+    const QCommandLineOption pageOption(QStringLiteral("page"),
+        QCoreApplication::translate("main", "Go to page <n> (1-based)."), QStringLiteral("n"));
+    const QCommandLineOption zoomOption(QStringLiteral("zoom"),
+        QCoreApplication::translate("main", "Zoom: width, page or a factor."), QStringLiteral("mode"));
+    const QCommandLineOption searchOption(QStringLiteral("search"),
+        QCoreApplication::translate("main", "Search for <text>."), QStringLiteral("text"));
+    const QCommandLineOption termsOption(QStringLiteral("terms"),
+        QCoreApplication::translate("main", "Multi-term search, separated by semicolons."), QStringLiteral("terms"));
+    const QCommandLineOption replyOption(QStringLiteral("reply"),
+        QCoreApplication::translate("main", "Print the running instance's reply as JSON."));
+    const QCommandLineOption traceOption(QStringLiteral("trace"),
+        QCoreApplication::translate("main", "Write Chrome trace-event JSON to <file> on exit."), QStringLiteral("file"));
+    const QCommandLineOption memoryOption(QStringLiteral("memory-report"),
+        QCoreApplication::translate("main", "Print the memory report once the file is open and exit."));
+    const QCommandLineOption exportTextOption(QStringLiteral("export-text"),
+        QCoreApplication::translate("main", "Write the document's text to <file> and exit."), QStringLiteral("file"));
+    const QCommandLineOption renderOption(QStringLiteral("render"),
+        QCoreApplication::translate("main", "Render pages to image files in <dir> and exit."), QStringLiteral("dir"));
+    const QCommandLineOption dpiOption(QStringLiteral("dpi"),
+        QCoreApplication::translate("main", "Resolution for --render."), QStringLiteral("n"), QStringLiteral("150"));
+    const QCommandLineOption pagesOption(QStringLiteral("pages"),
+        QCoreApplication::translate("main", "Pages for --render, e.g. 1-5,8,10-."), QStringLiteral("ranges"));
+    const QCommandLineOption formatOption(QStringLiteral("format"),
+        QCoreApplication::translate("main", "Image format for --render: png or jpg."), QStringLiteral("fmt"),
+        QStringLiteral("png"));
+    const QCommandLineOption qualityOption(QStringLiteral("quality"),
+        QCoreApplication::translate("main", "Encoder quality 0-100 for --render."), QStringLiteral("n"));
+    const QCommandLineOption searchBatchOption(QStringLiteral("search-batch"),
+        QCoreApplication::translate("main", "Search the given PDFs or folders for --terms/--terms-file, print JSON and exit."));
+    const QCommandLineOption termsFileOption(QStringLiteral("terms-file"),
+        QCoreApplication::translate("main", "Terms for --search-batch, one per line."), QStringLiteral("file"));
+    const QCommandLineOption outputOption(QStringLiteral("output"),
+        QCoreApplication::translate("main", "Write --search-batch results to <file>."), QStringLiteral("file"));
+    const QCommandLineOption wholeWordOption(QStringLiteral("whole-word"),
+        QCoreApplication::translate("main", "Match whole words only (--search-batch)."));
+    const QCommandLineOption regexOption(QStringLiteral("regex"),
+        QCoreApplication::translate("main", "Terms are regular expressions (--search-batch)."));
+    parser.addOptions({pageOption, zoomOption, searchOption, termsOption, replyOption, traceOption, memoryOption,
+                       exportTextOption, renderOption, dpiOption, pagesOption, formatOption, qualityOption,
+                       searchBatchOption, termsFileOption, outputOption, wholeWordOption, regexOption});
+    parser.addPositionalArgument(QStringLiteral("pdf_path"),
+        QCoreApplication::translate("main", "PDF file or http(s) URL to display."), QStringLiteral("[pdf_path]"));
+    parser.addPositionalArgument(QStringLiteral("original_file_path"),
+        QCoreApplication::translate("main", "Original file (for title and \"Open\" button)."),
+        QStringLiteral("[original_file_path]"));
+    parser.process(app);
+    StartupTimeline::setPrintEnabled(parser.isSet(timelineOption));
+    const QString traceFile = parser.isSet(traceOption) ? parser.value(traceOption)
+                                                        : qEnvironmentVariable("QTPDFVIEW_TRACE");
+    if (!traceFile.isEmpty())
+        Trace::start(traceFile);
 
-    // Command line arguments:
-    // args[1] = PDF file (to be displayed)
-    // args[2] = Original file (optional - for title and "Open" button)
+    // Batch search: every positional argument is a PDF or a folder of PDFs
+    if (parser.isSet(searchBatchOption)) {
+        BatchSearch::Options options;
+        if (parser.isSet(termsOption))
+            options.terms = BatchSearch::parseTerms(parser.value(termsOption));
+        QString error;
+        if (parser.isSet(termsFileOption) && !BatchSearch::readTermsFile(parser.value(termsFileOption), &options.terms, &error)) {
+            std::fprintf(stderr, "%s\n", qPrintable(error));
+            return 2;
+        }
+        if (parser.isSet(wholeWordOption))
+            options.matchOptions |= TextMatcher::WholeWord;
+        if (parser.isSet(regexOption))
+            options.matchOptions |= TextMatcher::Regex;
+        const QStringList files = BatchSearch::expandPaths(parser.positionalArguments());
+        if (files.isEmpty() || options.terms.isEmpty()) {
+            std::fprintf(stderr, "--search-batch needs PDF files and --terms or --terms-file\n");
+            return 2;
+        }
+
+        QFile out;
+        const bool toFile = parser.isSet(outputOption);
+        if (toFile)
+            out.setFileName(parser.value(outputOption));
+        if (toFile ? !out.open(QIODevice::WriteOnly | QIODevice::Truncate) : !out.open(stdout, QIODevice::WriteOnly)) {
+            std::fprintf(stderr, "Cannot write %s: %s\n", qPrintable(out.fileName()), qPrintable(out.errorString()));
+            return 1;
+        }
+        // One line per file, written as files finish
+        const BatchSearch::Result r = BatchSearch::run(files, options, [&out, &options](const BatchSearch::FileResult& f){
+            out.write(QJsonDocument(BatchSearch::toJson(f, options.terms)).toJson(QJsonDocument::Compact));
+            out.write("\n");
+            out.flush();
+        });
+        out.close();
+        if (!r.ok)
+            std::fprintf(stderr, "%s\n", qPrintable(r.errorString));
+        else
+            std::fprintf(stderr, "%d files (%d unreadable), %lld pages, %lld hits in %lld ms (%.0f pages/s, %d threads)\n",
+                         r.files, r.failedFiles, static_cast<long long>(r.pages), static_cast<long long>(r.hits),
+                         static_cast<long long>(r.elapsedMs), r.pagesPerSecond(), r.threads);
+        Trace::finish();
+        return r.ok && r.failedFiles == 0 ? 0 : 1;
+    }
+
+    // Positional arguments:
+    // args[0] = PDF file (to be displayed)
+    // args[1] = Original file (optional - for title and "Open" button)
     QString selectedPdf;
     QString originalFile;
-    const QStringList args = QCoreApplication::arguments();
-    if (args.size() > 1) {
-        QFileInfo fi(args.at(1));
-        if (fi.exists() && fi.isFile())
+    const QStringList args = parser.positionalArguments();
+    if (args.size() > 0) {
+        QFileInfo fi(args.at(0));
+        // http(s) URLs are opened as is (see HttpRangeReply)
+        if (HttpRangeReply::isHttpUrl(args.at(0)))
+            selectedPdf = args.at(0);
+        else if (fi.exists() && fi.isFile())
             selectedPdf = fi.absoluteFilePath();
     }
-    if (args.size() > 2) {
-        QFileInfo fi(args.at(2));
+    const bool remotePdf = HttpRangeReply::isHttpUrl(selectedPdf);
+    if (args.size() > 1) {
+        QFileInfo fi(args.at(1));
         if (fi.exists() && fi.isFile())
             originalFile = fi.absoluteFilePath();
     }
 
+    // Batch text export: no window, no single-instance forwarding
+    if (parser.isSet(exportTextOption)) {
+        if (selectedPdf.isEmpty() || remotePdf) {
+            std::fprintf(stderr, remotePdf ? "--export-text needs a local PDF file, not a URL\n"
+                                           : "--export-text needs a PDF file\n");
+            return 2;
+        }
+        const TextExporter::Result r = TextExporter::exportText(selectedPdf, parser.value(exportTextOption));
+        if (!r.ok)
+            std::fprintf(stderr, "%s\n", qPrintable(r.errorString));
+        else
+            std::fprintf(stderr, "%d pages, %lld bytes in %lld ms (%.0f pages/s)\n", r.pages,
+                         static_cast<long long>(r.bytes), static_cast<long long>(r.elapsedMs),
+                         r.pagesPerSecond());
+        Trace::finish();
+        return r.ok ? 0 : 1;
+    }
+
+    // Batch rendering: no window, no single-instance forwarding
+    if (parser.isSet(renderOption)) {
+        if (selectedPdf.isEmpty() || remotePdf) {
+            std::fprintf(stderr, remotePdf ? "--render needs a local PDF file, not a URL\n"
+                                           : "--render needs a PDF file\n");
+            return 2;
+        }
+        BatchRenderer::Options options;
+        options.outputDir = parser.value(renderOption);
+        options.dpi = parser.value(dpiOption).toDouble();
+        options.format = parser.value(formatOption).toLatin1();
+        if (parser.isSet(qualityOption))
+            options.quality = qBound(0, parser.value(qualityOption).toInt(), 100);
+        if (parser.isSet(pagesOption)) {
+            QPdfDocument probe;
+            if (probe.load(selectedPdf) != QPdfDocument::Error::None) {
+                std::fprintf(stderr, "Cannot read %s\n", qPrintable(selectedPdf));
+                return 1;
+            }
+            if (!BatchRenderer::parsePageRanges(parser.value(pagesOption), probe.pageCount(), &options.pages)) {
+                std::fprintf(stderr, "Invalid page ranges: %s\n", qPrintable(parser.value(pagesOption)));
+                return 2;
+            }
+        }
+        const BatchRenderer::Result r = BatchRenderer::render(selectedPdf, options);
+        if (!r.ok)
+            std::fprintf(stderr, "%s\n", qPrintable(r.errorString));
+        const QString peak = r.peakResidentBytes >= 0
+            ? QString::number(double(r.peakResidentBytes) / (1024.0 * 1024.0), 'f', 1) + QStringLiteral(" MB")
+            : QStringLiteral("n/a");
+        std::fprintf(stderr, "%d pages in %lld ms (%.1f pages/s, %d threads), peak memory %s\n", r.pages,
+                     static_cast<long long>(r.elapsedMs), r.pagesPerSecond(), r.threads, qPrintable(peak));
+        Trace::finish();
+        return r.ok ? 0 : 1;
+    }
+
     // Use license.pdf if no argument provided (quick check)
     if (selectedPdf.isEmpty()) {
         const QString defaultPdf = QDir::current().filePath(QStringLiteral("license.pdf"));
@@ -62,53 +284,92 @@ int main(int argc, char *argv[])
         }
     }
 
+    // Commands applied after the file is open (locally or by a running instance)
+    QJsonArray viewCommands;
+    if (parser.isSet(pageOption))
+        viewCommands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("goto")},
+                                        {QStringLiteral("page"), parser.value(pageOption).toInt()}});
+    if (parser.isSet(zoomOption))
+        viewCommands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("zoom")},
+                                        {QStringLiteral("mode"), parser.value(zoomOption)}});
+    if (parser.isSet(searchOption))
+        viewCommands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("search")},
+                                        {QStringLiteral("text"), parser.value(searchOption)}});
+    if (parser.isSet(termsOption))
+        viewCommands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("multisearch")},
+                                        {QStringLiteral("terms"), parser.value(termsOption)}});
+    const bool memoryReport = parser.isSet(memoryOption);
+    if (memoryReport)
+        viewCommands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("memory")}});
+
     // Single instance: try to connect to existing instance, forward request and exit if successful
     const QString serverName = QStringLiteral("QtPdfView_SingleInstance");
     {
-        QLocalSocket probe;
-        probe.connectToServer(serverName, QIODevice::WriteOnly);
-        if (probe.waitForConnected(150)) {
-            // Forward file path to existing instance (or just activate if empty)
-            QByteArray payload;
-            QDataStream out(&payload, QIODevice::WriteOnly);
-            out.setVersion(QDataStream::Qt_6_2);
-            out << selectedPdf; // can be empty -> just bring to front
-            probe.write(payload);
-            probe.flush();
-            probe.waitForBytesWritten(150);
-            return 0;
+        QJsonArray commands;
+        QJsonObject open{{QStringLiteral("cmd"), QStringLiteral("open")},
+                         {QStringLiteral("path"), selectedPdf}};
+        if (!originalFile.isEmpty())
+            open.insert(QStringLiteral("original"), originalFile);
+        commands.append(open);
+        for (const QJsonValue& command : std::as_const(viewCommands))
+            commands.append(command);
+        commands.append(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("activate")}});
+
+        // Only wait for the batch to run when its result is printed
+        const bool wantReply = parser.isSet(replyOption) || memoryReport;
+        QJsonObject reply;
+        if (InstanceServer::sendToRunningInstance(serverName, commands, 10000, wantReply ? &reply : nullptr)) {
+            if (!wantReply)
+                return 0;
+            const QByteArray json = QJsonDocument(reply).toJson(QJsonDocument::Compact);
+            std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+            std::fputc('\n', stdout);
+            return reply.value(QStringLiteral("ok")).toBool(true) ? 0 : 1;
         }
     }
+    StartupTimeline::mark("single-instance probe");
 
-    // Start server (remove old remnant if exists)
-    QLocalServer::removeServer(serverName);
-    QLocalServer* server = new QLocalServer(&app);
-    server->listen(serverName);
+    // Without a file argument, reopen the last session where it was left
+    const SessionState session = SessionStore().loadSession();
+    if (args.isEmpty() && session.isValid() && QFileInfo::exists(session.filePath)) {
+        selectedPdf = QFileInfo(session.filePath).absoluteFilePath();
+        if (originalFile.isEmpty() && QFileInfo::exists(session.originalPath))
+            originalFile = session.originalPath;
+    }
 
     MainWindow w;
     w.resize(1000, 800);
+    StartupTimeline::mark("MainWindow constructed");
+
+    // Listen for command batches from second instances and scripts
+    InstanceServer server(&w);
+    server.listen(serverName);
+    StartupTimeline::mark("single-instance server");
 
     w.openPdf(selectedPdf);
     if (!originalFile.isEmpty())
         w.setOriginalFile(originalFile);
+    if (session.isValid() && QFileInfo(session.filePath).absoluteFilePath() == selectedPdf)
+        w.restoreSession(session);
+    StartupTimeline::mark("openPdf");
     w.show();
+    StartupTimeline::mark("window shown");
 
-    // Listen for "open file" / "activate" requests from second instances
-    QObject::connect(server, &QLocalServer::newConnection, &app, [&w, server](){
-        while (QLocalSocket* client = server->nextPendingConnection()) {
-            QObject::connect(client, &QLocalSocket::readyRead, client, [client, &w]{
-                QDataStream in(client);
-                in.setVersion(QDataStream::Qt_6_2);
-                QString path;
-                in >> path;
-                if (!path.isEmpty())
-                    w.openPdf(path);
-                w.raiseAndActivate();
-                client->disconnectFromServer();
-            });
-            QObject::connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
-        }
-    });
+    // Page/zoom/search options wait for the document to finish loading
+    if (!viewCommands.isEmpty()) {
+        viewCommands.prepend(QJsonObject{{QStringLiteral("cmd"), QStringLiteral("open")},
+                                         {QStringLiteral("path"), selectedPdf}});
+        server.execute(viewCommands, [&w, memoryReport](const QJsonObject&){
+            if (!memoryReport)
+                return;
+            const QByteArray text = w.memoryReport().format().toLocal8Bit();
+            std::fwrite(text.constData(), 1, size_t(text.size()), stdout);
+            std::fflush(stdout);
+            QCoreApplication::quit();
+        });
+    }
 
-    return app.exec();
+    const int rc = app.exec();
+    Trace::finish();
+    return rc;
 }
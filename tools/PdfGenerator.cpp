@@ -0,0 +1,302 @@
+/**
+ * @file PdfGenerator.cpp
+ * @brief Generates deterministic synthetic PDFs for scaling and search tests.
+ *
+ * The generator writes a PDF with QPdfWriter and a JSON manifest that lists,
+ * for every keyword, how often it occurs in total and on which pages, and
+ * where each inserted copy is. The counts are taken from the exact text
+ * drawn on each page with the rule of the search box: a plain TextMatcher
+ * query over FoldedText (case and diacritics folded, whitespace collapsed,
+ * non-overlapping matches), so search results can be compared against them.
+ * They include matches inside other words, which the insertion list does
+ * not.
+ *
+ * Insertions are listed as [page, line, offset]: the 1-based page, the
+ * 1-based text line below the page header, and the 0-based character
+ * offset of the keyword in that line.
+ *
+ * Usage:
+ * @code
+ *   QtPdfView_pdfgen [options] output.pdf
+ *
+ *   --pages <n>          Page count, 1..20000 (default 200)
+ *   --seed <n>           Random seed (default 1)
+ *   --mixed-sizes        Cycle through A4, Letter, A3, A5, Legal and landscape A4
+ *   --lines <n>          Text lines per page, capped by page height (default 45)
+ *   --words <n>          Words per line (default 12)
+ *   --keywords <a,b,c>   Keywords to insert (default "alpha,invoice,zeta")
+ *   --keyword-rate <r>   Average insertions per keyword and page (default 2)
+ *   --image-every <n>    Make every n-th page an image page (default 0, none)
+ *   --manifest <file>    Manifest path (default: output with .json suffix)
+ * @endcode
+ *
+ * The same options and seed always produce the same text, keyword positions
+ * and images.
+ */
+
+#include <QCommandLineParser>
+#include <QFile>
+#include <QFileInfo>
+#include <QFont>
+#include <QGuiApplication>
+#include <QImage>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPageSize>
+#include <QPainter>
+#include <QPdfWriter>
+#include <QRandomGenerator>
+#include <QVector>
+#include <cstdio>
+
+#include "TextSearch.h"
+
+namespace {
+constexpr int kMaxPages = 20000;
+constexpr qreal kMargin = 48.0;
+constexpr qreal kLineHeight = 14.0;
+
+// Filler vocabulary; keywords are counted in the final text, so overlaps
+// with these words are still reflected correctly in the manifest.
+const char* const kFiller[] = {
+    "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing",
+    "elit", "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore",
+    "et", "dolore", "magna", "aliqua", "enim", "minim", "veniam", "quis",
+    "nostrud", "exercitation", "ullamco", "laboris", "nisi", "aliquip",
+    "commodo", "consequat", "duis", "aute", "irure", "reprehenderit"
+};
+
+struct PageFormat {
+    QPageSize::PageSizeId id;
+    QPageLayout::Orientation orientation;
+};
+
+const PageFormat kFormats[] = {
+    {QPageSize::A4, QPageLayout::Portrait},
+    {QPageSize::Letter, QPageLayout::Portrait},
+    {QPageSize::A3, QPageLayout::Portrait},
+    {QPageSize::A5, QPageLayout::Portrait},
+    {QPageSize::Legal, QPageLayout::Portrait},
+    {QPageSize::A4, QPageLayout::Landscape},
+};
+
+struct Options {
+    QString output;
+    QString manifest;
+    int pages {200};
+    quint32 seed {1};
+    bool mixedSizes {false};
+    int lines {45};
+    int words {12};
+    QStringList keywords;
+    double keywordRate {2.0};
+    int imageEvery {0};
+};
+
+QImage makePageImage(QRandomGenerator& rng, const QSize& size)
+{
+    // Smooth gradient plus noise blocks: large, not trivially compressible
+    QImage image(size, QImage::Format_RGB32);
+    const int r0 = rng.bounded(256);
+    const int g0 = rng.bounded(256);
+    const int b0 = rng.bounded(256);
+    for (int y = 0; y < size.height(); ++y) {
+        auto* line = reinterpret_cast<QRgb*>(image.scanLine(y));
+        for (int x = 0; x < size.width(); ++x)
+            line[x] = qRgb((r0 + x) & 0xff, (g0 + y) & 0xff, (b0 + x + y) & 0xff);
+    }
+    QPainter p(&image);
+    for (int i = 0; i < 64; ++i) {
+        p.fillRect(rng.bounded(size.width()), rng.bounded(size.height()),
+                   8 + rng.bounded(96), 8 + rng.bounded(96),
+                   QColor(rng.bounded(256), rng.bounded(256), rng.bounded(256)));
+    }
+    return image;
+}
+
+bool generate(const Options& opt)
+{
+    QPdfWriter writer(opt.output);
+    writer.setResolution(72);  // Painter units are PDF points
+    writer.setCreator(QStringLiteral("QtPdfView_pdfgen"));
+    writer.setTitle(QStringLiteral("Synthetic document (%1 pages, seed %2)").arg(opt.pages).arg(opt.seed));
+
+    auto formatFor = [&opt](int page) -> const PageFormat& {
+        const int formatCount = int(sizeof(kFormats) / sizeof(kFormats[0]));
+        return opt.mixedSizes ? kFormats[page % formatCount] : kFormats[0];
+    };
+    auto applyFormat = [&writer](const PageFormat& format) {
+        writer.setPageLayout(QPageLayout(QPageSize(format.id), format.orientation, QMarginsF()));
+    };
+    applyFormat(formatFor(0));
+
+    QPainter painter;
+    if (!painter.begin(&writer)) {
+        std::fprintf(stderr, "Could not write %s\n", qPrintable(opt.output));
+        return false;
+    }
+    QFont font(QStringLiteral("Sans Serif"));
+    font.setPixelSize(10);
+    painter.setFont(font);
+
+    QRandomGenerator rng(opt.seed);
+    const int fillerCount = int(sizeof(kFiller) / sizeof(kFiller[0]));
+    QVector<TextMatcher> matchers;
+    for (const QString& keyword : opt.keywords)
+        matchers.append(TextMatcher(keyword));
+    QVector<int> totals(opt.keywords.size(), 0);
+    QVector<QJsonArray> pageHits(opt.keywords.size());
+    QVector<QJsonArray> insertions(opt.keywords.size());
+    QJsonArray pageSizes;
+    QJsonArray imagePages;
+
+    for (int page = 0; page < opt.pages; ++page) {
+        const PageFormat& format = formatFor(page);
+        if (page > 0) {
+            applyFormat(format);
+            writer.newPage();
+        }
+        const QSizeF size = writer.pageLayout().fullRect(QPageLayout::Point).size();
+        pageSizes.append(QJsonArray{size.width(), size.height()});
+
+        // Page header, so every page has some text
+        QString pageText = QStringLiteral("Page %1 of %2").arg(page + 1).arg(opt.pages);
+        painter.drawText(QPointF(kMargin, kMargin - 16), pageText);
+
+        const bool imagePage = opt.imageEvery > 0 && (page + 1) % opt.imageEvery == 0;
+        if (imagePage) {
+            imagePages.append(page + 1);
+            const QRectF target(kMargin, kMargin, size.width() - 2 * kMargin, size.height() - 2 * kMargin);
+            painter.drawImage(target, makePageImage(rng, QSize(800, 1000)));
+        } else {
+            const int maxLines = qMax(1, int((size.height() - 2 * kMargin) / kLineHeight));
+            const int lineCount = qMin(opt.lines, maxLines);
+            QVector<QStringList> lines(lineCount);
+            QVector<QVector<int>> lineKeywords(lineCount);   // Keyword index per word, -1 for filler
+            for (int l = 0; l < lineCount; ++l) {
+                lines[l].reserve(opt.words + 4);
+                for (int w = 0; w < opt.words; ++w)
+                    lines[l] << QLatin1String(kFiller[rng.bounded(fillerCount)]);
+                lineKeywords[l].fill(-1, opt.words);
+            }
+            // Keywords replace random words: floor(rate) per page plus one
+            // more with probability frac(rate). A later keyword can replace
+            // an earlier one; only the word left in place is listed.
+            for (int k = 0; k < opt.keywords.size(); ++k) {
+                int n = int(opt.keywordRate);
+                if (rng.generateDouble() < opt.keywordRate - n)
+                    ++n;
+                for (int i = 0; i < n && lineCount > 0; ++i) {
+                    const int l = rng.bounded(lineCount);
+                    const int w = rng.bounded(int(lines.at(l).size()));
+                    lines[l][w] = opt.keywords.at(k);
+                    lineKeywords[l][w] = k;
+                }
+            }
+            for (int l = 0; l < lineCount; ++l) {
+                const QString text = lines.at(l).join(QLatin1Char(' '));
+                painter.drawText(QPointF(kMargin, kMargin + (l + 1) * kLineHeight), text);
+                pageText += QLatin1Char('\n') + text;
+
+                int offset = 0;
+                for (int w = 0; w < lines.at(l).size(); ++w) {
+                    const int k = lineKeywords.at(l).at(w);
+                    if (k >= 0)
+                        insertions[k].append(QJsonArray{page + 1, l + 1, offset});
+                    offset += int(lines.at(l).at(w).size()) + 1;
+                }
+            }
+        }
+
+        const FoldedText folded = FoldedText::fold(pageText);
+        for (int k = 0; k < opt.keywords.size(); ++k) {
+            const int hits = int(matchers.at(k).findAll(folded).size());
+            if (hits > 0) {
+                totals[k] += hits;
+                pageHits[k].append(QJsonArray{page + 1, hits});
+            }
+        }
+        if ((page + 1) % 1000 == 0)
+            std::fprintf(stderr, "%d/%d pages\n", page + 1, opt.pages);
+    }
+    if (!painter.end())
+        return false;
+
+    QJsonObject keywords;
+    for (int k = 0; k < opt.keywords.size(); ++k) {
+        keywords.insert(opt.keywords.at(k), QJsonObject{{QStringLiteral("total"), totals.at(k)},
+                                                        {QStringLiteral("pages"), pageHits.at(k)},
+                                                        {QStringLiteral("insertions"), insertions.at(k)}});
+    }
+    const QJsonObject manifest{
+        {QStringLiteral("file"), QFileInfo(opt.output).fileName()},
+        {QStringLiteral("pages"), opt.pages},
+        {QStringLiteral("seed"), qint64(opt.seed)},
+        {QStringLiteral("linesPerPage"), opt.lines},
+        {QStringLiteral("wordsPerLine"), opt.words},
+        {QStringLiteral("keywordRate"), opt.keywordRate},
+        {QStringLiteral("matchRule"), QStringLiteral("folded text (case, diacritics, whitespace), plain query, non-overlapping")},
+        {QStringLiteral("insertionFormat"), QStringLiteral("[page, line below header (1-based), character offset in line]")},
+        {QStringLiteral("keywords"), keywords},
+        {QStringLiteral("imagePages"), imagePages},
+        {QStringLiteral("pageSizes"), pageSizes}};
+    QFile file(opt.manifest);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        std::fprintf(stderr, "Could not write %s\n", qPrintable(opt.manifest));
+        return false;
+    }
+    file.write(QJsonDocument(manifest).toJson());
+    return true;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    // Fonts need a GUI application, but no display
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Generates deterministic synthetic PDFs for QtPdfView tests"));
+    parser.addHelpOption();
+    const QCommandLineOption pagesOption(QStringLiteral("pages"), QStringLiteral("Page count (1-20000)."), QStringLiteral("n"), QStringLiteral("200"));
+    const QCommandLineOption seedOption(QStringLiteral("seed"), QStringLiteral("Random seed."), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption mixedOption(QStringLiteral("mixed-sizes"), QStringLiteral("Mix page sizes and orientations."));
+    const QCommandLineOption linesOption(QStringLiteral("lines"), QStringLiteral("Text lines per page."), QStringLiteral("n"), QStringLiteral("45"));
+    const QCommandLineOption wordsOption(QStringLiteral("words"), QStringLiteral("Words per line."), QStringLiteral("n"), QStringLiteral("12"));
+    const QCommandLineOption keywordsOption(QStringLiteral("keywords"), QStringLiteral("Comma-separated keywords."), QStringLiteral("list"), QStringLiteral("alpha,invoice,zeta"));
+    const QCommandLineOption rateOption(QStringLiteral("keyword-rate"), QStringLiteral("Average insertions per keyword and page."), QStringLiteral("r"), QStringLiteral("2"));
+    const QCommandLineOption imageOption(QStringLiteral("image-every"), QStringLiteral("Every n-th page is an image page (0: none)."), QStringLiteral("n"), QStringLiteral("0"));
+    const QCommandLineOption manifestOption(QStringLiteral("manifest"), QStringLiteral("Manifest JSON path."), QStringLiteral("file"));
+    parser.addOptions({pagesOption, seedOption, mixedOption, linesOption, wordsOption,
+                       keywordsOption, rateOption, imageOption, manifestOption});
+    parser.addPositionalArgument(QStringLiteral("output"), QStringLiteral("PDF file to write."));
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if (args.size() != 1)
+        parser.showHelp(1);
+
+    Options opt;
+    opt.output = args.first();
+    opt.manifest = parser.isSet(manifestOption)
+        ? parser.value(manifestOption)
+        : QFileInfo(opt.output).path() + QLatin1Char('/') + QFileInfo(opt.output).completeBaseName() + QStringLiteral(".json");
+    opt.pages = parser.value(pagesOption).toInt();
+    opt.seed = parser.value(seedOption).toUInt();
+    opt.mixedSizes = parser.isSet(mixedOption);
+    opt.lines = qMax(0, parser.value(linesOption).toInt());
+    opt.words = qMax(1, parser.value(wordsOption).toInt());
+    opt.keywordRate = qMax(0.0, parser.value(rateOption).toDouble());
+    opt.imageEvery = qMax(0, parser.value(imageOption).toInt());
+    for (const QString& k : parser.value(keywordsOption).split(QLatin1Char(','), Qt::SkipEmptyParts))
+        opt.keywords << k.trimmed();
+
+    if (opt.pages < 1 || opt.pages > kMaxPages) {
+        std::fprintf(stderr, "--pages must be between 1 and %d\n", kMaxPages);
+        return 1;
+    }
+    return generate(opt) ? 0 : 1;
+}
@@ -0,0 +1,258 @@
+/**
+ * @file RangeServer.cpp
+ * @brief Local HTTP file server with range requests for remote loading tests.
+ *
+ * Serves the files below a directory on 127.0.0.1 with the parts of HTTP/1.1
+ * that HttpRangeReply relies on: single byte ranges (status 206 with
+ * Content-Range), ETag and Last-Modified validators and Content-Length.
+ * Bandwidth and latency can be limited to see how soon the first page of a
+ * large document shows, and range support can be switched off to test the
+ * whole-file fallback. Every request is logged to stderr.
+ *
+ * Usage:
+ * @code
+ *   QtPdfView_rangeserver [options] [directory]
+ *
+ *   --port <n>           Port to listen on (default 8080)
+ *   --rate <KiB/s>       Bandwidth limit per connection (default 0, unlimited)
+ *   --latency <ms>       Delay before each response (default 0)
+ *   --no-ranges          Ignore Range headers and always send the whole file
+ * @endcode
+ *
+ * Example:
+ * @code
+ *   QtPdfView_rangeserver --rate 2048 --latency 50 ~/pdfs
+ *   QtPdfView http://127.0.0.1:8080/big.pdf
+ * @endcode
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHostAddress>
+#include <QLocale>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+
+#include <cstdio>
+#include <memory>
+
+namespace {
+constexpr qint64 kMaxBufferedBytes = 1024 * 1024;
+constexpr qint64 kUnlimitedSliceBytes = 256 * 1024;
+constexpr int kThrottleIntervalMs = 100;
+
+struct Options {
+    QString root;
+    qint64 rateKiB {0};
+    int latencyMs {0};
+    bool ranges {true};
+};
+
+void logLine(const QString& line)
+{
+    std::fprintf(stderr, "%s\n", qPrintable(line));
+}
+
+QByteArray httpDate(const QDateTime& time)
+{
+    return QLocale::c().toString(time.toUTC(), QStringLiteral("ddd, dd MMM yyyy hh:mm:ss 'GMT'")).toLatin1();
+}
+
+void sendStatus(QTcpSocket* socket, const QByteArray& status, const QByteArray& extraHeaders = {})
+{
+    socket->write("HTTP/1.1 " + status + "\r\nContent-Length: 0\r\nConnection: close\r\n" + extraHeaders + "\r\n");
+    socket->disconnectFromHost();
+}
+
+/// Parses "bytes=a-b", "bytes=a-" and "bytes=-n"; false if unsatisfiable
+bool parseRange(const QByteArray& value, qint64 size, qint64* first, qint64* last)
+{
+    if (!value.startsWith("bytes=") || value.contains(','))
+        return false;
+    const QByteArray spec = value.mid(6).trimmed();
+    const int dash = spec.indexOf('-');
+    if (dash < 0)
+        return false;
+    bool ok = true;
+    if (dash == 0) {
+        const qint64 suffix = spec.mid(1).toLongLong(&ok);
+        if (!ok || suffix <= 0 || size == 0)
+            return false;
+        *first = qMax<qint64>(0, size - suffix);
+        *last = size - 1;
+        return true;
+    }
+    *first = spec.left(dash).toLongLong(&ok);
+    if (!ok || *first >= size)
+        return false;
+    *last = size - 1;
+    if (dash + 1 < spec.size()) {
+        *last = qMin(size - 1, spec.mid(dash + 1).toLongLong(&ok));
+        if (!ok || *last < *first)
+            return false;
+    }
+    return true;
+}
+
+void streamBody(QTcpSocket* socket, const QString& path, qint64 first, qint64 length, const Options& opt)
+{
+    auto file = std::make_shared<QFile>(path);
+    if (!file->open(QIODevice::ReadOnly) || !file->seek(first)) {
+        socket->disconnectFromHost();
+        return;
+    }
+    auto remaining = std::make_shared<qint64>(length);
+    const qint64 slice = opt.rateKiB > 0 ? qMax<qint64>(1, opt.rateKiB * 1024 * kThrottleIntervalMs / 1000)
+                                         : kUnlimitedSliceBytes;
+    auto* timer = new QTimer(socket);
+    timer->setInterval(opt.rateKiB > 0 ? kThrottleIntervalMs : 0);
+    QObject::connect(timer, &QTimer::timeout, socket, [socket, file, remaining, slice, timer]{
+        if (socket->bytesToWrite() > kMaxBufferedBytes)
+            return;
+        if (*remaining > 0) {
+            const QByteArray data = file->read(qMin(*remaining, slice));
+            if (data.isEmpty()) {
+                *remaining = 0;
+            } else {
+                socket->write(data);
+                *remaining -= data.size();
+            }
+        }
+        if (*remaining <= 0) {
+            timer->stop();
+            socket->disconnectFromHost();
+        }
+    });
+    timer->start();
+}
+
+void respond(QTcpSocket* socket, const QByteArray& request, const Options& opt)
+{
+    const QList<QByteArray> lines = request.left(request.indexOf("\r\n\r\n")).split('\n');
+    const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+    const QByteArray method = requestLine.value(0);
+    const QByteArray target = requestLine.value(1);
+    QByteArray range;
+    for (int i = 1; i < lines.size(); ++i) {
+        const QByteArray line = lines.at(i).trimmed();
+        if (line.toLower().startsWith("range:"))
+            range = line.mid(6).trimmed();
+    }
+
+    if (method != "GET" && method != "HEAD") {
+        logLine(QStringLiteral("%1 %2 -> 405").arg(QString::fromLatin1(method), QString::fromLatin1(target)));
+        sendStatus(socket, "405 Method Not Allowed", "Allow: GET, HEAD\r\n");
+        return;
+    }
+
+    // Resolve below the root only
+    const QString relative = QUrl::fromPercentEncoding(target.left(target.indexOf('?')));
+    const QFileInfo fi(QDir(opt.root).filePath(relative.mid(1)));
+    const QString root = QDir(opt.root).canonicalPath();
+    const QString path = fi.canonicalFilePath();
+    if (!fi.isFile() || path.isEmpty() || !path.startsWith(root + QLatin1Char('/'))) {
+        logLine(QStringLiteral("%1 %2 -> 404").arg(QString::fromLatin1(method), relative));
+        sendStatus(socket, "404 Not Found");
+        return;
+    }
+
+    const qint64 size = fi.size();
+    const QByteArray etag = '"' + QByteArray::number(size, 16) + '-'
+        + QByteArray::number(fi.lastModified().toMSecsSinceEpoch(), 16) + '"';
+    QByteArray headers = "Content-Type: application/pdf\r\nConnection: close\r\nETag: " + etag
+        + "\r\nLast-Modified: " + httpDate(fi.lastModified()) + "\r\n";
+    if (opt.ranges)
+        headers += "Accept-Ranges: bytes\r\n";
+
+    qint64 first = 0;
+    qint64 last = size - 1;
+    QByteArray status = "200 OK";
+    if (opt.ranges && !range.isEmpty()) {
+        if (!parseRange(range, size, &first, &last)) {
+            logLine(QStringLiteral("%1 %2 %3 -> 416").arg(QString::fromLatin1(method), relative, QString::fromLatin1(range)));
+            sendStatus(socket, "416 Range Not Satisfiable", "Content-Range: bytes */" + QByteArray::number(size) + "\r\n");
+            return;
+        }
+        status = "206 Partial Content";
+        headers += "Content-Range: bytes " + QByteArray::number(first) + '-' + QByteArray::number(last)
+            + '/' + QByteArray::number(size) + "\r\n";
+    }
+    const qint64 length = last - first + 1;
+    logLine(QStringLiteral("%1 %2 %3 -> %4, %5 bytes")
+                .arg(QString::fromLatin1(method), relative,
+                     range.isEmpty() ? QStringLiteral("(whole)") : QString::fromLatin1(range),
+                     QString::fromLatin1(status.left(3)))
+                .arg(length));
+
+    socket->write("HTTP/1.1 " + status + "\r\nContent-Length: " + QByteArray::number(length) + "\r\n"
+                  + headers + "\r\n");
+    if (method == "HEAD" || length <= 0) {
+        socket->disconnectFromHost();
+        return;
+    }
+    streamBody(socket, fi.filePath(), first, length, opt);
+}
+
+void serve(QTcpSocket* socket, const Options& opt)
+{
+    // One request per connection
+    auto request = std::make_shared<QByteArray>();
+    QObject::connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    QObject::connect(socket, &QTcpSocket::readyRead, socket, [socket, request, opt]{
+        if (request->contains("\r\n\r\n"))
+            return;
+        *request += socket->readAll();
+        if (!request->contains("\r\n\r\n"))
+            return;
+        if (opt.latencyMs > 0)
+            QTimer::singleShot(opt.latencyMs, socket, [socket, request, opt]{ respond(socket, *request, opt); });
+        else
+            respond(socket, *request, opt);
+    });
+}
+}
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Local HTTP server with range requests for QtPdfView tests"));
+    parser.addHelpOption();
+    const QCommandLineOption portOption(QStringLiteral("port"), QStringLiteral("Port to listen on."), QStringLiteral("n"), QStringLiteral("8080"));
+    const QCommandLineOption rateOption(QStringLiteral("rate"), QStringLiteral("Bandwidth limit per connection in KiB/s (0: unlimited)."), QStringLiteral("KiB/s"), QStringLiteral("0"));
+    const QCommandLineOption latencyOption(QStringLiteral("latency"), QStringLiteral("Delay before each response in milliseconds."), QStringLiteral("ms"), QStringLiteral("0"));
+    const QCommandLineOption noRangesOption(QStringLiteral("no-ranges"), QStringLiteral("Ignore Range headers."));
+    parser.addOptions({portOption, rateOption, latencyOption, noRangesOption});
+    parser.addPositionalArgument(QStringLiteral("directory"), QStringLiteral("Directory to serve (default: current)."));
+    parser.process(app);
+
+    Options opt;
+    opt.root = parser.positionalArguments().value(0, QStringLiteral("."));
+    opt.rateKiB = qMax<qint64>(0, parser.value(rateOption).toLongLong());
+    opt.latencyMs = qMax(0, parser.value(latencyOption).toInt());
+    opt.ranges = !parser.isSet(noRangesOption);
+    if (!QFileInfo(opt.root).isDir()) {
+        logLine(QStringLiteral("Not a directory: %1").arg(opt.root));
+        return 1;
+    }
+
+    QTcpServer server;
+    if (!server.listen(QHostAddress::LocalHost, quint16(parser.value(portOption).toUInt()))) {
+        logLine(QStringLiteral("Cannot listen: %1").arg(server.errorString()));
+        return 1;
+    }
+    QObject::connect(&server, &QTcpServer::newConnection, &server, [&server, opt]{
+        while (QTcpSocket* socket = server.nextPendingConnection())
+            serve(socket, opt);
+    });
+    logLine(QStringLiteral("Serving %1 on http://127.0.0.1:%2/")
+                .arg(QDir(opt.root).absolutePath()).arg(server.serverPort()));
+    return app.exec();
+}